@@ -0,0 +1,134 @@
+#ifndef UDATA_PACKET_SERVICE_BROADCAST_LOG_HPP
+#define UDATA_PACKET_SERVICE_BROADCAST_LOG_HPP
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+namespace UDataPacketServiceAPI::V1
+{
+ class Packet;
+}
+namespace UDataPacketService
+{
+/// @class BroadcastLog "broadcastLog.hpp"
+/// @brief An append-only ring of packets shared by the members of a
+///        subscription group, i.e., the subscribers that selected the same
+///        streams or that subscribed to all streams.  The publisher writes each packet once
+///        regardless of the number of readers and every reader tracks its
+///        position in the log with a single sequence number (a cursor).
+///        A reader's lag is the head less its cursor.  A reader that falls
+///        more than the retained packets behind the head loses the packets
+///        that were overwritten.  The log is bounded in packets and,
+///        optionally, bytes, e.g., by its streams' queue bounds.  The ring
+///        starts at the given capacity and only grows, up to the packet
+///        bound, once it is full.  The ring's slots are charged to the
+///        memory budget.
+/// @copyright Ben Baker (University of Utah) distributed under the
+///            MIT NO AI license.
+class BroadcastLog
+{
+public:
+    /// @brief Constructs the log.
+    /// @param[in] capacity  The initial number of slots in the ring and the
+    ///                      initial packet bound.  This must be positive.
+    /// @throws std::invalid_argument if the capacity is not positive.
+    explicit BroadcastLog(int capacity);
+
+    /// @name Publisher
+    /// @{
+    /// @note The log has a single publisher.  Packets must be appended
+    ///       from one thread at a time.
+
+    /// @brief Appends the packet to the log.
+    /// @param[in,out] packet  The packet to append.  On exit, packet's
+    ///                        behavior is undefined.
+    void append(UDataPacketServiceAPI::V1::Packet &&packet);
+    /// @brief Appends the packet to the log.
+    /// @param[in] packet  The packet to append.
+    void append(const UDataPacketServiceAPI::V1::Packet &packet);
+    /// @brief Appends a packet that may be shared with other logs.  This
+    ///        avoids a copy when one packet is published to many logs.
+    /// @param[in] packet  The packet to append.
+    /// @throws std::invalid_argument if the packet is null.
+    void append(std::shared_ptr<const UDataPacketServiceAPI::V1::Packet> packet);
+    /// @}
+
+    /// @name Readers
+    /// @{
+
+    /// @result The sequence number the next appended packet will receive.
+    ///         A new reader starts its cursor here.
+    [[nodiscard]] uint64_t getHead() const noexcept;
+    /// @brief Reads the packets from the reader's cursor towards the head.
+    /// @param[in,out] cursor  On input, the sequence number of the next
+    ///                        packet the reader wants.  On exit, the
+    ///                        sequence number following the last packet
+    ///                        read.
+    /// @param[in] maximumNumberOfPackets  The maximum number of packets to
+    ///                                    read.
+    /// @param[out] packets    The packets read are appended to this.  The
+    ///                        packets are shared with the log and the
+    ///                        other readers rather than copied.
+    /// @result The number of packets the reader missed because they were
+    ///         overwritten before they could be read.
+    /// @note Each cursor must be used by only one thread at a time.
+    [[nodiscard]] int64_t read(uint64_t &cursor,
+                               int maximumNumberOfPackets,
+                               std::vector<std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>> &packets) const;
+    /// @param[in] cursor  A reader's cursor.
+    /// @result The number of packets the reader has yet to read which are
+    ///         still in the log.
+    [[nodiscard]] int getLag(uint64_t cursor) const noexcept;
+    /// @brief Releases the packets before the given sequence number so
+    ///        their memory is returned before they are overwritten.  A
+    ///        reader whose cursor is behind this loses those packets.
+    /// @param[in] sequence  Typically the smallest cursor of the log's
+    ///                      readers.
+    void trim(uint64_t sequence);
+    /// @}
+
+    /// @name Retention
+    /// @{
+
+    /// @result The number of packets the ring can currently hold.
+    [[nodiscard]] int getCapacity() const noexcept;
+    /// @brief Bounds the number of packets the log retains.  This may be
+    ///        changed while the log is in use in which case the oldest
+    ///        packets beyond the new bound are trimmed immediately.
+    /// @param[in] maximumNumberOfPackets  The maximum number of packets to
+    ///                                    retain.  If this exceeds the
+    ///                                    capacity then the ring grows
+    ///                                    once it fills.
+    /// @throws std::invalid_argument if this is not positive.
+    void setMaximumNumberOfPackets(int maximumNumberOfPackets);
+    /// @result The maximum number of packets the log retains.
+    /// @note By default this is the initial capacity.
+    [[nodiscard]] int getMaximumNumberOfPackets() const noexcept;
+    /// @brief Bounds the size of the packets the log retains.  The newest
+    ///        packet is retained even if it alone exceeds this.  This may be
+    ///        changed while the log is in use in which case the oldest
+    ///        packets beyond the new bound are trimmed immediately.
+    /// @param[in] maximumBytes  The maximum number of bytes to retain.
+    /// @throws std::invalid_argument if this is not positive.
+    void setMaximumBytes(int64_t maximumBytes);
+    /// @result The maximum number of bytes the log retains.  If not set then
+    ///         the log is only bounded in packets.
+    [[nodiscard]] std::optional<int64_t> getMaximumBytes() const noexcept;
+    /// @result The size of the packets in the log in bytes.
+    [[nodiscard]] int64_t getBytes() const noexcept;
+    /// @}
+
+    /// @brief Destructor.
+    ~BroadcastLog();
+
+    BroadcastLog() = delete;
+    BroadcastLog(const BroadcastLog &) = delete;
+    BroadcastLog(BroadcastLog &&) noexcept = delete;
+    BroadcastLog& operator=(const BroadcastLog &) = delete;
+    BroadcastLog& operator=(BroadcastLog &&) noexcept = delete;
+private:
+    class BroadcastLogImpl;
+    std::unique_ptr<BroadcastLogImpl> pImpl;
+};
+}
+#endif
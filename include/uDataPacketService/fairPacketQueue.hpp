@@ -0,0 +1,92 @@
+#ifndef UDATA_PACKET_SERVICE_FAIR_PACKET_QUEUE_HPP
+#define UDATA_PACKET_SERVICE_FAIR_PACKET_QUEUE_HPP
+#include <chrono>
+#include <cstdint>
+#include <memory>
+namespace UDataPacketServiceAPI::V1
+{
+ class Packet;
+}
+namespace UDataPacketService
+{
+/// @class FairPacketQueue "fairPacketQueue.hpp"
+/// @brief A bounded queue that keeps a separate queue for each stream and
+///        serves the streams with deficit round-robin.  Each stream with
+///        queued packets is visited in turn and may send up to a quantum
+///        of bytes per visit, so a stream that floods the queue, e.g., a
+///        station backfilling hours of data, is served at the same byte
+///        rate as every other busy stream rather than ahead of them.
+///        When the queue is full the oldest packet of the longest stream
+///        is dropped so the flooding stream, and not its neighbors, pays
+///        for the overload.
+///
+///        Packets are further split into a real-time and backfill lane.
+///        The backfill lane is only served when the real-time lane is
+///        empty and is the first to lose packets when the queue is full.
+/// @note Any number of threads may push but only one thread may pop.
+/// @copyright Ben Baker (University of Utah) distributed under the
+///            MIT NO AI license.
+class FairPacketQueue
+{
+public:
+    /// @brief The lanes in priority order.
+    enum class Lane
+    {
+        RealTime = 0, /*!< Live data.  This is always served first. */
+        Backfill = 1  /*!< Data well behind now, e.g., a station catching up
+                           after an outage. */
+    };
+public:
+    /// @brief Constructs the queue.
+    /// @param[in] capacity  The maximum number of packets held across all
+    ///                      streams.  This must be positive.
+    /// @param[in] quantum   The number of bytes a stream may send each time
+    ///                      it is visited.  This must be positive.
+    /// @throws std::invalid_argument if the capacity or quantum is not
+    ///         positive.
+    FairPacketQueue(int capacity, int quantum);
+
+    /// @brief Adds a packet to its stream's queue in the given lane.  If
+    ///        the queue is full then the oldest packet of the longest
+    ///        backfill stream is dropped or, if there is no backfill, the
+    ///        oldest packet of the longest real-time stream.
+    /// @param[in,out] packet    The packet to add.  On exit, packet's
+    ///                          behavior is undefined.
+    /// @param[in] receivedTime  When the packet was received (UTC).
+    /// @param[in] lane          The lane in which to queue the packet.
+    void push(UDataPacketServiceAPI::V1::Packet &&packet,
+              const std::chrono::nanoseconds &receivedTime,
+              Lane lane = Lane::RealTime);
+    /// @brief Takes the next packet in deficit round-robin order from the
+    ///        real-time lane or, if that is empty, the backfill lane.
+    /// @param[out] packet        The next packet.
+    /// @param[out] receivedTime  When the packet was received (UTC).
+    /// @result True indicates a packet was taken.  False indicates the
+    ///         queue was empty.
+    [[nodiscard]] bool tryPop(UDataPacketServiceAPI::V1::Packet &packet,
+                              std::chrono::nanoseconds &receivedTime);
+
+    /// @result The number of packets in the queue.
+    [[nodiscard]] int size() const noexcept;
+    /// @result The number of packets in the given lane.
+    [[nodiscard]] int size(Lane lane) const noexcept;
+    /// @result The number of streams with packets in the queue.  A stream
+    ///         with packets in both lanes is counted twice.
+    [[nodiscard]] int getNumberOfStreams() const noexcept;
+    /// @result The number of packets dropped because the queue was full.
+    [[nodiscard]] int64_t getNumberOfDroppedPackets() const noexcept;
+
+    /// @brief Destructor.
+    ~FairPacketQueue();
+
+    FairPacketQueue() = delete;
+    FairPacketQueue(const FairPacketQueue &) = delete;
+    FairPacketQueue(FairPacketQueue &&) noexcept = delete;
+    FairPacketQueue& operator=(const FairPacketQueue &) = delete;
+    FairPacketQueue& operator=(FairPacketQueue &&) noexcept = delete;
+private:
+    class FairPacketQueueImpl;
+    std::unique_ptr<FairPacketQueueImpl> pImpl;
+};
+}
+#endif
@@ -2,6 +2,7 @@
 #define UDATA_PACKET_SERVICE_GRPC_CLIENT_OPTIONS_HPP
 #include <string>
 #include <memory>
+#include <chrono>
 #include <filesystem>
 #include <optional>
 namespace UDataPacketService
@@ -53,6 +54,61 @@ public:
     /// @note The client certificate must also be set for gRPC to use this.
     [[nodiscard]] std::optional<std::string> getClientKey() const noexcept;
 
+    /// @name Channel Tuning
+    /// @{
+
+    /// @brief Sets the interval at which the client pings the server to
+    ///        keep the connection alive through idle NATs and firewalls.
+    /// @param[in] keepAliveTime  The ping interval.  This must be positive.
+    /// @note The server must permit pings this frequently otherwise it will
+    ///       close the connection.
+    void setKeepAliveTime(const std::chrono::milliseconds &keepAliveTime);
+    /// @result The keepalive ping interval.  If not set then keepalive
+    ///         pings are not sent.
+    [[nodiscard]] std::optional<std::chrono::milliseconds> getKeepAliveTime() const noexcept;
+    /// @brief Sets how long to wait for a keepalive ping to be acknowledged
+    ///        before the connection is considered dead.
+    /// @param[in] keepAliveTimeout  The timeout.  This must be positive.
+    void setKeepAliveTimeout(const std::chrono::milliseconds &keepAliveTimeout);
+    /// @result The keepalive timeout.
+    /// @note By default this is 20 s.
+    [[nodiscard]] std::chrono::milliseconds getKeepAliveTimeout() const noexcept;
+
+    /// @brief Sets the largest message the client will receive.
+    /// @param[in] maximumSize  The maximum message size in bytes.  This
+    ///                         must be positive.
+    void setMaximumReceiveMessageSize(int maximumSize);
+    /// @result The maximum receive message size in bytes.
+    /// @note By default this is 4 MB.
+    [[nodiscard]] int getMaximumReceiveMessageSize() const noexcept;
+
+    /// @brief Sets the HTTP/2 initial flow-control window size.  A larger
+    ///        window allows more data in flight on a high-latency link.
+    /// @param[in] windowSize  The window size in bytes.  This must be
+    ///                        positive.
+    void setHTTP2InitialWindowSize(int windowSize);
+    /// @result The HTTP/2 initial window size.  If not set then gRPC's
+    ///         default is used.
+    [[nodiscard]] std::optional<int> getHTTP2InitialWindowSize() const noexcept;
+
+    /// @brief Enables or disables bandwidth-delay product probing.  This
+    ///        lets gRPC grow the flow-control window to fit the link.
+    /// @param[in] enable  True enables BDP probing.
+    void enableBDPProbe(bool enable) noexcept;
+    /// @result True indicates BDP probing is enabled.
+    /// @note By default this is true.
+    [[nodiscard]] bool isBDPProbeEnabled() const noexcept;
+
+    /// @brief Gives the channel its own connection rather than sharing a
+    ///        subchannel (and its transport thread) with other channels
+    ///        in the process to the same server.
+    /// @param[in] use  True indicates the channel gets its own connection.
+    void useDedicatedConnection(bool use) noexcept;
+    /// @result True indicates the channel gets its own connection.
+    /// @note By default this is false.
+    [[nodiscard]] bool useDedicatedConnection() const noexcept;
+    /// @}
+
     /// @brief Destructor
     ~GRPCClientOptions();
     /// @brief Copy constructor.
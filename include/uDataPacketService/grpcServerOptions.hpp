@@ -2,6 +2,7 @@
 #define UDATA_PACKET_SERVICE_GRPC_SERVER_OPTIONS_HPP
 #include <string>
 #include <memory>
+#include <chrono>
 #include <filesystem>
 #include <optional>
 namespace UDataPacketService
@@ -53,6 +54,84 @@ public:
     /// @result The client ceritificate.
     [[nodiscard]] std::optional<std::string> getClientCertificate() const noexcept;
 
+    /// @name Server Tuning
+    /// @{
+
+    /// @brief Limits the memory gRPC may use for its buffers.
+    /// @param[in] memoryQuota  The memory quota in bytes.  This must be
+    ///                         positive.
+    void setMemoryQuota(int64_t memoryQuota);
+    /// @result The memory quota in bytes.  If not set then gRPC's memory
+    ///         use is unbounded.
+    [[nodiscard]] std::optional<int64_t> getMemoryQuota() const noexcept;
+
+    /// @brief Sets the largest message the server will receive.
+    /// @param[in] maximumSize  The maximum message size in bytes.  This
+    ///                         must be positive.
+    void setMaximumReceiveMessageSize(int maximumSize);
+    /// @result The maximum receive message size in bytes.  If not set then
+    ///         gRPC's default (4 MB) is used.
+    [[nodiscard]] std::optional<int> getMaximumReceiveMessageSize() const noexcept;
+
+    /// @brief Sets the largest message the server will send.
+    /// @param[in] maximumSize  The maximum message size in bytes.  This
+    ///                         must be positive.
+    void setMaximumSendMessageSize(int maximumSize);
+    /// @result The maximum send message size in bytes.  If not set then
+    ///         this is unlimited.
+    [[nodiscard]] std::optional<int> getMaximumSendMessageSize() const noexcept;
+
+    /// @brief Sets the size of the HTTP/2 write buffer.  Writes that fit
+    ///        in the buffer complete without waiting for the transport.
+    /// @param[in] bufferSize  The buffer size in bytes.  This must be
+    ///                        positive.
+    void setHTTP2WriteBufferSize(int bufferSize);
+    /// @result The HTTP/2 write buffer size.  If not set then gRPC's
+    ///         default is used.
+    [[nodiscard]] std::optional<int> getHTTP2WriteBufferSize() const noexcept;
+
+    /// @brief Limits the number of concurrent streams (RPCs) on a single
+    ///        client connection.
+    /// @param[in] nStreams  The maximum number of concurrent streams.  This
+    ///                      must be positive.
+    void setMaximumConcurrentStreams(int nStreams);
+    /// @result The maximum number of concurrent streams per connection.
+    ///         If not set then this is unlimited.
+    [[nodiscard]] std::optional<int> getMaximumConcurrentStreams() const noexcept;
+
+    /// @brief Sets the interval at which the server pings clients so that
+    ///        dead subscribers are detected.
+    /// @param[in] keepAliveTime  The ping interval.  This must be positive.
+    void setKeepAliveTime(const std::chrono::milliseconds &keepAliveTime);
+    /// @result The keepalive ping interval.  If not set then gRPC's
+    ///         default (2 hours) is used.
+    [[nodiscard]] std::optional<std::chrono::milliseconds> getKeepAliveTime() const noexcept;
+    /// @brief Sets how long to wait for a keepalive ping to be acknowledged
+    ///        before the connection is closed.
+    /// @param[in] keepAliveTimeout  The timeout.  This must be positive.
+    void setKeepAliveTimeout(const std::chrono::milliseconds &keepAliveTimeout);
+    /// @result The keepalive timeout.
+    /// @note By default this is 20 s.
+    [[nodiscard]] std::chrono::milliseconds getKeepAliveTimeout() const noexcept;
+
+    /// @brief Sets the shortest interval at which clients may send
+    ///        keepalive pings.  Clients that ping more often are
+    ///        disconnected.
+    /// @param[in] interval  The minimum ping interval.  This must be
+    ///                      positive.
+    void setMinimumClientPingInterval(const std::chrono::milliseconds &interval);
+    /// @result The minimum client ping interval.  If not set then gRPC's
+    ///         default (5 minutes) is used.
+    [[nodiscard]] std::optional<std::chrono::milliseconds> getMinimumClientPingInterval() const noexcept;
+    /// @brief Allows clients to send keepalive pings when they have no
+    ///        RPCs in flight.
+    /// @param[in] permit  True permits these pings.
+    void permitKeepAliveWithoutCalls(bool permit) noexcept;
+    /// @result True indicates clients may ping without RPCs in flight.  If
+    ///         not set then gRPC's default (false) is used.
+    [[nodiscard]] std::optional<bool> permitKeepAliveWithoutCalls() const noexcept;
+    /// @}
+
     /// @brief Destructor
     ~GRPCServerOptions();
     /// @brief Copy constructor.
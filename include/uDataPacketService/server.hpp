@@ -1,6 +1,7 @@
 #ifndef UDATA_PACKET_SERVICE_SERVER_HPP
 #define UDATA_PACKET_SERVICE_SERVER_HPP
 #include <memory>
+#include <vector>
 #include <spdlog/spdlog.h>
 namespace UDataPacketServiceAPI::V1
 {
@@ -9,6 +10,8 @@ namespace UDataPacketServiceAPI::V1
 namespace UDataPacketService
 {
  class ServerOptions;
+ struct StreamStatistics;
+ struct SubscriberStatistics;
 }
 namespace UDataPacketService
 {
@@ -27,6 +30,13 @@ public:
     void start();
     /// @result The current number of subscribers.
     [[nodiscard]] int getNumberOfSubscribers() const noexcept;
+    /// @result A snapshot of every stream's statistics.
+    [[nodiscard]] std::vector<StreamStatistics> getStreamStatistics() const;
+    /// @result A snapshot of every subscriber's statistics.
+    [[nodiscard]] std::vector<SubscriberStatistics> getSubscriberStatistics() const;
+    /// @brief Logs the rate-limited warnings that are still pending.  Call
+    ///        this periodically.
+    void reportSuppressedWarnings();
     /// @brief Stops the server
     void stop();
 
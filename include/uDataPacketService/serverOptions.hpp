@@ -1,6 +1,7 @@
 #ifndef UDATA_PACKET_SERVICE_SERVER_OPTIONS_HPP
 #define UDATA_PACKET_SERVICE_SERVER_OPTIONS_HPP
 #include <string>
+#include <chrono>
 #include <vector>
 #include <memory>
 namespace UDataPacketService
@@ -41,6 +42,27 @@ public:
     /// @result The maximum number of subscribers.
     [[nodiscard]] int getMaximumNumberOfSubscribers() const noexcept;
 
+    /// @brief Enables or disables the admin service which reports the
+    ///        streams and subscribers held by the server.  The service
+    ///        exposes the subscribers' peers so the server only starts it
+    ///        on a TLS connection with an access token.
+    /// @param[in] enable  True enables the admin service.
+    void enableAdminService(bool enable) noexcept;
+    /// @result True indicates the admin service is enabled.
+    /// @note This is disabled by default.
+    [[nodiscard]] bool isAdminServiceEnabled() const noexcept;
+
+    /// @brief Packets that start more than this far behind now are
+    ///        backfill.  Backfill is queued in a low-priority lane that is
+    ///        only served when no real-time packets are waiting so that
+    ///        catch-up events don't delay live data.
+    /// @param[in] threshold  The backfill threshold.  This must be positive.
+    /// @throws std::invalid_argument if the threshold is not positive.
+    void setBackfillThreshold(const std::chrono::microseconds &threshold);
+    /// @result The backfill threshold.
+    /// @note By default this is two minutes.
+    [[nodiscard]] std::chrono::microseconds getBackfillThreshold() const noexcept;
+
     /// @brief Sets the subscriber identifier.
     //void setIdentifier(const std::string &name);
     /// @result The subscriber identifier.
@@ -0,0 +1,181 @@
+#ifndef UDATA_PACKET_SERVICE_STATISTICS_HPP
+#define UDATA_PACKET_SERVICE_STATISTICS_HPP
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "uDataPacketService/subscriberHandle.hpp"
+namespace UDataPacketService
+{
+/// @class ThroughputCounter "statistics.hpp"
+/// @brief Counts packets and bytes and estimates their rates over a fixed
+///        window.  The counters are relaxed atomics so they are cheap to
+///        update and can be read at any time from any thread.
+/// @note Only one thread at a time may call \c add().  This is the case
+///       for a stream (one publisher) and a writer reactor (one write in
+///       flight).
+/// @copyright Ben Baker (University of Utah) distributed under the
+///            MIT NO AI license.
+class ThroughputCounter
+{
+public:
+    /// @brief Adds a packet.
+    /// @param[in] nBytes  The size of the packet in bytes.
+    /// @param[in] now     The current time (UTC) since the epoch.
+    void add(const int64_t nBytes,
+             const std::chrono::nanoseconds &now) noexcept
+    {
+        constexpr auto relaxed = std::memory_order_relaxed;
+        auto packets = mPackets.load(relaxed) + 1;
+        auto bytes = mBytes.load(relaxed) + nBytes;
+        mPackets.store(packets, relaxed);
+        mBytes.store(bytes, relaxed);
+        mLastTime.store(now.count(), relaxed);
+        auto windowStart = mWindowStart.load(relaxed);
+        if (windowStart == 0)
+        {
+            mWindowStart.store(now.count(), relaxed);
+            return;
+        }
+        auto elapsed = now.count() - windowStart;
+        if (elapsed >= mWindow.count())
+        {
+            auto seconds = elapsed*1.e-9;
+            mPacketsPerSecond.store((packets - mWindowPackets)/seconds,
+                                    relaxed);
+            mBytesPerSecond.store((bytes - mWindowBytes)/seconds, relaxed);
+            mWindowPackets = packets;
+            mWindowBytes = bytes;
+            mWindowStart.store(now.count(), relaxed);
+        }
+    }
+    /// @result The total number of packets.
+    [[nodiscard]] int64_t getPackets() const noexcept
+    {
+        return mPackets.load(std::memory_order_relaxed);
+    }
+    /// @result The total number of bytes.
+    [[nodiscard]] int64_t getBytes() const noexcept
+    {
+        return mBytes.load(std::memory_order_relaxed);
+    }
+    /// @result The time (UTC) of the last packet or 0 if there were no
+    ///         packets.
+    [[nodiscard]] std::chrono::nanoseconds getLastTime() const noexcept
+    {
+        return std::chrono::nanoseconds {mLastTime.load(std::memory_order_relaxed)};
+    }
+    /// @param[in] now  The current time (UTC) since the epoch.
+    /// @result The packet rate over the last complete window.  This is 0
+    ///         if nothing arrived over the last two windows.
+    [[nodiscard]] double getPacketsPerSecond(const std::chrono::nanoseconds &now) const noexcept
+    {
+        if (isStale(now)){return 0;}
+        return mPacketsPerSecond.load(std::memory_order_relaxed);
+    }
+    /// @param[in] now  The current time (UTC) since the epoch.
+    /// @result The byte rate over the last complete window.  This is 0
+    ///         if nothing arrived over the last two windows.
+    [[nodiscard]] double getBytesPerSecond(const std::chrono::nanoseconds &now) const noexcept
+    {
+        if (isStale(now)){return 0;}
+        return mBytesPerSecond.load(std::memory_order_relaxed);
+    }
+private:
+    [[nodiscard]] bool isStale(const std::chrono::nanoseconds &now) const noexcept
+    {
+        return now.count() - mWindowStart.load(std::memory_order_relaxed)
+             > 2*mWindow.count();
+    }
+    std::chrono::nanoseconds mWindow{std::chrono::seconds {10}};
+    std::atomic<int64_t> mPackets{0};
+    std::atomic<int64_t> mBytes{0};
+    std::atomic<int64_t> mLastTime{0};
+    std::atomic<int64_t> mWindowStart{0};
+    std::atomic<double> mPacketsPerSecond{0};
+    std::atomic<double> mBytesPerSecond{0};
+    // Only touched by the thread calling add()
+    int64_t mWindowPackets{0};
+    int64_t mWindowBytes{0};
+};
+
+/// @class SubscriberCounters "statistics.hpp"
+/// @brief The live counters of a subscriber.  The subscription manager
+///        creates these with the subscriber and the subscriber's writer
+///        updates them.
+/// @copyright Ben Baker (University of Utah) distributed under the
+///            MIT NO AI license.
+class SubscriberCounters
+{
+public:
+    /// @brief Constructor.
+    /// @param[in] handle  The subscriber's handle.
+    /// @param[in] peer    The subscriber's name for reporting.
+    /// @param[in] connectedTime  When the subscriber connected (UTC).
+    SubscriberCounters(const SubscriberHandle &handle,
+                       const std::string &peer,
+                       const std::chrono::nanoseconds &connectedTime) :
+        mPeer(peer),
+        mHandle(handle),
+        mConnectedTime(connectedTime)
+    {
+    }
+    /// @result The peer.
+    [[nodiscard]] const std::string &getPeer() const noexcept{return mPeer;}
+    /// @result The handle.
+    [[nodiscard]] SubscriberHandle getHandle() const noexcept{return mHandle;}
+    /// @result When the subscriber connected (UTC).
+    [[nodiscard]] std::chrono::nanoseconds getConnectedTime() const noexcept
+    {
+        return mConnectedTime;
+    }
+    /// @brief The written packets.
+    ThroughputCounter delivered;
+    /// @brief Packets the writer dropped because its queue was full.
+    std::atomic<int64_t> packetsDropped{0};
+    /// @brief Packets waiting in the writer's queue.
+    std::atomic<int> queueDepth{0};
+    /// @brief True indicates the subscriber subscribed to all streams.
+    std::atomic<bool> subscribedToAll{false};
+private:
+    std::string mPeer;
+    SubscriberHandle mHandle;
+    std::chrono::nanoseconds mConnectedTime{0};
+};
+
+/// @brief A snapshot of a stream's statistics.
+struct StreamStatistics
+{
+    std::string identifier; /*!< The stream's name, e.g., UU.CTU.HHZ.01. */
+    std::chrono::nanoseconds lastPacketTime{0}; /*!< When the last packet
+                                                     was received (UTC). */
+    double packetsPerSecond{0}; /*!< Recent packet rate. */
+    double bytesPerSecond{0};   /*!< Recent byte rate. */
+    int64_t packetsReceived{0}; /*!< Total packets received. */
+    int64_t bytesReceived{0};   /*!< Total bytes received. */
+    int numberOfSubscribers{0}; /*!< Current number of subscribers.  This
+                                     excludes subscribers to all
+                                     streams. */
+};
+
+/// @brief A snapshot of a subscriber's statistics.
+struct SubscriberStatistics
+{
+    std::string peer; /*!< The subscriber's name. */
+    SubscriberHandle handle; /*!< The subscriber's handle. */
+    std::chrono::nanoseconds connectedTime{0}; /*!< When the subscriber
+                                                    connected (UTC). */
+    double packetsPerSecond{0}; /*!< Recent write rate in packets. */
+    double bytesPerSecond{0};   /*!< Recent write rate in bytes. */
+    int64_t packetsDelivered{0}; /*!< Total packets written. */
+    int64_t bytesDelivered{0};   /*!< Total bytes written. */
+    int64_t packetsDropped{0};   /*!< Packets dropped from the subscriber's
+                                      group log and writer queue. */
+    int queueDepth{0}; /*!< Packets waiting in the subscriber's group log
+                            and writer queue. */
+    int numberOfSubscriptions{0}; /*!< Number of active subscriptions. */
+    bool subscribedToAll{false}; /*!< True indicates the subscriber
+                                      subscribed to all streams. */
+};
+}
+#endif
@@ -1,8 +1,8 @@
 #ifndef UDATA_PACKET_SERVICE_STREAM_HPP
 #define UDATA_PACKET_SERVICE_STREAM_HPP
-#include <set>
+#include <chrono>
 #include <memory>
-#include <optional>
+#include <string>
 #include <spdlog/spdlog.h>
 namespace UDataPacketServiceAPI::V1
 {
@@ -11,24 +11,21 @@ namespace UDataPacketServiceAPI::V1
 namespace UDataPacketService
 {
 class StreamOptions;
+struct StreamStatistics;
 }
 namespace UDataPacketService
 {
 /// @class Stream "stream.hpp"
 /// @brief A seismic stream is a stream of packetized data generated
-///        by unique network, station, channel, location tuple.
-///        Subscribers subscribe to streams.
+///        by unique network, station, channel, location tuple.  The stream
+///        keeps its most recent packet and its statistics.  Subscribers
+///        read the stream's packets from their subscription groups' logs
+///        which the subscription manager sizes from the streams' queue
+///        capacities.
 /// @copyright Ben Baker (University of Utah) distributed under the
 ///            MIT NO AI license.
 class Stream
 {
-public:
-    enum class UnsubscribeResponse
-    {
-        Unsubscribed = 0,    /*!< Successfully unsubscribed. */
-        NeverSubscribed = 1, /*!< Can't unsubscribe because context wasn't subscribed to start with. */
-        NotUnsubscribed = 2  /*!< This indicates failure. */
-    };
 public:
     /// @name Publisher
     /// @{
@@ -41,61 +38,46 @@ public:
            const StreamOptions &options,
            std::shared_ptr<spdlog::logger> logger);
 
-    /// @brief Sets the next packet for all subscribers.
+    /// @brief Sets the next packet.
     /// @param[in,out] packet  The packet to add.  On exit, packet's behavior
     ///                        is undefined.
     /// @throws std::invalid_argument if the packet's stream identifier does
     ///         not match this stream's identifier.
     void setNextPacket(UDataPacketServiceAPI::V1::Packet &&packet);
-    /// @brief Sets the next packet for all subscribers.
+    /// @brief Sets the next packet.
     /// @param[in] packet  The packet to add.
     /// @throws std::invalid_argument if the packet's stream identifier does
     ///         not match this stream's identifier.
     void setNextPacket(const UDataPacketServiceAPI::V1::Packet &packet);
+    /// @brief Sets the next packet without copying it.  This only swaps
+    ///        the most recent packet.
+    /// @param[in] packet  The packet to add.  This may be shared with, e.g.,
+    ///                    the subscription manager's logs.
+    /// @throws std::invalid_argument if the packet is null.
+    /// @note The caller is responsible for the packet belonging to this
+    ///       stream, e.g., by having found the stream with the packet's
+    ///       identifier.  This is only checked in debug builds.
+    void setNextPacket(std::shared_ptr<const UDataPacketServiceAPI::V1::Packet> packet);
 
     /// @}
 
-    /// @name Subscriber
+    /// @name Management
     /// @{
 
-    /// @brief Subscribes to the stream.
-    /// @param[in] contextAddress  The identifier to subscribe.
-    /// @param[in] enqeueuLatestPacket  If true then if the most recent packet
-    ///                                 is available then the subscriber will
-    ///                                 be able to access it.  Otherwise, 
-    ///                                 the subscriber's first packet will be
-    ///                                 the next packet enqueued by the
-    ///                                 publisher.
-    /// @result True indicates the subscription was successful.
-    [[nodiscard]] bool subscribe(uintptr_t contextAddress,
-                                 bool enqueueLatestPacket);
-
-    /// @brief Subscriber gets next packet
-    /// @param[in] contextAddress  The subscriber's identifier.
-    /// @result The next packet if it exists.  Otherwise, std::nullopt.
-    [[nodiscard]] std::optional<UDataPacketServiceAPI::V1::Packet>
-        getNextPacket(uintptr_t contextAddress) noexcept;
-
-    /// @brief Unsubscribes from the stream.
-    /// @param[in] contextAddress  The identifier to unsubscribe.
-    [[nodiscard]] UnsubscribeResponse unsubscribe(uintptr_t contextAddress);
-
     /// @result The stream identifier.
     [[nodiscard]] std::string getIdentifier() const noexcept;
-    /// @}
-
-    /// @name Management
-    /// @{
-
-    /// @result The number of subscribers.
-    [[nodiscard]] int getNumberOfSubscribers() const noexcept;
-    /// @result The current subscribers.
-    [[nodiscard]] std::set<uintptr_t> getSubscribers() const noexcept;
-    /// @result True indicates this subscriber is subscribed.
-    [[nodiscard]] bool isSubscribed(uintptr_t contextAddress) const noexcept;
-    /// @brief Forcefully purges all subscribers.  This is used during 
-    ///        application shutdown.
-    void unsubscribeAll();
+    /// @result The most recent packet.
+    [[nodiscard]] std::shared_ptr<const UDataPacketServiceAPI::V1::Packet> getMostRecentPacket() const;
+    /// @result A snapshot of the stream's statistics.
+    [[nodiscard]] StreamStatistics getStatistics() const;
+    /// @result The time (UTC) the stream's most recent packet arrived.
+    ///         Unlike the statistics this is cheap enough to call for every
+    ///         stream.
+    [[nodiscard]] std::chrono::nanoseconds getLastPacketTime() const noexcept;
+    /// @result The number of this stream's packets a subscriber may fall
+    ///         behind by.  If the options bound the queue by duration then
+    ///         this is derived from the durations of the stream's packets.
+    [[nodiscard]] int getMaximumQueueSize() const noexcept;
     /// @}
 
     /// @brief Destructor
@@ -1,6 +1,9 @@
 #ifndef UDATA_PACKET_SERVICE_STREAM_OPTIONS_HPP
 #define UDATA_PACKET_SERVICE_STREAM_OPTIONS_HPP
 #include <memory>
+#include <chrono>
+#include <cstdint>
+#include <optional>
 namespace UDataPacketService
 {
 /// @class StreamOptions "streamOptions.hpp"
@@ -17,17 +20,40 @@ public:
     /// @brief Move cnostructor.
     StreamOptions(StreamOptions &&options) noexcept;
 
-    /// @brief Every stream makes a small queue for the benefit of the 
-    ///        subscriber (a process running on a different thread).
-    ///        This allows the reader thread a little time to get the
-    ///        latest data packet before the writer writes the next
-    ///        packet. 
+    /// @brief Every stream gives its subscribers (processes running on
+    ///        different threads) a little slack in their subscription
+    ///        groups' logs.  This allows a reader thread a little time to
+    ///        get the latest data packet before the writer overwrites it.
     /// @param[in] queueSize  This must be positive.
     void setMaximumQueueSize(const int queueSize);
-    /// @result The maximum queue size. 
-    /// @note By default this is 8.
+    /// @result The maximum queue size in packets.  This bounds the queue
+    ///         when no maximum queue duration is set.
+    /// @note By default this is 128.
     [[nodiscard]] int getMaximumQueueSize() const noexcept;
 
+    /// @brief Bounds the queue by the seconds of data it holds rather than
+    ///        by a fixed number of packets.  The queue's capacity in packets
+    ///        is derived from the durations of the stream's packets so that,
+    ///        e.g., a stream of 0.25 s packets and a stream of 30 s packets
+    ///        both give the subscriber the same slack.
+    /// @param[in] duration  The maximum duration of data in the queue.  This
+    ///                      must be positive.
+    void setMaximumQueueDuration(const std::chrono::milliseconds &duration);
+    /// @result The maximum duration of data in the queue.  If not set then
+    ///         the queue is bounded by the maximum queue size.
+    [[nodiscard]] std::optional<std::chrono::milliseconds> getMaximumQueueDuration() const noexcept;
+
+    /// @brief Bounds the queue by the size of the packets it holds.  A
+    ///        subscription group's log retains at most this many bytes for
+    ///        each stream it selects and drops its oldest packets rather
+    ///        than exceed that.
+    /// @param[in] maximumBytes  The maximum number of bytes in the queue.
+    ///                          This must be positive.
+    void setMaximumQueueBytes(int64_t maximumBytes);
+    /// @result The maximum number of bytes in the queue.  If not set then
+    ///         the queue is only bounded in packets.
+    [[nodiscard]] std::optional<int64_t> getMaximumQueueBytes() const noexcept;
+
     /// @brief Destructor.
     ~StreamOptions();
     /// @brief Copy assignment.
@@ -24,11 +24,27 @@ public:
     Subscriber(const SubscriberOptions &options,
                const std::function<void (UDataPacketImportAPI::V1::Packet &&)> &callback,
                std::shared_ptr<spdlog::logger> logger); 
+    /// @brief Subscriber with flow control.  While isSaturated returns true
+    ///        the subscriber holds off reading the next packet.  The
+    ///        HTTP/2 flow control window then pushes back on the import
+    ///        proxy so the packets wait in its buffer rather than being
+    ///        dropped from ours.
+    /// @param[in] isSaturated  Returns true when the consumer of the
+    ///                         callback is above its high-water mark.  This
+    ///                         is called from the gRPC threads and must be
+    ///                         thread-safe and quick.
+    Subscriber(const SubscriberOptions &options,
+               const std::function<void (UDataPacketImportAPI::V1::Packet &&)> &callback,
+               const std::function<bool ()> &isSaturated,
+               std::shared_ptr<spdlog::logger> logger);
     
     /// @brief Destructor
     ~Subscriber();
 
     /// @brief Starts the subscriber.
+    /// @result A future which completes when all the import streams have
+    ///         finished.  The callback is invoked concurrently when there
+    ///         is more than one import stream.
     [[nodiscard]] std::future<void> start();
     //// @brief Terminates the subscriber.
     void stop(); 
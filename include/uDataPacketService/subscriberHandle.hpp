@@ -0,0 +1,58 @@
+#ifndef UDATA_PACKET_SERVICE_SUBSCRIBER_HANDLE_HPP
+#define UDATA_PACKET_SERVICE_SUBSCRIBER_HANDLE_HPP
+#include <cstdint>
+#include <compare>
+namespace UDataPacketService
+{
+/// @class SubscriberHandle "subscriberHandle.hpp"
+/// @brief Identifies a subscriber to the subscription manager.  The handle
+///        packs the subscriber's slot index with the slot's generation.
+///        When a subscriber leaves its slot's generation is advanced so
+///        a stale handle can never be confused with the slot's next
+///        occupant.
+/// @copyright Ben Baker (University of Utah) distributed under the
+///            MIT NO AI license.
+class SubscriberHandle
+{
+public:
+    /// @brief Constructs an invalid handle.
+    constexpr SubscriberHandle() noexcept = default;
+    /// @brief Constructs a handle from a slot and generation.
+    /// @param[in] slot        The slot index.
+    /// @param[in] generation  The slot's generation.  This must be positive
+    ///                        for the handle to be valid.
+    constexpr SubscriberHandle(const uint32_t slot,
+                               const uint32_t generation) noexcept :
+        mValue( (static_cast<uint64_t> (generation) << 32) | slot )
+    {
+    }
+    /// @result The slot index.
+    [[nodiscard]] constexpr uint32_t getSlot() const noexcept
+    {
+        return static_cast<uint32_t> (mValue & 0xFFFFFFFF);
+    }
+    /// @result The slot's generation when this handle was issued.
+    [[nodiscard]] constexpr uint32_t getGeneration() const noexcept
+    {
+        return static_cast<uint32_t> (mValue >> 32);
+    }
+    /// @result The packed handle.  This is unique for the lifetime of the
+    ///         subscription manager (modulo generation wrap-around) and is
+    ///         suitable as a key.
+    [[nodiscard]] constexpr uint64_t getValue() const noexcept
+    {
+        return mValue;
+    }
+    /// @result True indicates the handle was issued by a subscription
+    ///         manager.  It may, however, be stale.
+    [[nodiscard]] constexpr bool isValid() const noexcept
+    {
+        return getGeneration() != 0;
+    }
+    /// @brief Compares handles.
+    constexpr auto operator<=>(const SubscriberHandle &) const noexcept = default;
+private:
+    uint64_t mValue{0};
+};
+}
+#endif
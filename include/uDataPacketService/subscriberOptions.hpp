@@ -29,6 +29,32 @@ public:
     /// @result The gRPC connection options.
     [[nodiscard]] GRPCClientOptions getGRPCOptions() const;
 
+    /// @brief Sets the connection options of additional proxy replicas.
+    ///        The import streams are assigned round-robin to the primary
+    ///        (see \c setGRPCOptions()) and these replicas.
+    /// @param[in] options  The replicas' connection options.
+    void setReplicaGRPCOptions(const std::vector<GRPCClientOptions> &options);
+    /// @result The replicas' connection options.
+    [[nodiscard]] std::vector<GRPCClientOptions> getReplicaGRPCOptions() const;
+    /// @param[in] stream  The import stream index.
+    /// @result The connection options of the endpoint to which the import
+    ///         stream connects.
+    /// @throws std::invalid_argument if stream is out of bounds.
+    [[nodiscard]] GRPCClientOptions getGRPCOptions(int stream) const;
+
+    /// @brief Sets the number of concurrent import subscriptions.  When
+    ///        greater than 1 the streams' packets are merged and
+    ///        deduplicated.
+    /// @param[in] nStreams  The number of import streams.  A proxy sends
+    ///                      its whole feed to every subscription so this
+    ///                      should not exceed the number of proxies, i.e.,
+    ///                      the primary plus the replicas.
+    /// @throws std::invalid_argument if nStreams is not positive.
+    void setNumberOfStreams(int nStreams);
+    /// @result The number of import streams.
+    /// @note By default this is 1.
+    [[nodiscard]] int getNumberOfStreams() const noexcept;
+
     /// @brief Sets the reconnection schedule.
     void setReconnectSchedule(const std::vector<std::chrono::milliseconds> &reconnectSchedule);
     /// @result The reconnection schedule.
@@ -1,9 +1,12 @@
 #ifndef UDATA_PACKET_SERVICE_SUBSCRIPTION_MANAGER_HPP
 #define UDATA_PACKET_SERVICE_SUBSCRIPTION_MANAGER_HPP
 #include <memory>
+#include <optional>
 #include <set>
+#include <string>
 #include <vector>
 #include <spdlog/spdlog.h>
+#include "uDataPacketService/subscriberHandle.hpp"
 namespace UDataPacketServiceAPI::V1
 {
  class Packet;
@@ -12,6 +15,9 @@ namespace UDataPacketServiceAPI::V1
 namespace UDataPacketService
 {
  class SubscriptionManagerOptions;
+ class SubscriberCounters;
+ struct StreamStatistics;
+ struct SubscriberStatistics;
 }
 namespace UDataPacketService
 {
@@ -29,6 +35,8 @@ public:
     /// @name Publishers
     /// @{
  
+    /// @note There is a single publisher.  Packets must be enqueued from one
+    ///       thread at a time.
     /// @brief Enqueues the next packet for consumption by all interested
     ///        subscribers.
     /// @param[in] packet  The packet to enqueue.
@@ -47,28 +55,52 @@ public:
     /// @name Subscribers
     /// @{
 
-    /// @brief Subscribes to selected streams.
-    /// @param[in] contextAddress  The RPC's memory location.
+    /// @brief Issues a handle with which an RPC identifies itself as a
+    ///        subscriber.  The handle is released by \c unsubscribeFromAll.
+    /// @result The subscriber's handle.
+    [[nodiscard]] SubscriberHandle createSubscriber();
+    /// @brief Issues a subscriber handle.
+    /// @param[in] peer  The subscriber's name as it should appear in the
+    ///                  statistics.
+    /// @result The subscriber's handle.
+    [[nodiscard]] SubscriberHandle createSubscriber(const std::string &peer);
+    /// @param[in] handle  The subscriber's handle.
+    /// @result The subscriber's live counters which the subscriber's writer
+    ///         updates.  This is nullptr if the handle is stale.
+    [[nodiscard]] std::shared_ptr<SubscriberCounters> getSubscriberCounters(const SubscriberHandle &handle) const;
+
+    /// @brief Subscribes to selected streams.  Subscribers with identical
+    ///        selections share a group so each packet is fanned out once
+    ///        per distinct selection rather than once per subscriber.
+    ///        Subscribing again widens the subscriber's selection.
+    /// @param[in] handle  The subscriber's handle.
     /// @param[in] streamIdentifiers  The stream identifiers to which to subscribe.
-    /// @throws std::invalid_argumetn if streamIdentifiers is empty.
-    void subscribe(uintptr_t contextAddress,
+    /// @throws std::invalid_argumetn if streamIdentifiers is empty or the
+    ///         handle is invalid or stale.
+    void subscribe(const SubscriberHandle &handle,
                    const std::vector<UDataPacketServiceAPI::V1::StreamIdentifier> &streamIdentifiers);
 
     /// @brief Subscribes to all streams.
     /// @param[in] serverContext  The server context.
     //template<typename U> void subscribeToAll(U *serverContext);
     /// @brief Subscribes to all streams.
-    /// @param[in] contextAddress  The RPC's memory location.
-    void subscribeToAll(uintptr_t contextAddress);
+    /// @param[in] handle  The subscriber's handle.
+    /// @throws std::invalid_argument if the handle is invalid or stale.
+    void subscribeToAll(const SubscriberHandle &handle);
 
     /// @brief Gets the next packets from the streams to which I'm subscribed.
-    /// @param[in] contextAddress  The RPC's memory address.
-    /// @result The next batch of received packets.
-    [[nodiscard]] std::vector<UDataPacketServiceAPI::V1::Packet> getPackets(uintptr_t contextAddress) const;
+    /// @param[in] handle  The subscriber's handle.
+    /// @result The next batch of received packets.  This is empty if the
+    ///         handle is stale.  The packets are shared with the other
+    ///         subscribers rather than copied.
+    [[nodiscard]] std::vector<std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>> getPackets(const SubscriberHandle &handle) const;
 
-    /// @brief Unsubscribes the server context from all subscriptions.
-    /// @param[in] contextAddress  The context address to unsubscribe.
-    void unsubscribeFromAll(uintptr_t contextAddress);
+    /// @brief Unsubscribes the subscriber from all subscriptions and
+    ///        releases its handle.
+    /// @param[in] handle  The subscriber's handle.
+    /// @note This is a no-op for a stale handle so it is safe to call more
+    ///       than once.
+    void unsubscribeFromAll(const SubscriberHandle &handle);
     /// @}
 
     /// @name Application Management
@@ -76,9 +108,45 @@ public:
 
     /// @result The total number of subscribers.
     [[nodiscard]] int getNumberOfSubscribers() const noexcept;
+    /// @param[in] handle  The subscriber's handle.
+    /// @result The number of streams to which the subscriber is actively
+    ///         subscribed.  Pending subscriptions are not counted.
+    [[nodiscard]] int getNumberOfSubscriptions(const SubscriberHandle &handle) const;
     /// @brief Forcefully purges all subscribers.  This is used during 
     ///        application shutdown.
     void unsubscribeAll();
+    /// @result The number of streams in the registry.
+    [[nodiscard]] int getNumberOfStreams() const;
+    /// @brief Removes the streams that have not received a packet within
+    ///        the idle stream timeout.  This also happens periodically while
+    ///        packets are enqueued.  A subscriber to an evicted stream keeps
+    ///        its subscription and resumes receiving packets when the stream
+    ///        returns.
+    /// @result The number of streams that were evicted.
+    int evictIdleStreams();
+    /// @result The total number of streams evicted because they were idle
+    ///         or the registry was full.
+    [[nodiscard]] int64_t getNumberOfEvictedStreams() const noexcept;
+    /// @brief Hot-path warnings are rate limited.  This logs the ones that
+    ///        are still pending so they are reported even after the
+    ///        condition stops.  Call this periodically.
+    void reportSuppressedWarnings();
+    /// @}
+
+    /// @name Statistics
+    /// @{
+
+    /// @result A snapshot of every stream's statistics.
+    [[nodiscard]] std::vector<StreamStatistics> getStreamStatistics() const;
+    /// @param[in] streamIdentifier  The stream's name, e.g., UU.CTU.HHZ.01.
+    /// @result A snapshot of the stream's statistics or std::nullopt if the
+    ///         stream does not exist.
+    [[nodiscard]] std::optional<StreamStatistics> getStreamStatistics(const std::string &streamIdentifier) const;
+    /// @result The names of the streams.
+    [[nodiscard]] std::vector<std::string> getStreamIdentifiers() const;
+    /// @result A snapshot of every subscriber's statistics.
+    /// @note This does not take the lock used to manage subscriptions.
+    [[nodiscard]] std::vector<SubscriberStatistics> getSubscriberStatistics() const;
     /// @}
  
     /// @brief Destructor.
@@ -1,5 +1,6 @@
 #ifndef UDATA_PACKET_SERVICE_SUBSCRIPTION_MANAGER_OPTIONS_HPP
 #define UDATA_PACKET_SERVICE_SUBSCRIPTION_MANAGER_OPTIONS_HPP
+#include <chrono>
 #include <memory>
 namespace UDataPacketService
 {
@@ -13,6 +14,19 @@ namespace UDataPacketService
 ///            MIT NO AI license.
 class SubscriptionManagerOptions
 {
+public:
+    /// @brief Defines what the subscription manager does when the queues
+    ///        hold more than the memory budget.
+    enum class SheddingPolicy
+    {
+        None = 0,              /*!< Nothing is shed.  The budget is only
+                                    reported. */
+        LaggiestSubscriber = 1 /*!< Packets every subscriber has read are
+                                    released and then the backlogs of the
+                                    laggiest subscribers are shed, one
+                                    subscriber at a time, until the queues
+                                    are within budget. */
+    };
 public:
     /// @brief Constructor.
     SubscriptionManagerOptions();
@@ -33,6 +47,49 @@ public:
     /// @result The options defining the behavior of the data streams.
     [[nodiscard]] StreamOptions getStreamOptions() const noexcept;
 
+    /// @brief Subscribers read from their subscription group's shared log
+    ///        of the most recent packets.  A group's log retains as many
+    ///        packets as its streams' queues allow, up to this many.  The
+    ///        log of the subscribers to all streams counts every live
+    ///        stream.  A subscriber that falls further behind than its log
+    ///        retains loses the oldest packets.  The logs only grow to this
+    ///        as they fill.
+    /// @param[in] capacity  The number of packets a log can retain.
+    ///                      This must be positive.
+    /// @throws std::invalid_argument if the capacity is not positive.
+    void setBroadcastLogCapacity(int capacity);
+    /// @result The number of packets a broadcast log can retain.
+    /// @note By default this is 8388608, i.e., a default queue for each of
+    ///       the default maximum number of streams.
+    [[nodiscard]] int getBroadcastLogCapacity() const noexcept;
+
+    /// @brief Streams that have not received a packet in this long are
+    ///        removed.  Their subscribers wait for them to come back online.
+    /// @param[in] timeout  The idle stream timeout.  This must be positive.
+    /// @throws std::invalid_argument if the timeout is not positive.
+    void setIdleStreamTimeout(const std::chrono::seconds &timeout);
+    /// @result The idle stream timeout.
+    /// @note By default this is one hour.
+    [[nodiscard]] std::chrono::seconds getIdleStreamTimeout() const noexcept;
+
+    /// @brief Bounds the stream registry.  When a new stream would exceed
+    ///        this then the stalest stream is removed.
+    /// @param[in] maximumNumberOfStreams  The maximum number of streams.
+    ///                                    This must be positive.
+    /// @throws std::invalid_argument if the maximum is not positive.
+    void setMaximumNumberOfStreams(int maximumNumberOfStreams);
+    /// @result The maximum number of streams.
+    /// @note By default this is 65536.
+    [[nodiscard]] int getMaximumNumberOfStreams() const noexcept;
+
+    /// @brief Sets what to do when the queues exceed the memory budget.
+    /// @param[in] policy  The shedding policy.
+    void setSheddingPolicy(SheddingPolicy policy) noexcept;
+    /// @result The shedding policy.
+    /// @note By default this is SheddingPolicy::LaggiestSubscriber.  This
+    ///       has no effect unless the memory budget has a limit.
+    [[nodiscard]] SheddingPolicy getSheddingPolicy() const noexcept;
+
     /// @brief Destructor.
     ~SubscriptionManagerOptions();
     /// @brief Copy assignment.
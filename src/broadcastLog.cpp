@@ -0,0 +1,477 @@
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <optional>
+#include <stdexcept>
+#include <algorithm>
+#include "uDataPacketService/broadcastLog.hpp"
+#include "uDataPacketServiceAPI/v1/packet.pb.h"
+
+import Utilities;
+import Metrics;
+import MemoryBudget;
+
+using namespace UDataPacketService;
+
+namespace
+{
+
+/// A position in the ring.  The publisher fills the slot in place so
+/// appending allocates nothing.  There is only one publisher but a reader
+/// copying the packet's shared pointer must not race the publisher
+/// replacing it, so a reader holds the slot's lock only long enough to
+/// take a reference to the packet, which may be shared with other logs.
+struct Slot
+{
+    void lock() noexcept
+    {
+        while (busy.test_and_set(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+    }
+    void unlock() noexcept
+    {
+        busy.clear(std::memory_order_release);
+    }
+    std::atomic_flag busy;
+    std::shared_ptr<const UDataPacketServiceAPI::V1::Packet> packet{nullptr};
+    std::chrono::nanoseconds enqueueTime{0};
+    uint64_t sequence{0};
+    int64_t nBytes{0};
+};
+
+/// The slots.  The ring is charged to the memory budget for as long as
+/// it exists so a log's bookkeeping is visible to the shedding.
+struct Ring
+{
+    explicit Ring(const uint64_t capacityIn) :
+        slots(capacityIn),
+        capacity(capacityIn),
+        nBytes(static_cast<int64_t> (sizeof(Ring) + capacityIn*sizeof(Slot)))
+    {
+        MemoryBudget::getInstance().charge(nBytes);
+    }
+    ~Ring()
+    {
+        MemoryBudget::getInstance().release(nBytes);
+    }
+    Ring(const Ring &) = delete;
+    Ring& operator=(const Ring &) = delete;
+    /// The slot holding the packet with the given sequence number
+    [[nodiscard]] Slot &operator[](const uint64_t sequence) noexcept
+    {
+        return slots[sequence % capacity];
+    }
+    std::vector<Slot> slots;
+    uint64_t capacity{0};
+    int64_t nBytes{0};
+};
+
+}
+
+class BroadcastLog::BroadcastLogImpl
+{
+public:
+    explicit BroadcastLogImpl(const int capacity) :
+        mPublisherRing(std::make_shared<Ring> (static_cast<uint64_t> (capacity))),
+        mMaximumNumberOfPackets(static_cast<uint64_t> (capacity))
+    {
+        mRing.store(mPublisherRing, std::memory_order_release);
+    }
+
+    /// Appends the packet
+    void append(std::shared_ptr<const UDataPacketServiceAPI::V1::Packet> &&packet)
+    {
+        auto enqueueTime = Utilities::getNow<std::chrono::nanoseconds> ();
+        auto nBytes = static_cast<int64_t> (packet->ByteSizeLong());
+        // There is only one publisher so the head is mine to advance
+        auto sequence = mHead.load(std::memory_order_relaxed);
+        // Only grow the ring once it is full and allowed to hold more
+        if (sequence - mTail.load(std::memory_order_acquire) >=
+                mPublisherRing->capacity &&
+            mMaximumNumberOfPackets.load(std::memory_order_relaxed) >
+                mPublisherRing->capacity)
+        {
+            grow(sequence);
+        }
+        auto &slot = (*mPublisherRing)[sequence];
+        {
+        std::lock_guard<Slot> lock(slot);
+        if (slot.packet != nullptr)
+        {
+            mBytes.fetch_sub(slot.nBytes, std::memory_order_relaxed);
+        }
+        mBytes.fetch_add(nBytes, std::memory_order_relaxed);
+        packet.swap(slot.packet);
+        slot.enqueueTime = enqueueTime;
+        slot.sequence = sequence;
+        slot.nBytes = nBytes;
+        }
+        // The packet this replaced is released outside of the lock
+        mHead.store(sequence + 1, std::memory_order_release);
+        enforceRetention();
+    }
+
+    /// Moves the packets into a larger ring.  The ring doubles up to the
+    /// packet bound.  Readers still holding the old ring find its slots
+    /// emptied and move to the new one.
+    void grow(const uint64_t head)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto oldRing = mPublisherRing;
+        auto capacity
+            = std::min(2*oldRing->capacity,
+                       mMaximumNumberOfPackets.load(std::memory_order_relaxed));
+        auto ring = std::make_shared<Ring> (capacity);
+        auto first = std::max(mTail.load(std::memory_order_acquire),
+                              head > oldRing->capacity ?
+                              head - oldRing->capacity : 0);
+        for (auto i = first; i < head; ++i)
+        {
+            auto &oldSlot = (*oldRing)[i];
+            std::lock_guard<Slot> slotLock(oldSlot);
+            if (oldSlot.sequence != i){continue;}
+            auto &slot = (*ring)[i];
+            slot.packet = oldSlot.packet;
+            slot.enqueueTime = oldSlot.enqueueTime;
+            slot.sequence = oldSlot.sequence;
+            slot.nBytes = oldSlot.nBytes;
+        }
+        // Publish the new ring before emptying the old one
+        mRing.store(ring, std::memory_order_release);
+        mPublisherRing = std::move(ring);
+        for (auto i = first; i < head; ++i)
+        {
+            std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>
+                packet{nullptr};
+            auto &oldSlot = (*oldRing)[i];
+            std::lock_guard<Slot> slotLock(oldSlot);
+            packet.swap(oldSlot.packet);
+        }
+    }
+
+    /// Trims the oldest packets until the log is within both retention
+    /// bounds.  The newest packet is always retained.
+    void enforceRetention()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto head = mHead.load(std::memory_order_acquire);
+        if (head == 0){return;}
+        auto capacity = mPublisherRing->capacity;
+        auto first = std::max(mTail.load(std::memory_order_acquire),
+                              head > capacity ? head - capacity : 0);
+        auto sequence = first;
+        auto maximumNumberOfPackets
+            = mMaximumNumberOfPackets.load(std::memory_order_relaxed);
+        if (head - sequence > maximumNumberOfPackets)
+        {
+            sequence = head - maximumNumberOfPackets;
+        }
+        auto maximumBytes = mMaximumBytes.load(std::memory_order_relaxed);
+        if (maximumBytes > 0)
+        {
+            // What is left once the packet bound is met
+            auto bytes = mBytes.load(std::memory_order_relaxed);
+            for (auto i = first; i < sequence; ++i)
+            {
+                bytes = bytes - getBytes(i);
+            }
+            // Walk forward from the oldest packet until the rest fit
+            while (bytes > maximumBytes && sequence + 1 < head)
+            {
+                bytes = bytes - getBytes(sequence);
+                sequence = sequence + 1;
+            }
+        }
+        if (sequence > first){trimLocked(sequence);}
+    }
+
+    /// The size of the packet with the given sequence number or 0 if it is
+    /// no longer in the log
+    /// @note The caller must hold mMutex.
+    [[nodiscard]] int64_t getBytes(const uint64_t sequence) const
+    {
+        auto &slot = (*mPublisherRing)[sequence];
+        std::lock_guard<Slot> lock(slot);
+        if (slot.sequence == sequence && slot.packet != nullptr)
+        {
+            return slot.nBytes;
+        }
+        return 0;
+    }
+
+    /// Reads from the cursor toward the head
+    [[nodiscard]] int64_t read(
+        uint64_t &cursor,
+        const int maximumNumberOfPackets,
+        std::vector<std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>>
+            &packets) const
+    {
+        int64_t packetsDropped{0};
+        // The ring is loaded after the head so it holds everything
+        // before the head
+        auto head = mHead.load(std::memory_order_acquire);
+        auto ring = mRing.load(std::memory_order_acquire);
+        int nRead{0};
+        std::chrono::nanoseconds now{0};
+        while (cursor < head && nRead < maximumNumberOfPackets)
+        {
+            // Skip past whatever the publisher has lapped
+            if (head - cursor > ring->capacity)
+            {
+                packetsDropped
+                    += static_cast<int64_t> (head - ring->capacity - cursor);
+                cursor = head - ring->capacity;
+            }
+            // and whatever was trimmed
+            auto tail = mTail.load(std::memory_order_acquire);
+            if (cursor < tail)
+            {
+                packetsDropped += static_cast<int64_t> (tail - cursor);
+                cursor = tail;
+                continue;
+            }
+            std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>
+                packet{nullptr};
+            std::chrono::nanoseconds enqueueTime{0};
+            uint64_t sequence{0};
+            {
+            auto &slot = (*ring)[cursor];
+            std::lock_guard<Slot> lock(slot);
+            sequence = slot.sequence;
+            if (sequence == cursor)
+            {
+                packet = slot.packet;
+                enqueueTime = slot.enqueueTime;
+            }
+            }
+            if (packet == nullptr)
+            {
+                // The packet may have moved to a larger ring
+                auto latestRing = mRing.load(std::memory_order_acquire);
+                if (latestRing != ring)
+                {
+                    ring = std::move(latestRing);
+                    continue;
+                }
+            }
+            if (sequence > cursor)
+            {
+                // Overwritten since I read the head; catch up and retry
+                head = mHead.load(std::memory_order_acquire);
+                ring = mRing.load(std::memory_order_acquire);
+                continue;
+            }
+            if (packet == nullptr)
+            {
+                // Trimmed since I read the tail or lapped before the ring
+                // grew
+                packetsDropped = packetsDropped + 1;
+                cursor = cursor + 1;
+                continue;
+            }
+            packets.push_back(std::move(packet));
+            if (now.count() == 0)
+            {
+                now = Utilities::getNow<std::chrono::nanoseconds> ();
+            }
+            mMetrics.recordLatency(Metrics::LatencyStage::StreamQueue,
+                                   now - enqueueTime);
+            cursor = cursor + 1;
+            nRead = nRead + 1;
+        }
+        if (packetsDropped > 0)
+        {
+            mMetrics.addDroppedPackets(Metrics::DropLocation::BroadcastLog,
+                                       packetsDropped);
+        }
+        return packetsDropped;
+    }
+
+    /// Releases the packets before the given sequence number
+    void trim(const uint64_t sequence)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        trimLocked(sequence);
+    }
+
+    /// Releases the packets before the given sequence number
+    /// @note The caller must hold mMutex.
+    void trimLocked(uint64_t sequence)
+    {
+        auto head = mHead.load(std::memory_order_acquire);
+        sequence = std::min(sequence, head);
+        // Anything before this has been overwritten
+        auto capacity = mPublisherRing->capacity;
+        auto first = std::max(mTail.load(std::memory_order_acquire),
+                              head > capacity ? head - capacity : 0);
+        if (sequence <= first){return;}
+        mTail.store(sequence, std::memory_order_release);
+        for (auto i = first; i < sequence; ++i)
+        {
+            std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>
+                packet{nullptr};
+            auto &slot = (*mPublisherRing)[i];
+            std::lock_guard<Slot> lock(slot);
+            if (slot.sequence == i && slot.packet != nullptr)
+            {
+                mBytes.fetch_sub(slot.nBytes, std::memory_order_relaxed);
+                packet.swap(slot.packet);
+            }
+        }
+    }
+
+    /// Unread packets still in the log
+    [[nodiscard]] int getLag(uint64_t cursor) const noexcept
+    {
+        auto head = mHead.load(std::memory_order_acquire);
+        if (cursor >= head){return 0;}
+        cursor = std::max(cursor, mTail.load(std::memory_order_acquire));
+        if (cursor >= head){return 0;}
+        auto capacity = mRing.load(std::memory_order_acquire)->capacity;
+        return static_cast<int> (std::min(head - cursor, capacity));
+    }
+
+//private:
+    Metrics::MetricsSingleton &mMetrics
+    {
+        Metrics::MetricsSingleton::getInstance()
+    };
+    // The ring the readers use.  This is replaced when the ring grows.
+    std::atomic<std::shared_ptr<Ring>> mRing;
+    // The publisher's copy of the ring.  Only the publisher replaces this
+    // and it does so while holding mMutex.
+    std::shared_ptr<Ring> mPublisherRing{nullptr};
+    // Serializes trimming and growing the ring
+    std::mutex mMutex;
+    // Packets before this have been published
+    std::atomic<uint64_t> mHead{0};
+    // Packets before this were trimmed
+    std::atomic<uint64_t> mTail{0};
+    // The bytes of the packets in the log
+    std::atomic<int64_t> mBytes{0};
+    // The retention bounds.  A non-positive byte bound is unbounded.
+    std::atomic<uint64_t> mMaximumNumberOfPackets{8192};
+    std::atomic<int64_t> mMaximumBytes{0};
+};
+
+/// Constructor
+BroadcastLog::BroadcastLog(const int capacity)
+{
+    if (capacity <= 0)
+    {
+        throw std::invalid_argument("Capacity must be positive");
+    }
+    pImpl = std::make_unique<BroadcastLogImpl> (capacity);
+}
+
+/// Append
+void BroadcastLog::append(UDataPacketServiceAPI::V1::Packet &&packet)
+{
+    pImpl->append(std::make_shared<const UDataPacketServiceAPI::V1::Packet>
+                  (std::move(packet)));
+}
+
+void BroadcastLog::append(const UDataPacketServiceAPI::V1::Packet &packet)
+{
+    pImpl->append(std::make_shared<const UDataPacketServiceAPI::V1::Packet>
+                  (packet));
+}
+
+void BroadcastLog::append(
+    std::shared_ptr<const UDataPacketServiceAPI::V1::Packet> packet)
+{
+    if (packet == nullptr)
+    {
+        throw std::invalid_argument("Packet is null");
+    }
+    pImpl->append(std::move(packet));
+}
+
+/// Head
+uint64_t BroadcastLog::getHead() const noexcept
+{
+    return pImpl->mHead.load(std::memory_order_acquire);
+}
+
+/// Read
+int64_t BroadcastLog::read(
+    uint64_t &cursor,
+    const int maximumNumberOfPackets,
+    std::vector<std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>>
+        &packets) const
+{
+    if (maximumNumberOfPackets <= 0){return 0;}
+    return pImpl->read(cursor, maximumNumberOfPackets, packets);
+}
+
+/// Trim
+void BroadcastLog::trim(const uint64_t sequence)
+{
+    pImpl->trim(sequence);
+}
+
+/// Lag
+int BroadcastLog::getLag(const uint64_t cursor) const noexcept
+{
+    return pImpl->getLag(cursor);
+}
+
+/// Capacity
+int BroadcastLog::getCapacity() const noexcept
+{
+    return static_cast<int> (
+        pImpl->mRing.load(std::memory_order_acquire)->capacity);
+}
+
+/// Maximum number of packets
+void BroadcastLog::setMaximumNumberOfPackets(const int maximumNumberOfPackets)
+{
+    if (maximumNumberOfPackets <= 0)
+    {
+        throw std::invalid_argument(
+            "Maximum number of packets must be positive");
+    }
+    pImpl->mMaximumNumberOfPackets.store(
+        static_cast<uint64_t> (maximumNumberOfPackets),
+        std::memory_order_relaxed);
+    pImpl->enforceRetention();
+}
+
+int BroadcastLog::getMaximumNumberOfPackets() const noexcept
+{
+    return static_cast<int> (
+        pImpl->mMaximumNumberOfPackets.load(std::memory_order_relaxed));
+}
+
+/// Maximum bytes
+void BroadcastLog::setMaximumBytes(const int64_t maximumBytes)
+{
+    if (maximumBytes <= 0)
+    {
+        throw std::invalid_argument("Maximum bytes must be positive");
+    }
+    pImpl->mMaximumBytes.store(maximumBytes, std::memory_order_relaxed);
+    pImpl->enforceRetention();
+}
+
+std::optional<int64_t> BroadcastLog::getMaximumBytes() const noexcept
+{
+    auto maximumBytes = pImpl->mMaximumBytes.load(std::memory_order_relaxed);
+    if (maximumBytes > 0){return std::make_optional<int64_t> (maximumBytes);}
+    return std::nullopt;
+}
+
+/// Bytes
+int64_t BroadcastLog::getBytes() const noexcept
+{
+    return pImpl->mBytes.load(std::memory_order_relaxed);
+}
+
+/// Destructor
+BroadcastLog::~BroadcastLog() = default;
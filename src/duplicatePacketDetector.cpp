@@ -3,19 +3,21 @@
 #include <cmath>
 #include <algorithm>
 #include <chrono>
-#include <map>
+#include <memory>
 #include <set>
 #include <string>
 #ifndef NDEBUG
 #include <cassert>
 #endif
 #include <boost/circular_buffer.hpp>
+#include <oneapi/tbb/concurrent_map.h>
 #include <spdlog/spdlog.h>
 #include <google/protobuf/util/time_util.h>
 #include "uDataPacketService/duplicatePacketDetector.hpp"
 #include "uDataPacketServiceAPI/v1/packet.pb.h"
 
 import Utilities;
+import MemoryBudget;
 
 using namespace UDataPacketService;
 
@@ -96,6 +98,28 @@ public:
     int nSamples{0}; // Number of samples in packet
 };
 
+/// The recent packet headers of a stream.  The buffer is charged to the
+/// memory budget for as long as it exists.
+struct StreamHeaders
+{
+    explicit StreamHeaders(const int capacity) :
+        circularBuffer(capacity),
+        nBytes(static_cast<int64_t> (sizeof(StreamHeaders)
+                                   + capacity*sizeof(::DataPacketHeader)))
+    {
+        MemoryBudget::getInstance().charge(nBytes);
+    }
+    ~StreamHeaders()
+    {
+        MemoryBudget::getInstance().release(nBytes);
+    }
+    StreamHeaders(const StreamHeaders &) = delete;
+    StreamHeaders& operator=(const StreamHeaders &) = delete;
+    std::mutex mutex;
+    boost::circular_buffer<::DataPacketHeader> circularBuffer;
+    int64_t nBytes{0};
+};
+
 [[nodiscard]] int estimateCapacity(const ::DataPacketHeader &header,
                                    const std::chrono::seconds &memory)
 {
@@ -213,9 +237,10 @@ public:
         assert(!header.name.empty());
         assert(header.nSamples > 0);
 #endif
-        // Does this channel exist?
-        auto circularBufferIndex = mCircularBuffers.find(header.name);
-        if (circularBufferIndex == mCircularBuffers.end())
+        // Does this channel exist?  Streams are never removed so the
+        // lookup doesn't need a lock.
+        auto streamIndex = mStreams.find(header.name);
+        if (streamIndex == mStreams.end())
         {
             int capacity = mCircularBufferSize;
             if (mEstimateCapacity)
@@ -224,37 +249,26 @@ public:
                     = ::estimateCapacity(header,
                                          mCircularBufferDuration);
             }
-/*
-            spdlog::info("Creating new circular buffer for: "
-                       + header.name + " with capacity: "
-                       + std::to_string(capacity));
-*/
-            boost::circular_buffer<::DataPacketHeader>
-                newCircularBuffer(capacity);
-            newCircularBuffer.push_back(header);
-            mCircularBuffers.insert(std::pair{header.name,
-                                              std::move(newCircularBuffer)});
-            // Can't be a a duplicate because its the first one
-            return true;
-        }
-        // Now we should definitely be able to find the appropriate circular
-        // buffer for this stream 
-        circularBufferIndex = mCircularBuffers.find(header.name);
-        if (circularBufferIndex == mCircularBuffers.end())
-        {
-/*
-            spdlog::warn(
-                "Algorithm error - circular buffer doesn't exist for: "
-               + header.name);
-*/
-            return false;
+            auto newStream = std::make_unique<::StreamHeaders> (capacity);
+            newStream->circularBuffer.push_back(header);
+            // Another thread may have beaten us here with a copy of this
+            // packet in which case it was first
+            auto [idx, inserted]
+                = mStreams.emplace(header.name, std::move(newStream));
+            if (inserted){return true;}
+            streamIndex = idx;
         }
+        // Only this stream's arrivals contend for this lock
+        auto &stream = *streamIndex->second;
+        std::lock_guard<std::mutex> lock(stream.mutex);
+        auto &circularBuffer = stream.circularBuffer;
         // See if this header exists (exactly)
+        // (a copy from another import stream is usually the latest packet)
         auto headerIndex
-            = std::find(circularBufferIndex->second.begin(),
-                        circularBufferIndex->second.end(),
+            = std::find(circularBuffer.rbegin(),
+                        circularBuffer.rend(),
                         header);
-        if (headerIndex != circularBufferIndex->second.end())
+        if (headerIndex != circularBuffer.rend())
         {
 /*
             spdlog::debug("Detected duplicate for: "
@@ -263,26 +277,26 @@ public:
             return false;
         }
         // Insert it (typically new stuff shows up)
-        if (header.startTime > circularBufferIndex->second.back().endTime)
+        if (header.startTime > circularBuffer.back().endTime)
         {
 /*
             spdlog::debug("Inserting " + header.name
                         + " at end of circular buffer");
 */
-            circularBufferIndex->second.push_back(header);
+            circularBuffer.push_back(header);
             return true;
         }
         // If it is is really old and there's space then push to front
-        if (header.endTime < circularBufferIndex->second.front().startTime)
+        if (header.endTime < circularBuffer.front().startTime)
         {
-            if (!circularBufferIndex->second.full())
+            if (!circularBuffer.full())
             {
                 spdlog::debug("Inserting " + header.name 
                             + " at front of circular buffer");
-                circularBufferIndex->second.push_front(header);
+                circularBuffer.push_front(header);
 #ifndef NDEBUG
-                assert(std::is_sorted(circularBufferIndex->second.begin(),
-                                      circularBufferIndex->second.end(),
+                assert(std::is_sorted(circularBuffer.begin(),
+                                      circularBuffer.end(),
                        [](const ::DataPacketHeader &lhs, const ::DataPacketHeader &rhs)
                        {
                           return lhs.startTime < rhs.startTime;
@@ -294,7 +308,7 @@ public:
             return false;
         }
         // The packet is old.  We have to check for a GPS slip.
-        for (const auto &streamHeader : circularBufferIndex->second)
+        for (const auto &streamHeader : circularBuffer)
         {
             if ((header.startTime >= streamHeader.startTime &&
                  header.startTime <= streamHeader.endTime) ||
@@ -315,9 +329,9 @@ public:
         spdlog::debug("Inserting " + header.name
                     + " in circular buffer then sorting...");
 */
-        circularBufferIndex->second.push_back(header);
-        std::sort(circularBufferIndex->second.begin(),
-                  circularBufferIndex->second.end(),
+        circularBuffer.push_back(header);
+        std::sort(circularBuffer.begin(),
+                  circularBuffer.end(),
                   [](const ::DataPacketHeader &lhs, const ::DataPacketHeader &rhs)
                   {
                       return lhs.startTime < rhs.startTime;
@@ -327,9 +341,15 @@ public:
     DuplicatePacketDetectorImpl& operator=(const DuplicatePacketDetectorImpl &impl)
     {
         if (&impl == this){return *this;}
+        mStreams.clear();
+        for (const auto &stream : impl.mStreams)
         {
-        std::lock_guard<std::mutex> lockGuard(impl.mMutex);
-        mCircularBuffers = impl.mCircularBuffers;
+            std::lock_guard<std::mutex> lockGuard(stream.second->mutex);
+            auto copy
+                = std::make_unique<::StreamHeaders>
+                  (stream.second->circularBuffer.capacity());
+            copy->circularBuffer = stream.second->circularBuffer;
+            mStreams.emplace(stream.first, std::move(copy));
         }
         mCircularBufferDuration = impl.mCircularBufferDuration;
         mCircularBufferSize = impl.mCircularBufferSize;
@@ -337,9 +357,9 @@ public:
         return *this;
     }
 //private:
-    mutable std::mutex mMutex;
-    mutable std::map<std::string, boost::circular_buffer<::DataPacketHeader>>
-        mCircularBuffers;
+    mutable oneapi::tbb::concurrent_map<std::string,
+                                        std::unique_ptr<::StreamHeaders>>
+        mStreams;
     std::chrono::seconds mCircularBufferDuration{300};
     int mCircularBufferSize{100}; // ~3s packets 
     bool mEstimateCapacity{false};
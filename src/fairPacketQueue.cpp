@@ -0,0 +1,303 @@
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <deque>
+#include <list>
+#include <array>
+#include <chrono>
+#include <string>
+#include <stdexcept>
+#include <unordered_map>
+#ifndef NDEBUG
+#include <cassert>
+#endif
+#include "uDataPacketService/fairPacketQueue.hpp"
+#include "uDataPacketServiceAPI/v1/packet.pb.h"
+
+import Utilities;
+import Metrics;
+import MemoryBudget;
+
+using namespace UDataPacketService;
+
+namespace
+{
+
+/// A queued packet.
+struct Entry
+{
+    UDataPacketServiceAPI::V1::Packet packet;
+    std::chrono::nanoseconds receivedTime{0};
+    int64_t nBytes{0};
+};
+
+/// A stream's queue.  A stream is only tracked while it has packets.
+struct StreamQueue
+{
+    std::string name;
+    std::deque<Entry> entries;
+    /// The bytes the stream may still send in its current turn.
+    int64_t deficit{0};
+    /// The stream's place in the round-robin.
+    std::list<StreamQueue *>::iterator position;
+};
+
+/// A lane's streams and their round-robin.
+struct LaneQueue
+{
+    // The streams with queued packets.  Node-based so the round-robin can
+    // hold pointers to them.
+    std::unordered_map<std::string, StreamQueue> streams;
+    // The round-robin.  The front stream is the one being served.
+    std::list<StreamQueue *> active;
+    // The stream with the most packets, if known
+    StreamQueue *longest{nullptr};
+    size_t size{0};
+    bool turnStarted{false};
+};
+
+}
+
+class FairPacketQueue::FairPacketQueueImpl
+{
+public:
+    FairPacketQueueImpl(const int capacity, const int quantum) :
+        mCapacity(static_cast<size_t> (capacity)),
+        mQuantum(quantum)
+    {
+    }
+
+    ~FairPacketQueueImpl()
+    {
+        mMemoryBudget.release(mBytes);
+    }
+
+    /// Adds the packet to its stream's queue in the lane
+    void push(UDataPacketServiceAPI::V1::Packet &&packet,
+              const std::chrono::nanoseconds &receivedTime,
+              const Lane laneIdentifier)
+    {
+        auto name = Utilities::toName(packet);
+        auto nBytes = static_cast<int64_t> (packet.ByteSizeLong());
+        std::lock_guard<std::mutex> lock(mMutex);
+        while (mSize >= mCapacity){dropOne(name);}
+        auto &lane = mLanes[static_cast<size_t> (laneIdentifier)];
+        auto [idx, inserted] = lane.streams.try_emplace(name);
+        auto stream = &idx->second;
+        if (inserted)
+        {
+            stream->name = std::move(name);
+            stream->position = lane.active.insert(lane.active.end(), stream);
+        }
+        stream->entries.push_back(Entry {std::move(packet), receivedTime, nBytes});
+        lane.size = lane.size + 1;
+        mSize = mSize + 1;
+        mBytes = mBytes + nBytes;
+        mMemoryBudget.charge(nBytes);
+        if (lane.longest == nullptr ||
+            stream->entries.size() > lane.longest->entries.size())
+        {
+            lane.longest = stream;
+        }
+        updateCounters();
+    }
+
+    /// Takes the next packet in deficit round-robin order from the
+    /// highest priority lane with packets
+    [[nodiscard]] bool tryPop(UDataPacketServiceAPI::V1::Packet &packet,
+                              std::chrono::nanoseconds &receivedTime)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        LaneQueue *lane{nullptr};
+        for (auto &candidate : mLanes)
+        {
+            if (!candidate.active.empty())
+            {
+                lane = &candidate;
+                break;
+            }
+        }
+        if (lane == nullptr){return false;}
+        while (true)
+        {
+            auto stream = lane->active.front();
+            // A new turn tops up the stream's deficit
+            if (!lane->turnStarted)
+            {
+                stream->deficit = stream->deficit + mQuantum;
+                lane->turnStarted = true;
+            }
+            auto &entry = stream->entries.front();
+            if (entry.nBytes <= stream->deficit)
+            {
+                stream->deficit = stream->deficit - entry.nBytes;
+                packet = std::move(entry.packet);
+                receivedTime = entry.receivedTime;
+                popFront(*lane, *stream);
+                return true;
+            }
+            // The stream's turn is over; it keeps its deficit
+            lane->active.splice(lane->active.end(), lane->active,
+                                lane->active.begin());
+            lane->turnStarted = false;
+        }
+    }
+
+    /// Drops the oldest packet of the longest stream in the lowest
+    /// priority lane with packets.  The stream receiving the packet is
+    /// checked first since under a flood it is usually the culprit.
+    /// @note The caller must hold mMutex.
+    void dropOne(const std::string &name)
+    {
+        auto &lane = mLanes[static_cast<size_t> (Lane::Backfill)].size > 0 ?
+                     mLanes[static_cast<size_t> (Lane::Backfill)] :
+                     mLanes[static_cast<size_t> (Lane::RealTime)];
+        StreamQueue *victim{nullptr};
+        auto idx = lane.streams.find(name);
+        if (idx != lane.streams.end() &&
+            idx->second.entries.size()*lane.active.size() >= lane.size)
+        {
+            victim = &idx->second;
+        }
+        else if (lane.longest != nullptr)
+        {
+            victim = lane.longest;
+        }
+        else
+        {
+            for (auto &stream : lane.streams)
+            {
+                if (victim == nullptr ||
+                    stream.second.entries.size() > victim->entries.size())
+                {
+                    victim = &stream.second;
+                }
+            }
+            lane.longest = victim;
+        }
+#ifndef NDEBUG
+        assert(victim != nullptr);
+        assert(!victim->entries.empty());
+#endif
+        popFront(lane, *victim);
+        mNumberOfDroppedPackets.fetch_add(1, std::memory_order_relaxed);
+        mMetrics.incrementDroppedPacketsCounter(
+            Metrics::DropLocation::ImportQueue);
+    }
+
+    /// Removes the stream's oldest packet and, if that was its last, the
+    /// stream.
+    /// @note The caller must hold mMutex.
+    void popFront(LaneQueue &lane, StreamQueue &stream)
+    {
+        auto nBytes = stream.entries.front().nBytes;
+        stream.entries.pop_front();
+        lane.size = lane.size - 1;
+        mSize = mSize - 1;
+        mBytes = mBytes - nBytes;
+        mMemoryBudget.release(nBytes);
+        if (stream.entries.empty())
+        {
+            // An idle stream does not bank its deficit
+            if (stream.position == lane.active.begin())
+            {
+                lane.turnStarted = false;
+            }
+            lane.active.erase(stream.position);
+            if (lane.longest == &stream){lane.longest = nullptr;}
+            lane.streams.erase(lane.streams.find(stream.name));
+        }
+        updateCounters();
+    }
+
+    /// Publishes the sizes for the lock-free getters.
+    /// @note The caller must hold mMutex.
+    void updateCounters()
+    {
+        size_t nStreams{0};
+        for (size_t i = 0; i < mLanes.size(); ++i)
+        {
+            nStreams = nStreams + mLanes[i].streams.size();
+            mLaneSizes[i].store(static_cast<int> (mLanes[i].size),
+                                std::memory_order_relaxed);
+        }
+        mNumberOfPackets.store(static_cast<int> (mSize),
+                               std::memory_order_relaxed);
+        mNumberOfStreams.store(static_cast<int> (nStreams),
+                               std::memory_order_relaxed);
+    }
+
+//private:
+    mutable std::mutex mMutex;
+    Metrics::MetricsSingleton &mMetrics
+    {
+        Metrics::MetricsSingleton::getInstance()
+    };
+    MemoryBudget &mMemoryBudget{MemoryBudget::getInstance()};
+    // The lanes in priority order
+    std::array<LaneQueue, 2> mLanes;
+    std::array<std::atomic<int>, 2> mLaneSizes{0, 0};
+    size_t mCapacity{8192};
+    size_t mSize{0};
+    int64_t mBytes{0};
+    int64_t mQuantum{4096};
+    std::atomic<int64_t> mNumberOfDroppedPackets{0};
+    std::atomic<int> mNumberOfPackets{0};
+    std::atomic<int> mNumberOfStreams{0};
+};
+
+/// Constructor
+FairPacketQueue::FairPacketQueue(const int capacity, const int quantum)
+{
+    if (capacity <= 0)
+    {
+        throw std::invalid_argument("Capacity must be positive");
+    }
+    if (quantum <= 0)
+    {
+        throw std::invalid_argument("Quantum must be positive");
+    }
+    pImpl = std::make_unique<FairPacketQueueImpl> (capacity, quantum);
+}
+
+/// Push
+void FairPacketQueue::push(UDataPacketServiceAPI::V1::Packet &&packet,
+                           const std::chrono::nanoseconds &receivedTime,
+                           const Lane lane)
+{
+    pImpl->push(std::move(packet), receivedTime, lane);
+}
+
+/// Pop
+bool FairPacketQueue::tryPop(UDataPacketServiceAPI::V1::Packet &packet,
+                             std::chrono::nanoseconds &receivedTime)
+{
+    return pImpl->tryPop(packet, receivedTime);
+}
+
+/// Size
+int FairPacketQueue::size() const noexcept
+{
+    return pImpl->mNumberOfPackets.load(std::memory_order_relaxed);
+}
+
+int FairPacketQueue::size(const Lane lane) const noexcept
+{
+    return pImpl->mLaneSizes[static_cast<size_t> (lane)].load(
+        std::memory_order_relaxed);
+}
+
+/// Number of streams
+int FairPacketQueue::getNumberOfStreams() const noexcept
+{
+    return pImpl->mNumberOfStreams.load(std::memory_order_relaxed);
+}
+
+/// Dropped packets
+int64_t FairPacketQueue::getNumberOfDroppedPackets() const noexcept
+{
+    return pImpl->mNumberOfDroppedPackets.load(std::memory_order_relaxed);
+}
+
+/// Destructor
+FairPacketQueue::~FairPacketQueue() = default;
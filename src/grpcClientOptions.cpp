@@ -1,4 +1,5 @@
 #include <string>
+#include <chrono>
 #include <algorithm>
 #include <filesystem>
 #include "uDataPacketService/grpcClientOptions.hpp"
@@ -13,11 +14,19 @@ public:
     std::string mServerCertificate;
     std::string mClientCertificate;
     std::string mClientKey;
+    std::chrono::milliseconds mKeepAliveTime{0};
+    std::chrono::milliseconds mKeepAliveTimeout{20000};
+    int mMaximumReceiveMessageSize{4*1024*1024};
+    int mHTTP2InitialWindowSize{0};
     uint16_t mPort{50000};
     bool mHaveServerCertificate{false}; 
     bool mHaveClientCertificate{false};
     bool mHaveClientKey{false};
     bool mHaveAccessToken{false};
+    bool mHaveKeepAliveTime{false};
+    bool mHaveHTTP2InitialWindowSize{false};
+    bool mEnableBDPProbe{true};
+    bool mUseDedicatedConnection{false};
 };
 
 /// Constructor
@@ -165,3 +174,93 @@ std::optional<std::string> GRPCClientOptions::getAccessToken() const noexcept
            std::make_optional<std::string> (pImpl->mAccessToken) : std::nullopt;
 }
 
+/// Keepalive
+void GRPCClientOptions::setKeepAliveTime(
+    const std::chrono::milliseconds &keepAliveTime)
+{
+    if (keepAliveTime.count() <= 0)
+    {
+        throw std::invalid_argument("Keepalive time must be positive");
+    }
+    pImpl->mKeepAliveTime = keepAliveTime;
+    pImpl->mHaveKeepAliveTime = true;
+}
+
+std::optional<std::chrono::milliseconds>
+    GRPCClientOptions::getKeepAliveTime() const noexcept
+{
+    return pImpl->mHaveKeepAliveTime ?
+           std::make_optional<std::chrono::milliseconds> (pImpl->mKeepAliveTime) :
+           std::nullopt;
+}
+
+void GRPCClientOptions::setKeepAliveTimeout(
+    const std::chrono::milliseconds &keepAliveTimeout)
+{
+    if (keepAliveTimeout.count() <= 0)
+    {
+        throw std::invalid_argument("Keepalive timeout must be positive");
+    }
+    pImpl->mKeepAliveTimeout = keepAliveTimeout;
+}
+
+std::chrono::milliseconds GRPCClientOptions::getKeepAliveTimeout() const noexcept
+{
+    return pImpl->mKeepAliveTimeout;
+}
+
+/// Max receive message size
+void GRPCClientOptions::setMaximumReceiveMessageSize(const int maximumSize)
+{
+    if (maximumSize <= 0)
+    {
+        throw std::invalid_argument(
+            "Maximum receive message size must be positive");
+    }
+    pImpl->mMaximumReceiveMessageSize = maximumSize;
+}
+
+int GRPCClientOptions::getMaximumReceiveMessageSize() const noexcept
+{
+    return pImpl->mMaximumReceiveMessageSize;
+}
+
+/// HTTP/2 window
+void GRPCClientOptions::setHTTP2InitialWindowSize(const int windowSize)
+{
+    if (windowSize <= 0)
+    {
+        throw std::invalid_argument("HTTP/2 window size must be positive");
+    }
+    pImpl->mHTTP2InitialWindowSize = windowSize;
+    pImpl->mHaveHTTP2InitialWindowSize = true;
+}
+
+std::optional<int> GRPCClientOptions::getHTTP2InitialWindowSize() const noexcept
+{
+    return pImpl->mHaveHTTP2InitialWindowSize ?
+           std::make_optional<int> (pImpl->mHTTP2InitialWindowSize) :
+           std::nullopt;
+}
+
+/// BDP probe
+void GRPCClientOptions::enableBDPProbe(const bool enable) noexcept
+{
+    pImpl->mEnableBDPProbe = enable;
+}
+
+bool GRPCClientOptions::isBDPProbeEnabled() const noexcept
+{
+    return pImpl->mEnableBDPProbe;
+}
+
+/// Dedicated connection
+void GRPCClientOptions::useDedicatedConnection(const bool use) noexcept
+{
+    pImpl->mUseDedicatedConnection = use;
+}
+
+bool GRPCClientOptions::useDedicatedConnection() const noexcept
+{
+    return pImpl->mUseDedicatedConnection;
+}
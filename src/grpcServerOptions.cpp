@@ -1,4 +1,5 @@
 #include <string>
+#include <chrono>
 #include <algorithm>
 #include <filesystem>
 #include "uDataPacketService/grpcServerOptions.hpp"
@@ -13,11 +14,28 @@ public:
     std::string mServerCertificate;
     std::string mServerKey;
     std::string mClientCertificate;
+    std::chrono::milliseconds mKeepAliveTime{0};
+    std::chrono::milliseconds mKeepAliveTimeout{20000};
+    std::chrono::milliseconds mMinimumClientPingInterval{300000};
+    int64_t mMemoryQuota{0};
+    int mMaximumReceiveMessageSize{4*1024*1024};
+    int mMaximumSendMessageSize{0};
+    int mHTTP2WriteBufferSize{0};
+    int mMaximumConcurrentStreams{0};
     uint16_t mPort{50000};
     bool mHaveServerCertificate{false}; 
     bool mHaveServerKey{false};
     bool mHaveClientCertificate{false};
     bool mHaveAccessToken{false};
+    bool mHaveKeepAliveTime{false};
+    bool mHaveMemoryQuota{false};
+    bool mHaveMaximumReceiveMessageSize{false};
+    bool mHaveMinimumClientPingInterval{false};
+    bool mHavePermitKeepAliveWithoutCalls{false};
+    bool mHaveMaximumSendMessageSize{false};
+    bool mHaveHTTP2WriteBufferSize{false};
+    bool mHaveMaximumConcurrentStreams{false};
+    bool mPermitKeepAliveWithoutCalls{false};
 };
 
 /// Constructor
@@ -165,3 +183,163 @@ std::optional<std::string> GRPCServerOptions::getAccessToken() const noexcept
            std::make_optional<std::string> (pImpl->mAccessToken) : std::nullopt;
 }
 
+/// Memory quota
+void GRPCServerOptions::setMemoryQuota(const int64_t memoryQuota)
+{
+    if (memoryQuota <= 0)
+    {
+        throw std::invalid_argument("Memory quota must be positive");
+    }
+    pImpl->mMemoryQuota = memoryQuota;
+    pImpl->mHaveMemoryQuota = true;
+}
+
+std::optional<int64_t> GRPCServerOptions::getMemoryQuota() const noexcept
+{
+    return pImpl->mHaveMemoryQuota ?
+           std::make_optional<int64_t> (pImpl->mMemoryQuota) : std::nullopt;
+}
+
+/// Message sizes
+void GRPCServerOptions::setMaximumReceiveMessageSize(const int maximumSize)
+{
+    if (maximumSize <= 0)
+    {
+        throw std::invalid_argument(
+            "Maximum receive message size must be positive");
+    }
+    pImpl->mMaximumReceiveMessageSize = maximumSize;
+    pImpl->mHaveMaximumReceiveMessageSize = true;
+}
+
+std::optional<int>
+    GRPCServerOptions::getMaximumReceiveMessageSize() const noexcept
+{
+    return pImpl->mHaveMaximumReceiveMessageSize ?
+           std::make_optional<int> (pImpl->mMaximumReceiveMessageSize) :
+           std::nullopt;
+}
+
+void GRPCServerOptions::setMaximumSendMessageSize(const int maximumSize)
+{
+    if (maximumSize <= 0)
+    {
+        throw std::invalid_argument(
+            "Maximum send message size must be positive");
+    }
+    pImpl->mMaximumSendMessageSize = maximumSize;
+    pImpl->mHaveMaximumSendMessageSize = true;
+}
+
+std::optional<int> GRPCServerOptions::getMaximumSendMessageSize() const noexcept
+{
+    return pImpl->mHaveMaximumSendMessageSize ?
+           std::make_optional<int> (pImpl->mMaximumSendMessageSize) :
+           std::nullopt;
+}
+
+/// HTTP/2 write buffer
+void GRPCServerOptions::setHTTP2WriteBufferSize(const int bufferSize)
+{
+    if (bufferSize <= 0)
+    {
+        throw std::invalid_argument("Write buffer size must be positive");
+    }
+    pImpl->mHTTP2WriteBufferSize = bufferSize;
+    pImpl->mHaveHTTP2WriteBufferSize = true;
+}
+
+std::optional<int> GRPCServerOptions::getHTTP2WriteBufferSize() const noexcept
+{
+    return pImpl->mHaveHTTP2WriteBufferSize ?
+           std::make_optional<int> (pImpl->mHTTP2WriteBufferSize) :
+           std::nullopt;
+}
+
+/// Concurrent streams
+void GRPCServerOptions::setMaximumConcurrentStreams(const int nStreams)
+{
+    if (nStreams <= 0)
+    {
+        throw std::invalid_argument(
+            "Maximum number of concurrent streams must be positive");
+    }
+    pImpl->mMaximumConcurrentStreams = nStreams;
+    pImpl->mHaveMaximumConcurrentStreams = true;
+}
+
+std::optional<int> GRPCServerOptions::getMaximumConcurrentStreams() const noexcept
+{
+    return pImpl->mHaveMaximumConcurrentStreams ?
+           std::make_optional<int> (pImpl->mMaximumConcurrentStreams) :
+           std::nullopt;
+}
+
+/// Keepalive
+void GRPCServerOptions::setKeepAliveTime(
+    const std::chrono::milliseconds &keepAliveTime)
+{
+    if (keepAliveTime.count() <= 0)
+    {
+        throw std::invalid_argument("Keepalive time must be positive");
+    }
+    pImpl->mKeepAliveTime = keepAliveTime;
+    pImpl->mHaveKeepAliveTime = true;
+}
+
+std::optional<std::chrono::milliseconds>
+    GRPCServerOptions::getKeepAliveTime() const noexcept
+{
+    return pImpl->mHaveKeepAliveTime ?
+           std::make_optional<std::chrono::milliseconds> (pImpl->mKeepAliveTime) :
+           std::nullopt;
+}
+
+void GRPCServerOptions::setKeepAliveTimeout(
+    const std::chrono::milliseconds &keepAliveTimeout)
+{
+    if (keepAliveTimeout.count() <= 0)
+    {
+        throw std::invalid_argument("Keepalive timeout must be positive");
+    }
+    pImpl->mKeepAliveTimeout = keepAliveTimeout;
+}
+
+std::chrono::milliseconds GRPCServerOptions::getKeepAliveTimeout() const noexcept
+{
+    return pImpl->mKeepAliveTimeout;
+}
+
+void GRPCServerOptions::setMinimumClientPingInterval(
+    const std::chrono::milliseconds &interval)
+{
+    if (interval.count() <= 0)
+    {
+        throw std::invalid_argument("Minimum ping interval must be positive");
+    }
+    pImpl->mMinimumClientPingInterval = interval;
+    pImpl->mHaveMinimumClientPingInterval = true;
+}
+
+std::optional<std::chrono::milliseconds>
+    GRPCServerOptions::getMinimumClientPingInterval() const noexcept
+{
+    return pImpl->mHaveMinimumClientPingInterval ?
+           std::make_optional<std::chrono::milliseconds>
+              (pImpl->mMinimumClientPingInterval) :
+           std::nullopt;
+}
+
+void GRPCServerOptions::permitKeepAliveWithoutCalls(const bool permit) noexcept
+{
+    pImpl->mPermitKeepAliveWithoutCalls = permit;
+    pImpl->mHavePermitKeepAliveWithoutCalls = true;
+}
+
+std::optional<bool>
+    GRPCServerOptions::permitKeepAliveWithoutCalls() const noexcept
+{
+    return pImpl->mHavePermitKeepAliveWithoutCalls ?
+           std::make_optional<bool> (pImpl->mPermitKeepAliveWithoutCalls) :
+           std::nullopt;
+}
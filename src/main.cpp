@@ -3,357 +3,13 @@ import Logger;
 import Metrics;
 import Utilities;
 //import Server;
-import PacketConverter;
+import Process;
 
 #include <iostream>
-#include <csignal>
 #include <filesystem>
-#include <atomic>
-#include <condition_variable>
-#include <mutex>
-#ifndef NDEBUG
-#include <cassert>
-#endif
-#include <opentelemetry/metrics/meter_provider.h>
-#include <opentelemetry/metrics/provider.h>
 #include <absl/log/initialize.h>
-#include <oneapi/tbb/concurrent_queue.h>
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
-#include "uDataPacketImportAPI/v1/packet.pb.h"
-#include "uDataPacketServiceAPI/v1/packet.pb.h"
-#include "uDataPacketService/server.hpp"
-#include "uDataPacketService/serverOptions.hpp"
-#include "uDataPacketService/subscriber.hpp"
-#include "uDataPacketService/subscriptionManager.hpp"
-
-namespace
-{   
-std::atomic<bool> mInterrupted{false};
-
-opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>
-    totalPacketsReceivedCounter;
-opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>
-    totalPacketsSentCounter;
-opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>
-    utilizationGauge;
-
-
-class Process
-{
-public:
-    Process(const UDataPacketService::ProgramOptions &options,
-            std::shared_ptr<spdlog::logger> logger) :
-        mOptions(options),
-        mLogger(logger)
-    {
-#ifndef NDEBUG
-        assert(mLogger != nullptr);
-#endif
-        mSubscriber
-            = std::make_unique<UDataPacketService::Subscriber>
-              (mOptions.subscriberOptions, mAddPacketCallbackFunction, mLogger);
-        mService 
-            = std::make_unique<UDataPacketService::Server>
-              (mOptions.serverOptions, mLogger);
-        mSubscriptionManager
-            = std::make_unique<UDataPacketService::SubscriptionManager>
-              (mOptions.subscriptionManagerOptions, mLogger);
-        mMaximumImportQueueSize = mOptions.maximumImportQueueSize;
-        mImportQueue.set_capacity(mMaximumImportQueueSize);
-
-        if (mOptions.exportMetrics)
-        {
-            // Need a provider from which to get a meter.  This is initialized
-            // once and should last the duration of the application.
-            auto provider 
-                = opentelemetry::metrics::Provider::GetMeterProvider();
-    
-            // Meter will be bound to application (library, module, class, etc.)
-            // so as to identify who is genreating these metrics.
-            auto meter = provider->GetMeter(mOptions.applicationName, "1.2.0");
-
-            namespace UMetrics = UDataPacketService::Metrics;
-            // Packets received from import
-            totalPacketsReceivedCounter
-                = meter->CreateInt64ObservableCounter(
-                    "seismic_data.import.grpc.client.packets.received",
-                    "Number of packets received from the gRPC import data packet proxy.",
-                    "{packets}");
-            totalPacketsReceivedCounter->AddCallback(
-                UMetrics::observeNumberOfPacketsReceived,
-                nullptr);
-
-            // Total packets sent
-            totalPacketsSentCounter
-                = meter->CreateInt64ObservableCounter(
-                    "seismic_data.import.grpc.server.packets.sent",
-                    "Number of packets sent from the gRPC seismic data packet service.",
-                    "{packets}");
-            totalPacketsSentCounter->AddCallback(
-                UMetrics::observeNumberOfPacketsSent,
-                nullptr);
-
-            // Utilization
-            utilizationGauge
-                = meter->CreateDoubleObservableGauge(
-                  "seismic_data.import.grpc.server.utilization",
-                  "Proportion of subscribers receiving packets from the service.",
-                  "");
-            utilizationGauge->AddCallback(
-                UMetrics::observeUtilization,
-                nullptr);
-
-
-        }
-    }
-
-    ~Process()
-    {
-        stop();
-    }
-
-    void stop()
-    {
-        mKeepRunning.store(false);
-        // Stop receiving packets
-        if (mSubscriber){mSubscriber->stop();}
-        std::this_thread::sleep_for(std::chrono::milliseconds {25});
-        // Stop sending packets
-        if (mService){mService->stop();}
-        // Check my futures
-        for (auto &future : mFutures)
-        {   
-            if (future.valid()){future.get();}
-        }   
-    }
-
-    void start()
-    {
-#ifndef NDEBUG
-        assert(mLogger != nullptr);
-        assert(mSubscriber != nullptr);
-        assert(mService != nullptr);
-#endif
-        mKeepRunning.store(true);
-        mFutures.push_back(std::async(&Process::propagateImportPackets, this));
-        mService->start();
-        mFutures.push_back(mSubscriber->start());
-        handleMainThread();
-    }
-
-    void addPacketCallback(UDataPacketImportAPI::V1::Packet &&inputPacket)
-    {
-        try
-        {
-            auto newPacket
-                = UDataPacketService::convert(std::move(inputPacket));
-            while (mImportQueue.size() >= mMaximumImportQueueSize)
-            {   
-                UDataPacketServiceAPI::V1::Packet workSpace;
-                if (!mImportQueue.try_pop(workSpace))
-                {   
-                    SPDLOG_LOGGER_WARN(mLogger, 
-                        "Failed to pop front of queue while adding packet");
-                    break;
-                }   
-            }   
-            // Send the packet
-            if (!mImportQueue.try_push(std::move(newPacket)))
-            {   
-                SPDLOG_LOGGER_WARN(mLogger,
-                    "Failed to add packet to import queue");
-            }
-        }
-        catch (const std::exception &e)
-        {
-            SPDLOG_LOGGER_WARN(mLogger,
-                               "Failed to add packet because {}",
-                               std::string {e.what()});
-        }
-    } 
-
-    /// Sends the import packets to the client(s)
-    void propagateImportPackets()
-    {
-#ifndef NDEBUG
-        assert(mLogger != nullptr);
-        assert(mSubscriptionManager != nullptr);
-#endif
-        const std::chrono::microseconds timeOut{10};
-        while (mKeepRunning.load())
-        {
-            UDataPacketServiceAPI::V1::Packet packet;
-            if (mImportQueue.try_pop(packet))
-            {
-                try
-                {
-                    mService->enqueuePacket(std::move(packet));
-                }
-                catch (const std::exception &e)
-                {
-                    SPDLOG_LOGGER_WARN(mLogger,
-                "Failed to enqueue packet into subscription manager because {}",
-                                       std::string {e.what()});
-                }
-            }
-            else
-            {
-                std::this_thread::sleep_for(timeOut); 
-            }
-        }
-    }
-
-    // Print some summary statistics
-    void printSummary()
-    {
-        if (mOptions.printSummaryInterval.count() <= 0){return;}
-        auto now
-            = std::chrono::duration_cast<std::chrono::microseconds>
-              ((std::chrono::high_resolution_clock::now()).time_since_epoch());
-        if (now > mLastPrintSummary + mOptions.printSummaryInterval)
-        {
-            auto &metrics
-                = UDataPacketService::Metrics::MetricsSingleton::getInstance();
-            mLastPrintSummary = now;
-            auto nSubscribers = mService->getNumberOfSubscribers();
-            if (mOptions.exportMetrics)
-            {
-                int64_t currentNumberOfPacketsReceived
-                    = metrics.getReceivedPacketsCount();
-                auto reportPacketsReceived = currentNumberOfPacketsReceived
-                                           - mReportNumberOfPacketsReceived;
-                SPDLOG_LOGGER_INFO(mLogger,
-                                   "Received {} packets since last update.  Currently servicing {} subscribers.",
-                                   reportPacketsReceived, nSubscribers);
-                mReportNumberOfPacketsReceived = reportPacketsReceived;
-            }
-            else
-            {
-                SPDLOG_LOGGER_INFO(mLogger,
-                                   "Currently servicing {} subscribers.",
-                                   nSubscribers);
-            }
-        }
-    }
-
-    /// Check futures
-    [[nodiscard]]
-    bool checkFuturesOkay(const std::chrono::milliseconds &timeOut)
-    {
-        bool isOkay{true};
-        for (auto &future : mFutures)
-        {
-            try
-            {
-                auto status = future.wait_for(timeOut);
-                if (status == std::future_status::ready)
-                {
-                    future.get();
-                }
-            }
-            catch (const std::exception &e)
-            {
-                SPDLOG_LOGGER_CRITICAL(mLogger,
-                                       "Fatal error detected from thread: {}",
-                                       std::string {e.what()});
-                isOkay = false;
-            }
-        }
-        return isOkay;
-    }
-
-    // Let main thread handle signals from OS and deal with exceptions
-    void handleMainThread()
-    {
-        SPDLOG_LOGGER_DEBUG(mLogger, "Main thread entering waiting loop");
-        catchSignals();
-        while (!mStopRequested)
-        {
-            if (mInterrupted)
-            {   
-                SPDLOG_LOGGER_INFO(mLogger,
-                                   "SIGINT/SIGTERM signal received!");
-                mStopRequested = true;
-                mShutdownRequested = true;
-                mShutdownCondition.notify_all();
-                break;
-            }
-            if (!checkFuturesOkay(std::chrono::milliseconds {5}))
-            {
-                SPDLOG_LOGGER_CRITICAL(
-                   mLogger,
-                   "Futures exception caught; terminating app");
-                mStopRequested = true;
-                mShutdownRequested = true;
-                mShutdownCondition.notify_all();
-                break;
-            }
-            printSummary();
-            std::unique_lock<std::mutex> lock(mStopMutex);
-            mStopCondition.wait_for(lock,
-                                    std::chrono::milliseconds {100},
-                                    [this]
-                                    {
-                                          return mStopRequested;
-                                    });
-            lock.unlock();
-        }
-        if (mStopRequested)
-        {
-            SPDLOG_LOGGER_DEBUG(mLogger, "Stop request received.  Exiting...");
-            stop();
-        }
-    }
-
-    /// Handles sigterm and sigint
-    static void signalHandler(const int )
-    {   
-        mInterrupted = true;
-    }
-
-    static void catchSignals()
-    {   
-        struct sigaction action;
-        action.sa_handler = signalHandler;
-        action.sa_flags = 0;
-        sigemptyset(&action.sa_mask);
-        sigaction(SIGINT,  &action, NULL);
-        sigaction(SIGTERM, &action, NULL);
-    }   
-
-//private:
-    UDataPacketService::ProgramOptions mOptions; 
-    std::shared_ptr<spdlog::logger> mLogger{nullptr};
-    std::unique_ptr<UDataPacketService::Subscriber> mSubscriber{nullptr};
-    std::shared_ptr<UDataPacketService::SubscriptionManager>
-        mSubscriptionManager{nullptr};
-    std::unique_ptr<UDataPacketService::Server> mService{nullptr};
-    std::vector<std::future<void>> mFutures;
-    oneapi::tbb::concurrent_bounded_queue<UDataPacketServiceAPI::V1::Packet>
-        mImportQueue;
-    std::function<void(UDataPacketImportAPI::V1::Packet &&)>
-        mAddPacketCallbackFunction
-    {
-        std::bind(&::Process::addPacketCallback, this,
-                  std::placeholders::_1)
-    };  
-    mutable std::mutex mStopMutex;
-    mutable std::mutex mShutdownMutex;
-    std::condition_variable mStopCondition;
-    std::condition_variable mShutdownCondition;
-    std::chrono::microseconds mLastPrintSummary
-    {
-        UDataPacketService::Utilities::getNow<std::chrono::microseconds> ()
-    };
-    int64_t mReportNumberOfPacketsReceived{0};
-    int mMaximumImportQueueSize{8192};
-    std::atomic<bool> mKeepRunning{true};
-    bool mStopRequested{false};
-    bool mShutdownRequested{false};
-};
-
-}
 
 int main(int argc, char *argv[])
 {
@@ -423,8 +79,11 @@ int main(int argc, char *argv[])
     //absl::InitializeLog();
     try
     {
-        ::Process process(programOptions, logger);
+        // The process has to finish logging before the logger is cleaned up
+        {
+        UDataPacketService::Process process(programOptions, logger);
         process.start();
+        }
         UDataPacketService::Metrics::cleanup();
         UDataPacketService::Logger::cleanup();
     }
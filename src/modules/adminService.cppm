@@ -0,0 +1,201 @@
+module;
+#include <string>
+#include <vector>
+#include <set>
+#include <memory>
+#include <algorithm>
+#include <grpcpp/grpcpp.h>
+#include <spdlog/spdlog.h>
+#include <google/protobuf/util/time_util.h>
+#include "uDataPacketService/subscriptionManager.hpp"
+#include "uDataPacketService/serverOptions.hpp"
+#include "uDataPacketService/grpcServerOptions.hpp"
+#include "uDataPacketService/statistics.hpp"
+#include "uDataPacketServiceAPI/v1/admin.grpc.pb.h"
+
+export module AdminService;
+import Utilities;
+import AsyncWriter;
+
+namespace UDataPacketService
+{
+
+[[nodiscard]] UDataPacketServiceAPI::V1::StreamStatistics
+    toProto(const StreamStatistics &statistics)
+{
+    UDataPacketServiceAPI::V1::StreamStatistics result;
+    result.set_identifier(statistics.identifier);
+    *result.mutable_last_packet_time()
+        = google::protobuf::util::TimeUtil::NanosecondsToTimestamp(
+             statistics.lastPacketTime.count());
+    result.set_packets_per_second(statistics.packetsPerSecond);
+    result.set_bytes_per_second(statistics.bytesPerSecond);
+    result.set_packets_received(statistics.packetsReceived);
+    result.set_bytes_received(statistics.bytesReceived);
+    result.set_number_of_subscribers(statistics.numberOfSubscribers);
+    return result;
+}
+
+[[nodiscard]] UDataPacketServiceAPI::V1::SubscriberStatistics
+    toProto(const SubscriberStatistics &statistics)
+{
+    UDataPacketServiceAPI::V1::SubscriberStatistics result;
+    result.set_peer(statistics.peer);
+    result.set_handle(statistics.handle.getValue());
+    *result.mutable_connected_time()
+        = google::protobuf::util::TimeUtil::NanosecondsToTimestamp(
+             statistics.connectedTime.count());
+    result.set_packets_per_second(statistics.packetsPerSecond);
+    result.set_bytes_per_second(statistics.bytesPerSecond);
+    result.set_packets_delivered(statistics.packetsDelivered);
+    result.set_bytes_delivered(statistics.bytesDelivered);
+    result.set_packets_dropped(statistics.packetsDropped);
+    result.set_queue_depth(statistics.queueDepth);
+    result.set_number_of_subscriptions(statistics.numberOfSubscriptions);
+    result.set_subscribed_to_all(statistics.subscribedToAll);
+    return result;
+}
+
+/// @brief Reports the streams and subscribers held by the server.  Every
+///        RPC reads the subscription manager's snapshots so introspection
+///        never blocks the packet fan-out.
+export
+class AdminService :
+    public UDataPacketServiceAPI::V1::Admin::CallbackService
+{
+public:
+    AdminService(const ServerOptions &serverOptions,
+                 const bool isSecureConnection,
+                 std::shared_ptr<SubscriptionManager> subscriptionManager,
+                 std::shared_ptr<spdlog::logger> logger) :
+        mSubscriptionManager(subscriptionManager),
+        mLogger(logger)
+    {
+        if (mSubscriptionManager == nullptr)
+        {
+            throw std::invalid_argument("Subscription manager is null");
+        }
+        if (mLogger == nullptr){throw std::invalid_argument("Logger is null");}
+        auto accessToken = serverOptions.getGRPCOptions().getAccessToken();
+        if (isSecureConnection && accessToken != std::nullopt)
+        {
+            mAccessToken = *accessToken;
+        }
+    }
+
+    grpc::ServerUnaryReactor *
+        ListStreams(grpc::CallbackServerContext *context,
+                    const UDataPacketServiceAPI::V1::ListStreamsRequest *,
+                    UDataPacketServiceAPI::V1::ListStreamsResponse *response) override
+    {
+        auto reactor = context->DefaultReactor();
+        if (!authenticate(context, reactor)){return reactor;}
+        auto identifiers = mSubscriptionManager->getStreamIdentifiers();
+        std::sort(identifiers.begin(), identifiers.end());
+        for (auto &identifier : identifiers)
+        {
+            response->add_identifiers(std::move(identifier));
+        }
+        reactor->Finish(grpc::Status::OK);
+        return reactor;
+    }
+
+    grpc::ServerUnaryReactor *
+        ListSubscribers(grpc::CallbackServerContext *context,
+                        const UDataPacketServiceAPI::V1::ListSubscribersRequest *,
+                        UDataPacketServiceAPI::V1::ListSubscribersResponse *response) override
+    {
+        auto reactor = context->DefaultReactor();
+        if (!authenticate(context, reactor)){return reactor;}
+        for (const auto &statistics :
+             mSubscriptionManager->getSubscriberStatistics())
+        {
+            auto subscriber = response->add_subscribers();
+            subscriber->set_handle(statistics.handle.getValue());
+            subscriber->set_peer(statistics.peer);
+        }
+        reactor->Finish(grpc::Status::OK);
+        return reactor;
+    }
+
+    grpc::ServerUnaryReactor *
+        GetStreamStats(grpc::CallbackServerContext *context,
+                       const UDataPacketServiceAPI::V1::GetStreamStatsRequest *request,
+                       UDataPacketServiceAPI::V1::GetStreamStatsResponse *response) override
+    {
+        auto reactor = context->DefaultReactor();
+        if (!authenticate(context, reactor)){return reactor;}
+        if (request->selections().empty())
+        {
+            auto streamStatistics = mSubscriptionManager->getStreamStatistics();
+            std::sort(streamStatistics.begin(), streamStatistics.end(),
+                      [](const auto &lhs, const auto &rhs)
+                      {
+                          return lhs.identifier < rhs.identifier;
+                      });
+            for (const auto &statistics : streamStatistics)
+            {
+                *response->add_statistics() = toProto(statistics);
+            }
+        }
+        else
+        {
+            std::set<std::string> names;
+            for (const auto &selection : request->selections())
+            {
+                names.insert(Utilities::toName(selection));
+            }
+            for (const auto &name : names)
+            {
+                auto statistics
+                    = mSubscriptionManager->getStreamStatistics(name);
+                if (statistics)
+                {
+                    *response->add_statistics() = toProto(*statistics);
+                }
+            }
+        }
+        reactor->Finish(grpc::Status::OK);
+        return reactor;
+    }
+
+    grpc::ServerUnaryReactor *
+        GetSubscriberStats(grpc::CallbackServerContext *context,
+                           const UDataPacketServiceAPI::V1::GetSubscriberStatsRequest *request,
+                           UDataPacketServiceAPI::V1::GetSubscriberStatsResponse *response) override
+    {
+        auto reactor = context->DefaultReactor();
+        if (!authenticate(context, reactor)){return reactor;}
+        std::set<uint64_t> handles{request->handles().begin(),
+                                   request->handles().end()};
+        for (const auto &statistics :
+             mSubscriptionManager->getSubscriberStatistics())
+        {
+            if (handles.empty() ||
+                handles.contains(statistics.handle.getValue()))
+            {
+                *response->add_statistics() = toProto(statistics);
+            }
+        }
+        reactor->Finish(grpc::Status::OK);
+        return reactor;
+    }
+
+//private:
+    /// Finishes the RPC if the caller did not provide the access token.
+    [[nodiscard]] bool authenticate(grpc::CallbackServerContext *context,
+                                    grpc::ServerUnaryReactor *reactor)
+    {
+        if (validateSubscriber(context, mAccessToken)){return true;}
+        SPDLOG_LOGGER_INFO(mLogger, "Rejected admin request from {}",
+                           context->peer());
+        reactor->Finish(grpc::Status{grpc::StatusCode::UNAUTHENTICATED,
+"Caller must provide access token in x-custom-auth-token header field."});
+        return false;
+    }
+    std::shared_ptr<SubscriptionManager> mSubscriptionManager{nullptr};
+    std::shared_ptr<spdlog::logger> mLogger{nullptr};
+    std::string mAccessToken;
+};
+
+}
@@ -1,15 +1,20 @@
 module;
 #include <string>
+#include <memory>
 #include <queue>
+#include <optional>
 #include <vector>
 #include <set>
 #include <atomic>
+#include <chrono>
 #ifndef NDEBUG
 #include <cassert>
 #endif
 #include <grpcpp/grpcpp.h>
 #include <spdlog/spdlog.h>
 #include "uDataPacketService/subscriptionManager.hpp"
+#include "uDataPacketService/subscriberHandle.hpp"
+#include "uDataPacketService/statistics.hpp"
 #include "uDataPacketService/subscriptionManagerOptions.hpp"
 #include "uDataPacketService/serverOptions.hpp"
 #include "uDataPacketService/grpcServerOptions.hpp"
@@ -25,6 +30,112 @@ import Metrics;
 namespace UDataPacketService
 {
 
+/// A packet taken from the subscription manager and when it was taken.
+/// The packet is shared with the subscription manager's logs and the other
+/// subscribers.  It was charged to the memory budget when it was enqueued
+/// and stays charged until its last holder lets go of it.
+struct PendingPacket
+{
+    PendingPacket(
+        std::shared_ptr<const UDataPacketServiceAPI::V1::Packet> &&packetIn,
+        const std::chrono::nanoseconds &dequeueTimeIn) :
+        packet(std::move(packetIn)),
+        dequeueTime(dequeueTimeIn),
+        packetSize(static_cast<int64_t> (packet->ByteSizeLong()))
+    {
+    }
+    std::shared_ptr<const UDataPacketServiceAPI::V1::Packet> packet{nullptr};
+    std::chrono::nanoseconds dequeueTime{0};
+    int64_t packetSize{0};
+};
+
+/// The packets waiting to be written to a subscriber.  Real-time packets
+/// are written before backfill so a catch-up event doesn't delay live data.
+class PendingPacketLanes
+{
+public:
+    /// Queues the packet.  When full, the oldest backfill packet is
+    /// dropped or, if there is none, the oldest real-time packet.  Backfill
+    /// never pushes out real-time data.
+    /// @result True indicates a packet was dropped.
+    [[nodiscard]] bool push(PendingPacket &&pendingPacket,
+                            const bool isBackfill,
+                            const size_t maximumSize)
+    {
+        bool dropped{false};
+        if (size() >= maximumSize)
+        {
+            if (!mBackfill.empty())
+            {
+                mBackfill.pop();
+            }
+            else if (isBackfill)
+            {
+                return true;
+            }
+            else
+            {
+                mRealTime.pop();
+            }
+            dropped = true;
+        }
+        if (isBackfill)
+        {
+            mBackfill.push(std::move(pendingPacket));
+        }
+        else
+        {
+            mRealTime.push(std::move(pendingPacket));
+        }
+        return dropped;
+    }
+    /// Takes the next packet to write.
+    /// @note The caller must check the lanes are not empty.
+    [[nodiscard]] PendingPacket pop()
+    {
+        auto &lane = mRealTime.empty() ? mBackfill : mRealTime;
+#ifndef NDEBUG
+        assert(!lane.empty());
+#endif
+        PendingPacket pendingPacket{std::move(lane.front())};
+        lane.pop();
+        return pendingPacket;
+    }
+    [[nodiscard]] bool hasRealTime() const noexcept
+    {
+        return !mRealTime.empty();
+    }
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return mRealTime.empty() && mBackfill.empty();
+    }
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return mRealTime.size() + mBackfill.size();
+    }
+//private:
+    std::queue<PendingPacket> mRealTime;
+    std::queue<PendingPacket> mBackfill;
+};
+
+/// Records how long the write took and the age of the written packet.
+void recordWriteLatency(Metrics::MetricsSingleton &metrics,
+                        SubscriberCounters *counters,
+                        const PendingPacket &pendingPacket,
+                        const std::chrono::nanoseconds &writeStartTime)
+{
+    auto now = Utilities::getNow<std::chrono::nanoseconds> ();
+    metrics.recordLatency(Metrics::LatencyStage::Write, now - writeStartTime);
+    metrics.recordLatency(Metrics::LatencyStage::PacketAge,
+                          now - Utilities::getStartTimeInMicroSeconds(
+                                   *pendingPacket.packet));
+    if (counters)
+    {
+        counters->delivered.add(pendingPacket.packetSize, now);
+    }
+}
+
+export
 [[nodiscard]]
 bool validateSubscriber(const grpc::CallbackServerContext *context,
                         const std::string &accessToken)
@@ -66,7 +177,6 @@ public:
         std::atomic<bool> *keepRunning
     ) :
         mContext(context),
-        mContextAddress(reinterpret_cast<uintptr_t> (mContext)),
         mOptions(serverOptions),
         mSubscriptionManager(subscriptionManager),
         mLogger(logger),
@@ -80,6 +190,9 @@ public:
                 mPeer = mPeer + " (" + request->identifier() + ")";
             }
         }
+        mSubscriberHandle = mSubscriptionManager->createSubscriber(mPeer);
+        mCounters = mSubscriptionManager->getSubscriberCounters(mSubscriberHandle);
+        mBackfillThreshold = mOptions.getBackfillThreshold();
 
         // Authenticate
         if (isSecureConnection &&
@@ -163,7 +276,7 @@ Subscriber must provide access token in x-custom-auth-token header field.
             SPDLOG_LOGGER_INFO(mLogger,
                                "Subscribing {} to {} streams",
                                mPeer, streamSelections.size());
-            mSubscriptionManager->subscribe(mContextAddress, streamSelections);
+            mSubscriptionManager->subscribe(mSubscriberHandle, streamSelections);
             mSubscribed = true;
             auto nSubscribers = mSubscriptionManager->getNumberOfSubscribers();
             auto utilization
@@ -204,7 +317,10 @@ Subscriber must provide access token in x-custom-auth-token header field.
         }
         // Packet is flushed; can now safely purge the element to write
         mWriteInProgress = false;
-        mPacketsQueue.pop();
+        recordWriteLatency(mMetrics, mCounters.get(),
+                           *mPacketInFlight, mWriteStartTime);
+        mPacketInFlight.reset();
+        updateQueueDepth();
         // Start next write
         nextWrite();
     }
@@ -214,17 +330,22 @@ Subscriber must provide access token in x-custom-auth-token header field.
     // subscription manager..
     void OnDone() override
     {
-        if (mSubscribed)
-        {
-            mSubscriptionManager->unsubscribeFromAll(mContextAddress);
-            mSubscribed = false;
-        }
+        // Always release the handle - even if we never subscribed.  This
+        // is a no-op if the handle was already released.
+        mSubscriptionManager->unsubscribeFromAll(mSubscriberHandle);
+        mSubscribed = false;
         auto maximumNumberOfSubscribers
             = mOptions.getMaximumNumberOfSubscribers();
         auto nSubscribers = mSubscriptionManager->getNumberOfSubscribers();
             auto utilization
                 = static_cast<double> (nSubscribers)
                  /std::max(1, maximumNumberOfSubscribers);
+        if (auto nDropped = mQueueExceededLog.flush(); nDropped > 0)
+        {
+            SPDLOG_LOGGER_WARN(mLogger,
+                "RPC writer queue exceeded for {} - dropped {} packets",
+                mPeer, nDropped);
+        }
         SPDLOG_LOGGER_INFO(mLogger,
             "Subscribe RPC completed for {}.  Subscription manager is now managing {} subscribers.  Resource {} pct utilized.",
             mPeer, 
@@ -240,7 +361,7 @@ Subscriber must provide access token in x-custom-auth-token header field.
                            mPeer);
         if (mSubscribed)
         {
-            mSubscriptionManager->unsubscribeFromAll(mContextAddress);
+            mSubscriptionManager->unsubscribeFromAll(mSubscriberHandle);
             mSubscribed = false;
         }
     }
@@ -260,40 +381,48 @@ Subscriber must provide access token in x-custom-auth-token header field.
             // Cancel means we leave now
             if (mContext->IsCancelled()){break;}
 
-            // Get any remaining packets on the queue on the wire
-            if (!mPacketsQueue.empty() && !mWriteInProgress)
-            {
-                const auto &packet = mPacketsQueue.front();
-                mWriteInProgress = true;
-                mMetrics.incrementSentPacketsCounter();
-                StartWrite(&packet);
-                return;
-            }
-
-            // Try to get more packets to write while I `wait.'
-            if (mPacketsQueue.empty())
+            // Try to get more packets to write while I `wait.'  This also
+            // tops up while only backfill is waiting so that live packets
+            // can be written ahead of it.
+            if (!mPacketsQueue.hasRealTime() &&
+                mPacketsQueue.size() < mMaximumQueueSize)
             {
                 try
                 {
                     auto packetsBuffer
-                         = mSubscriptionManager->getPackets(mContextAddress);
+                         = mSubscriptionManager->getPackets(mSubscriberHandle);
+                    auto dequeueTime
+                        = Utilities::getNow<std::chrono::nanoseconds> ();
+                    auto now
+                        = std::chrono::duration_cast<std::chrono::microseconds>
+                          (dequeueTime);
                     for (auto &packet : packetsBuffer)
                     {
-                        bool allow{true};
-                        if (mCheckPackets)
+                        auto isBackfill
+                            = Utilities::isBackfill(*packet,
+                                                    mBackfillThreshold,
+                                                    now);
+                        if (mPacketsQueue.push(
+                                PendingPacket {std::move(packet), dequeueTime},
+                                isBackfill, mMaximumQueueSize))
                         {
-
+                            if (auto nDropped = mQueueExceededLog.add();
+                                nDropped > 0)
+                            {
+                                SPDLOG_LOGGER_WARN(mLogger,
+                                   "RPC writer queue exceeded for {} - dropped {} packets",
+                                   mPeer, nDropped);
+                            }
+                            mMetrics.incrementDroppedPacketsCounter(
+                                Metrics::DropLocation::ReactorQueue);
+                            if (mCounters)
+                            {
+                                mCounters->packetsDropped.fetch_add(
+                                    1, std::memory_order_relaxed);
+                            }
                         }
-                        if (!allow){continue;}
-                        if (mPacketsQueue.size() > mMaximumQueueSize)
-                        {
-                            SPDLOG_LOGGER_WARN(mLogger,
-                               "RPC writer queue exceeded for {} - popping element",
-                               mPeer);
-                            mPacketsQueue.pop();
-                         }
-                         mPacketsQueue.push(std::move(packet));
                     }
+                    updateQueueDepth();
                 }
                 catch (const std::exception &e)
                 {
@@ -304,6 +433,23 @@ Subscriber must provide access token in x-custom-auth-token header field.
                 }
             }
 
+            // Get any remaining packets on the queue on the wire
+            if (!mPacketsQueue.empty() && !mWriteInProgress)
+            {
+                mPacketInFlight.emplace(mPacketsQueue.pop());
+                auto &pendingPacket = *mPacketInFlight;
+                mWriteInProgress = true;
+                mMetrics.incrementSentPacketsCounter();
+                mMetrics.addSentBytes(pendingPacket.packetSize);
+                mWriteStartTime
+                    = Utilities::getNow<std::chrono::nanoseconds> ();
+                mMetrics.recordLatency(Metrics::LatencyStage::ReactorQueue,
+                                       mWriteStartTime
+                                     - pendingPacket.dequeueTime);
+                StartWrite(pendingPacket.packet.get());
+                return;
+            }
+
             // No new packets were acquired and I'm not waiting for a write.
             // Give me stream manager a break.
             if (mPacketsQueue.empty() && !mWriteInProgress)
@@ -318,7 +464,7 @@ Subscriber must provide access token in x-custom-auth-token header field.
             // shutting down or the client bailed.
             if (mSubscribed)
             {
-                mSubscriptionManager->unsubscribeFromAll(mContextAddress);
+                mSubscriptionManager->unsubscribeFromAll(mSubscriberHandle);
                 mSubscribed = false;
             }
             if (mContext->IsCancelled())
@@ -343,8 +489,18 @@ Subscriber must provide access token in x-custom-auth-token header field.
                                mPeer);
         }
     }
+    void updateQueueDepth()
+    {
+        if (mCounters)
+        {
+            auto queueDepth = mPacketsQueue.size() + (mPacketInFlight ? 1 : 0);
+            mCounters->queueDepth.store(static_cast<int> (queueDepth),
+                                        std::memory_order_relaxed);
+        }
+    }
     grpc::CallbackServerContext *mContext{nullptr};
-    uintptr_t mContextAddress;
+    UDataPacketService::SubscriberHandle mSubscriberHandle;
+    std::shared_ptr<SubscriberCounters> mCounters{nullptr};
     ServerOptions mOptions;
     std::shared_ptr
     <
@@ -358,11 +514,14 @@ Subscriber must provide access token in x-custom-auth-token header field.
     };  
     std::string mPeer;
     size_t mMaximumQueueSize{2048};
-    std::queue<UDataPacketServiceAPI::V1::Packet> mPacketsQueue;
+    PendingPacketLanes mPacketsQueue;
+    std::optional<PendingPacket> mPacketInFlight;
+    std::chrono::nanoseconds mWriteStartTime{0};
+    std::chrono::microseconds mBackfillThreshold{std::chrono::minutes {2}};
+    Utilities::RateLimitedLog mQueueExceededLog;
     std::chrono::milliseconds mTimeOut{20};
     bool mSubscribed{false};
     bool mWriteInProgress{false};
-    bool mCheckPackets{false};
 };
 
 ///--------------------------------------------------------------------------///
@@ -388,7 +547,6 @@ public:
         std::atomic<bool> *keepRunning
     ) :     
         mContext(context),
-        mContextAddress(reinterpret_cast<uintptr_t> (mContext)),
         mOptions(serverOptions),
         mSubscriptionManager(subscriptionManager),
         mLogger(logger),
@@ -402,6 +560,9 @@ public:
                 mPeer = mPeer + " (" + request->identifier() + ")";
             }
         }
+        mSubscriberHandle = mSubscriptionManager->createSubscriber(mPeer);
+        mCounters = mSubscriptionManager->getSubscriberCounters(mSubscriberHandle);
+        mBackfillThreshold = mOptions.getBackfillThreshold();
 
         // Authenticate
         if (isSecureConnection &&
@@ -448,7 +609,7 @@ Subscriber must provide access token in x-custom-auth-token header field.
             SPDLOG_LOGGER_INFO(mLogger,
                                "Subscribing {} to all streams",
                                mPeer);
-            mSubscriptionManager->subscribeToAll(mContextAddress);
+            mSubscriptionManager->subscribeToAll(mSubscriberHandle);
             mSubscribed = true;
             auto nSubscribers = mSubscriptionManager->getNumberOfSubscribers();
             auto utilization
@@ -487,7 +648,10 @@ Subscriber must provide access token in x-custom-auth-token header field.
         }
         // Packet is flushed; can now safely purge the element to write
         mWriteInProgress = false;
-        mPacketsQueue.pop();
+        recordWriteLatency(mMetrics, mCounters.get(),
+                           *mPacketInFlight, mWriteStartTime);
+        mPacketInFlight.reset();
+        updateQueueDepth();
         // Start next write
         nextWrite();
     }
@@ -497,17 +661,22 @@ Subscriber must provide access token in x-custom-auth-token header field.
     // subscription manager..
     void OnDone() override
     {
-        if (mSubscribed)
-        {
-            mSubscriptionManager->unsubscribeFromAll(mContextAddress);
-            mSubscribed = false;
-        }
+        // Always release the handle - even if we never subscribed.  This
+        // is a no-op if the handle was already released.
+        mSubscriptionManager->unsubscribeFromAll(mSubscriberHandle);
+        mSubscribed = false;
         auto maximumNumberOfSubscribers
             = mOptions.getMaximumNumberOfSubscribers();
         auto nSubscribers = mSubscriptionManager->getNumberOfSubscribers();
             auto utilization
                 = static_cast<double> (nSubscribers)
                  /std::max(1, maximumNumberOfSubscribers);
+        if (auto nDropped = mQueueExceededLog.flush(); nDropped > 0)
+        {
+            SPDLOG_LOGGER_WARN(mLogger,
+                "RPC writer queue exceeded for {} - dropped {} packets",
+                mPeer, nDropped);
+        }
         SPDLOG_LOGGER_INFO(mLogger,
             "Subscribe to all RPC completed for {}.  Subscription manager is now managing {} subscribers.  Resource {} pct utilized.",
             mPeer,
@@ -523,7 +692,7 @@ Subscriber must provide access token in x-custom-auth-token header field.
                            mPeer);
         if (mSubscribed)
         {   
-            mSubscriptionManager->unsubscribeFromAll(mContextAddress);
+            mSubscriptionManager->unsubscribeFromAll(mSubscriberHandle);
             mSubscribed = false;
         }   
     }   
@@ -543,39 +712,48 @@ Subscriber must provide access token in x-custom-auth-token header field.
         {
             if (mContext->IsCancelled()){break;}
 
-            if (!mPacketsQueue.empty() && !mWriteInProgress)
-            {
-                const auto &packet = mPacketsQueue.front();
-                mWriteInProgress = true;
-                mMetrics.incrementSentPacketsCounter();
-                StartWrite(&packet);
-                return;
-            }
-
-            // Try to get more packets to write while I `wait.'
-            if (mPacketsQueue.empty())
+            // Try to get more packets to write while I `wait.'  This also
+            // tops up while only backfill is waiting so that live packets
+            // can be written ahead of it.
+            if (!mPacketsQueue.hasRealTime() &&
+                mPacketsQueue.size() < mMaximumQueueSize)
             {
                 try
                 {
                     auto packetsBuffer
-                         = mSubscriptionManager->getPackets(mContextAddress);
+                         = mSubscriptionManager->getPackets(mSubscriberHandle);
+                    auto dequeueTime
+                        = Utilities::getNow<std::chrono::nanoseconds> ();
+                    auto now
+                        = std::chrono::duration_cast<std::chrono::microseconds>
+                          (dequeueTime);
                     for (auto &packet : packetsBuffer)
                     {
-                        bool allow{true};
-                        if (mCheckPackets)
+                        auto isBackfill
+                            = Utilities::isBackfill(*packet,
+                                                    mBackfillThreshold,
+                                                    now);
+                        if (mPacketsQueue.push(
+                                PendingPacket {std::move(packet), dequeueTime},
+                                isBackfill, mMaximumQueueSize))
                         {
-
+                            if (auto nDropped = mQueueExceededLog.add();
+                                nDropped > 0)
+                            {
+                                SPDLOG_LOGGER_WARN(mLogger,
+                                   "RPC writer queue exceeded for {} - dropped {} packets",
+                                   mPeer, nDropped);
+                            }
+                            mMetrics.incrementDroppedPacketsCounter(
+                                Metrics::DropLocation::ReactorQueue);
+                            if (mCounters)
+                            {
+                                mCounters->packetsDropped.fetch_add(
+                                    1, std::memory_order_relaxed);
+                            }
                         }
-                        if (!allow){continue;}
-                        if (mPacketsQueue.size() > mMaximumQueueSize)
-                        {
-                            SPDLOG_LOGGER_WARN(mLogger,
-                               "RPC writer queue exceeded for {} - popping element",
-                               mPeer);
-                            mPacketsQueue.pop();
-                         }
-                         mPacketsQueue.push(std::move(packet));
                     }
+                    updateQueueDepth();
                 }
                 catch (const std::exception &e)
                 {
@@ -586,6 +764,22 @@ Subscriber must provide access token in x-custom-auth-token header field.
                 }
             }
 
+            if (!mPacketsQueue.empty() && !mWriteInProgress)
+            {
+                mPacketInFlight.emplace(mPacketsQueue.pop());
+                auto &pendingPacket = *mPacketInFlight;
+                mWriteInProgress = true;
+                mMetrics.incrementSentPacketsCounter();
+                mMetrics.addSentBytes(pendingPacket.packetSize);
+                mWriteStartTime
+                    = Utilities::getNow<std::chrono::nanoseconds> ();
+                mMetrics.recordLatency(Metrics::LatencyStage::ReactorQueue,
+                                       mWriteStartTime
+                                     - pendingPacket.dequeueTime);
+                StartWrite(pendingPacket.packet.get());
+                return;
+            }
+
             // No new packets were acquired and I'm not waiting for a write.
             // Give me stream manager a break.
             if (mPacketsQueue.empty() && !mWriteInProgress)
@@ -598,7 +792,7 @@ Subscriber must provide access token in x-custom-auth-token header field.
         {
             if (mSubscribed)
             {
-                mSubscriptionManager->unsubscribeFromAll(mContextAddress);
+                mSubscriptionManager->unsubscribeFromAll(mSubscriberHandle);
                 mSubscribed = false;
             }
             if (mContext->IsCancelled())
@@ -624,8 +818,18 @@ Subscriber must provide access token in x-custom-auth-token header field.
         }
     }
 
+    void updateQueueDepth()
+    {
+        if (mCounters)
+        {
+            auto queueDepth = mPacketsQueue.size() + (mPacketInFlight ? 1 : 0);
+            mCounters->queueDepth.store(static_cast<int> (queueDepth),
+                                        std::memory_order_relaxed);
+        }
+    }
     grpc::CallbackServerContext *mContext{nullptr};
-    uintptr_t mContextAddress;
+    UDataPacketService::SubscriberHandle mSubscriberHandle;
+    std::shared_ptr<SubscriberCounters> mCounters{nullptr};
     ServerOptions mOptions;
     std::shared_ptr
     <   
@@ -639,11 +843,14 @@ Subscriber must provide access token in x-custom-auth-token header field.
     };  
     std::string mPeer;
     size_t mMaximumQueueSize{2048};
-    std::queue<UDataPacketServiceAPI::V1::Packet> mPacketsQueue;
+    PendingPacketLanes mPacketsQueue;
+    std::optional<PendingPacket> mPacketInFlight;
+    std::chrono::nanoseconds mWriteStartTime{0};
+    std::chrono::microseconds mBackfillThreshold{std::chrono::minutes {2}};
+    Utilities::RateLimitedLog mQueueExceededLog;
     std::chrono::milliseconds mTimeOut{10};
     bool mSubscribed{false};
     bool mWriteInProgress{false};
-    bool mCheckPackets{false};
 };
 
 }
@@ -1,16 +1,21 @@
 module;
 
+#include <algorithm>
+#include <chrono>
 #ifndef NDEBUG
 #include <cassert>
 #endif
 #include <spdlog/spdlog.h>
+#include <spdlog/async.h>
+#include <spdlog/async_logger.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <opentelemetry/exporters/otlp/otlp_http_exporter_options.h>
 #include <opentelemetry/exporters/otlp/otlp_http_exporter_factory.h>
 #include <opentelemetry/exporters/otlp/otlp_http_log_record_exporter_factory.h>
 #include <opentelemetry/logs/provider.h>
 #include <opentelemetry/sdk/logs/logger_provider_factory.h>
-#include <opentelemetry/sdk/logs/simple_log_record_processor_factory.h>
+#include <opentelemetry/sdk/logs/batch_log_record_processor_factory.h>
+#include <opentelemetry/sdk/logs/batch_log_record_processor_options.h>
 
 export module Logger;
 import ProgramOptions;
@@ -20,6 +25,8 @@ namespace UDataPacketService::Logger
 {
 
 std::shared_ptr<opentelemetry::sdk::logs::LoggerProvider> loggerProvider{nullptr};
+// Formats and writes the messages off of the callers' threads
+std::shared_ptr<spdlog::details::thread_pool> threadPool{nullptr};
 
 void setVerbosityForSPDLOG(const int verbosity,
                            spdlog::logger *logger)
@@ -41,6 +48,13 @@ export std::shared_ptr<spdlog::logger>
 {
     std::shared_ptr<spdlog::logger> logger{nullptr};
     auto consoleSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt> ();
+    // Callers only enqueue the message.  When the queue is full the oldest
+    // message is overwritten so a log storm can't stall the callback
+    // threads.
+    constexpr size_t nThreads{1};
+    threadPool
+        = std::make_shared<spdlog::details::thread_pool>
+          (static_cast<size_t> (programOptions.logQueueSize), nThreads);
     if (programOptions.exportLogs)
     {
         namespace otel = opentelemetry;
@@ -53,9 +67,17 @@ export std::shared_ptr<spdlog::logger>
         //    = otel::nostd::shared_ptr<opentelemetry::logs::LoggerProvider>;
         auto exporter
             = otel::exporter::otlp::OtlpHttpLogRecordExporterFactory::Create(httpOptions);
+        // Export in batches from the processor's thread rather than one
+        // HTTP request per message
+        otel::sdk::logs::BatchLogRecordProcessorOptions batchOptions;
+        batchOptions.max_queue_size
+            = static_cast<size_t> (programOptions.logQueueSize);
+        batchOptions.max_export_batch_size
+            = std::min(static_cast<size_t> (512), batchOptions.max_queue_size);
+        batchOptions.schedule_delay_millis = std::chrono::milliseconds {1000};
         auto processor
-            = otel::sdk::logs::SimpleLogRecordProcessorFactory::Create(
-                 std::move(exporter));
+            = otel::sdk::logs::BatchLogRecordProcessorFactory::Create(
+                 std::move(exporter), batchOptions);
         loggerProvider
             = otel::sdk::logs::LoggerProviderFactory::Create(
                 std::move(processor));
@@ -66,14 +88,20 @@ export std::shared_ptr<spdlog::logger>
             = std::make_shared<spdlog::sinks::OpenTelemetrySink<std::mutex>> ();
 
         logger
-            = std::make_shared<spdlog::logger>
-              (spdlog::logger ("OTelLogger", {otelLogger, consoleSink}));
+            = std::make_shared<spdlog::async_logger>
+              ("OTelLogger",
+               spdlog::sinks_init_list {otelLogger, consoleSink},
+               threadPool,
+               spdlog::async_overflow_policy::overrun_oldest);
     }
     else
     {
         logger
-            = std::make_shared<spdlog::logger>
-              (spdlog::logger ("", {consoleSink}));
+            = std::make_shared<spdlog::async_logger>
+              ("",
+               spdlog::sinks_init_list {consoleSink},
+               threadPool,
+               spdlog::async_overflow_policy::overrun_oldest);
     }
     // Verbosity
     setVerbosityForSPDLOG(programOptions.verbosity, &*logger);
@@ -83,6 +111,8 @@ export std::shared_ptr<spdlog::logger>
 
 export void cleanup()
 {
+    // Destroying the pool drains the queued messages into the sinks
+    threadPool.reset();
     if (loggerProvider)
     {   
         loggerProvider->ForceFlush();
@@ -0,0 +1,81 @@
+module;
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+export module MemoryBudget;
+
+namespace UDataPacketService
+{
+
+/// @brief Accounts for the bytes held by the service's queues and logs so
+///        that their total, rather than each queue in isolation, can be
+///        bounded.  Every queue charges the budget for a packet when the
+///        packet is added and releases it when the packet leaves.  Nothing
+///        is refused when the budget is exceeded; instead, the subscription
+///        manager sheds packets according to its shedding policy.
+export class MemoryBudget
+{
+public:
+    /// @note Initialization of the static is thread-safe.
+    static MemoryBudget &getInstance()
+    {
+        static MemoryBudget instance;
+        return instance;
+    }
+    /// @brief Sets the number of bytes the queues may hold.
+    /// @throws std::invalid_argument if the limit is not positive.
+    void setLimit(const int64_t limit)
+    {
+        if (limit <= 0)
+        {
+            throw std::invalid_argument("Memory budget must be positive");
+        }
+        mLimit.store(limit, std::memory_order_relaxed);
+    }
+    /// @brief Removes the limit.
+    void clearLimit() noexcept
+    {
+        mLimit.store(std::numeric_limits<int64_t>::max(),
+                     std::memory_order_relaxed);
+    }
+    /// @result The number of bytes the queues may hold.  If not set then
+    ///         this is unbounded.
+    [[nodiscard]] std::optional<int64_t> getLimit() const noexcept
+    {
+        auto limit = mLimit.load(std::memory_order_relaxed);
+        if (limit == std::numeric_limits<int64_t>::max()){return std::nullopt;}
+        return std::make_optional<int64_t> (limit);
+    }
+    void charge(const int64_t nBytes) noexcept
+    {
+        mBytes.fetch_add(nBytes, std::memory_order_relaxed);
+    }
+    void release(const int64_t nBytes) noexcept
+    {
+        mBytes.fetch_sub(nBytes, std::memory_order_relaxed);
+    }
+    /// @result The number of bytes currently charged to the budget.
+    [[nodiscard]] int64_t getBytes() const noexcept
+    {
+        return mBytes.load(std::memory_order_relaxed);
+    }
+    /// @result True indicates the queues hold more than the limit.
+    [[nodiscard]] bool isExceeded() const noexcept
+    {
+        return mBytes.load(std::memory_order_relaxed)
+             > mLimit.load(std::memory_order_relaxed);
+    }
+private:
+    MemoryBudget() = default;
+    ~MemoryBudget() = default;
+    MemoryBudget(const MemoryBudget &) = delete;
+    MemoryBudget& operator=(const MemoryBudget &) = delete;
+    std::atomic<int64_t> mBytes{0};
+    std::atomic<int64_t> mLimit{std::numeric_limits<int64_t>::max()};
+};
+
+}
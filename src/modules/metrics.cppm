@@ -2,6 +2,12 @@ module;
 
 #include <iostream>
 #include <atomic>
+#include <array>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <chrono>
+#include <map>
 #include <string>
 #include <opentelemetry/nostd/shared_ptr.h>
 #include <opentelemetry/metrics/meter.h>
@@ -22,6 +28,7 @@ module;
 
 export module Metrics;
 import ProgramOptions;
+import MemoryBudget;
 
 namespace UDataPacketService::Metrics
 {
@@ -77,19 +84,205 @@ export void cleanup()
     metricsInitialized = false;
 }
 
+/// @brief The stages of the packet pipeline for which we track latency.
+export enum class LatencyStage : int
+{
+    ImportQueue = 0,  /*!< Import callback to import queue dequeue. */
+    FanOut,           /*!< Import queue dequeue to the packet being set
+                           on its stream. */
+    StreamQueue,      /*!< Time a packet waits in its subscription
+                           group's log until a reactor takes it. */
+    ReactorQueue,     /*!< Reactor dequeue to the start of the write. */
+    Write,            /*!< Start of the write to gRPC reporting the write
+                           is done. */
+    PacketAge         /*!< Write done less the packet's start time. */
+};
+constexpr std::array<const char *, 6> latencyStageNames
+{
+    "import_queue", "fan_out", "stream_queue", "reactor_queue", "write",
+    "packet_age"
+};
+
+/// @brief Latency quantiles collected from a histogram.
+export struct LatencySummary
+{
+    std::chrono::microseconds p50{0};
+    std::chrono::microseconds p90{0};
+    std::chrono::microseconds p99{0};
+    std::chrono::microseconds p999{0};
+    std::chrono::microseconds maximum{0};
+    uint64_t count{0};
+};
+
+/// @brief A lock-free latency histogram with HDR-style log-linear buckets.
+///        Each power of two microseconds is split into 8 linear sub-buckets
+///        so a reported quantile is within 12.5 pct of the true value.
+///        Recording is a relaxed atomic increment so any thread can record.
+export class LatencyHistogram
+{
+public:
+    /// @brief Records a latency.  Negative latencies (e.g., from clock
+    ///        skew) are recorded as zero.
+    void record(const std::chrono::nanoseconds &latency) noexcept
+    {
+        auto value = static_cast<uint64_t>
+            (std::max<int64_t> (0, latency.count()/1000));
+        mCounts[toBucket(value)].fetch_add(1, std::memory_order_relaxed);
+        auto maximum = mMaximum.load(std::memory_order_relaxed);
+        while (value > maximum &&
+               !mMaximum.compare_exchange_weak(maximum, value,
+                                               std::memory_order_relaxed))
+        {
+        }
+    }
+    /// @brief Computes the quantiles of the latencies recorded since the
+    ///        previous collection and resets the histogram.
+    [[nodiscard]] LatencySummary collect() noexcept
+    {
+        std::array<uint64_t, NumberOfBuckets> counts;
+        uint64_t total{0};
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            counts[i] = mCounts[i].exchange(0, std::memory_order_relaxed);
+            total += counts[i];
+        }
+        auto maximum = mMaximum.exchange(0, std::memory_order_relaxed);
+        LatencySummary result;
+        result.count = total;
+        if (total == 0){return result;}
+        auto quantile = [&](const double q)
+        {
+            auto target = std::max<uint64_t>
+                (1, static_cast<uint64_t> (std::ceil(q*total)));
+            uint64_t cumulative{0};
+            for (size_t i = 0; i < counts.size(); ++i)
+            {
+                cumulative += counts[i];
+                if (cumulative >= target)
+                {
+                    return std::chrono::microseconds
+                        {static_cast<int64_t>
+                         (std::min(toUpperBound(i), maximum))};
+                }
+            }
+            return std::chrono::microseconds
+                   {static_cast<int64_t> (maximum)};
+        };
+        result.p50 = quantile(0.5);
+        result.p90 = quantile(0.9);
+        result.p99 = quantile(0.99);
+        result.p999 = quantile(0.999);
+        result.maximum
+            = std::chrono::microseconds {static_cast<int64_t> (maximum)};
+        return result;
+    }
+private:
+    static constexpr int SubBucketBits{3};
+    static constexpr uint64_t SubBuckets{uint64_t {1} << SubBucketBits};
+    static constexpr size_t NumberOfBuckets{(64 - SubBucketBits + 1)*SubBuckets};
+    [[nodiscard]] static constexpr size_t toBucket(const uint64_t value) noexcept
+    {
+        if (value < SubBuckets){return static_cast<size_t> (value);}
+        auto exponent = std::bit_width(value) - 1;
+        auto subBucket = (value >> (exponent - SubBucketBits)) & (SubBuckets - 1);
+        return static_cast<size_t>
+               ((exponent - SubBucketBits + 1)*SubBuckets + subBucket);
+    }
+    [[nodiscard]] static constexpr uint64_t toUpperBound(const size_t bucket) noexcept
+    {
+        if (bucket < SubBuckets){return bucket;}
+        auto exponent = static_cast<int> (bucket/SubBuckets) + SubBucketBits - 1;
+        auto subBucket = bucket % SubBuckets;
+        auto width = uint64_t {1} << (exponent - SubBucketBits);
+        return (SubBuckets + subBucket)*width + width - 1;
+    }
+    std::array<std::atomic<uint64_t>, NumberOfBuckets> mCounts{};
+    std::atomic<uint64_t> mMaximum{0};
+};
+
+/// @brief Where a packet was dropped.
+export enum class DropLocation : int
+{
+    ImportQueue = 0,  /*!< The import queue was full. */
+    ReactorQueue,     /*!< A reactor's write queue was full. */
+    Duplicate,        /*!< Another import stream already delivered the
+                           packet. */
+    BroadcastLog,     /*!< A subscriber was overrun by its subscription
+                           group's log. */
+    MemoryBudget      /*!< A lagging subscriber's backlog was shed because
+                           the memory budget was exceeded. */
+};
+constexpr std::array<const char *, 5> dropLocationNames
+{
+    "import_queue", "reactor_queue", "duplicate", "broadcast_log",
+    "memory_budget"
+};
+
+/// @brief A counter split into cache-line-sized shards.  Each thread
+///        updates its own shard so threads incrementing the counter do
+///        not contend for the same cache line.  The shards are summed
+///        only when the counter is read, i.e., when metrics are exported.
+export class ShardedCounter
+{
+public:
+    void add(const int64_t value) noexcept
+    {
+        mShards[getShardIndex()].value.fetch_add(value,
+                                                 std::memory_order_relaxed);
+    }
+    void increment() noexcept
+    {
+        add(1);
+    }
+    [[nodiscard]] int64_t load() const noexcept
+    {
+        int64_t result{0};
+        for (const auto &shard : mShards)
+        {
+            result += shard.value.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+    void reset() noexcept
+    {
+        for (auto &shard : mShards)
+        {
+            shard.value.store(0, std::memory_order_relaxed);
+        }
+    }
+private:
+    static constexpr size_t NumberOfShards{64};
+    // std::hardware_destructive_interference_size isn't available with
+    // every standard library so assume the common 64 byte cache line
+    static constexpr size_t CacheLineSize{64};
+    // A thread is assigned a shard on its first update
+    [[nodiscard]] static size_t getShardIndex() noexcept
+    {
+        static std::atomic<size_t> nextShard{0};
+        thread_local const size_t shardIndex
+            = nextShard.fetch_add(1, std::memory_order_relaxed)
+            % NumberOfShards;
+        return shardIndex;
+    }
+    struct alignas(CacheLineSize) Shard
+    {
+        std::atomic<int64_t> value{0};
+    };
+    std::array<Shard, NumberOfShards> mShards{};
+};
+
 export class MetricsSingleton
 {
 public:
+    /// @note Initialization of the static is thread-safe.
     static MetricsSingleton &getInstance()
     {   
-        std::mutex mutex;
-        std::scoped_lock lock{mutex};
         static MetricsSingleton instance;
         return instance;
     }   
     void incrementReceivedPacketsCounter() noexcept
     {   
-        mReceivedPacketsCounter.fetch_add(1, std::memory_order_relaxed);
+        mReceivedPacketsCounter.increment();
     }   
     [[nodiscard]] int64_t getReceivedPacketsCount() const noexcept
     {   
@@ -97,12 +290,50 @@ public:
     }   
     void incrementSentPacketsCounter() noexcept
     {
-        mSentPacketsCounter.fetch_add(1, std::memory_order_relaxed);
+        mSentPacketsCounter.increment();
     }
     [[nodiscard]] int64_t getSentPacketsCount() const noexcept
     {
         return mSentPacketsCounter.load();
     }
+    void addSentBytes(const int64_t nBytes) noexcept
+    {
+        mSentBytesCounter.add(nBytes);
+    }
+    [[nodiscard]] int64_t getSentBytesCount() const noexcept
+    {
+        return mSentBytesCounter.load();
+    }
+    void incrementDroppedPacketsCounter(const DropLocation location) noexcept
+    {
+        mDroppedPacketsCounters[static_cast<size_t> (location)].increment();
+    }
+    void addDroppedPackets(const DropLocation location,
+                           const int64_t nPackets) noexcept
+    {
+        mDroppedPacketsCounters[static_cast<size_t> (location)].add(nPackets);
+    }
+    void addEvictedStreams(const int64_t nStreams) noexcept
+    {
+        mEvictedStreamsCounter.add(nStreams);
+    }
+    [[nodiscard]] int64_t getEvictedStreamsCount() const noexcept
+    {
+        return mEvictedStreamsCounter.load();
+    }
+    void updateNumberOfStreams(const int64_t nStreams) noexcept
+    {
+        mNumberOfStreams.store(nStreams, std::memory_order_relaxed);
+    }
+    [[nodiscard]] int64_t getNumberOfStreams() const noexcept
+    {
+        return mNumberOfStreams.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] int64_t getDroppedPacketsCount(
+        const DropLocation location) const noexcept
+    {
+        return mDroppedPacketsCounters[static_cast<size_t> (location)].load();
+    }
     void updateUtilization(double utilization)
     {
         mUtilization.store(std::min(std::max(0.0, utilization), 1.0));
@@ -111,18 +342,44 @@ public:
     {
         return mUtilization.load();
     }                      
+    /// @brief Records the latency of a pipeline stage.
+    void recordLatency(const LatencyStage stage,
+                       const std::chrono::nanoseconds &latency) noexcept
+    {
+        mLatencyHistograms[static_cast<size_t> (stage)].record(latency);
+    }
+    /// @result The latency quantiles for the stage since the last
+    ///         collection.  This resets the stage's histogram.
+    [[nodiscard]] LatencySummary collectLatency(const LatencyStage stage) noexcept
+    {
+        return mLatencyHistograms[static_cast<size_t> (stage)].collect();
+    }
     void resetCounters()
     {   
-        mReceivedPacketsCounter.store(0);
-        mSentPacketsCounter.store(0);
+        mReceivedPacketsCounter.reset();
+        mSentPacketsCounter.reset();
+        mSentBytesCounter.reset();
+        for (auto &counter : mDroppedPacketsCounters){counter.reset();}
+        mEvictedStreamsCounter.reset();
+        mNumberOfStreams.store(0);
         mUtilization.store(0);
+        for (auto &histogram : mLatencyHistograms)
+        {
+            (void) histogram.collect();
+        }
     }   
 private:
     MetricsSingleton() = default;
     ~MetricsSingleton() = default;
+    std::array<LatencyHistogram, latencyStageNames.size()> mLatencyHistograms;
+    std::array<ShardedCounter, dropLocationNames.size()>
+        mDroppedPacketsCounters;
+    ShardedCounter mReceivedPacketsCounter;
+    ShardedCounter mSentPacketsCounter;
+    ShardedCounter mSentBytesCounter;
+    ShardedCounter mEvictedStreamsCounter;
+    std::atomic<int64_t> mNumberOfStreams{0};
     std::atomic<double> mUtilization{0};
-    std::atomic<int64_t> mReceivedPacketsCounter{0};
-    std::atomic<int64_t> mSentPacketsCounter{0};
 };
 
 export void initializeMetricsSingleton()
@@ -195,6 +452,229 @@ export void observeNumberOfPacketsSent(
     }   
 }
 
+export void observeNumberOfBytesSent(
+    opentelemetry::metrics::ObserverResult observerResult,
+    void *)
+{
+    if (opentelemetry::nostd::holds_alternative
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+                opentelemetry::metrics::ObserverResultT<int64_t>
+            >
+        > (observerResult))
+    {
+        auto observer = opentelemetry::nostd::get
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+               opentelemetry::metrics::ObserverResultT<int64_t>
+            >
+        > (observerResult);
+        try
+        {
+            auto &instance = MetricsSingleton::getInstance();
+            observer->Observe(instance.getSentBytesCount());
+        }
+        catch (const std::exception &e)
+        {
+
+        }
+    }
+}
+
+/// Observes the number of streams in the subscription manager's registry.
+export void observeNumberOfStreams(
+    opentelemetry::metrics::ObserverResult observerResult,
+    void *)
+{
+    if (opentelemetry::nostd::holds_alternative
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+                opentelemetry::metrics::ObserverResultT<int64_t>
+            >
+        > (observerResult))
+    {
+        auto observer = opentelemetry::nostd::get
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+               opentelemetry::metrics::ObserverResultT<int64_t>
+            >
+        > (observerResult);
+        try
+        {
+            auto &instance = MetricsSingleton::getInstance();
+            observer->Observe(instance.getNumberOfStreams());
+        }
+        catch (const std::exception &e)
+        {
+
+        }
+    }
+}
+
+/// Observes the number of streams evicted from the registry.
+export void observeNumberOfEvictedStreams(
+    opentelemetry::metrics::ObserverResult observerResult,
+    void *)
+{
+    if (opentelemetry::nostd::holds_alternative
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+                opentelemetry::metrics::ObserverResultT<int64_t>
+            >
+        > (observerResult))
+    {
+        auto observer = opentelemetry::nostd::get
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+               opentelemetry::metrics::ObserverResultT<int64_t>
+            >
+        > (observerResult);
+        try
+        {
+            auto &instance = MetricsSingleton::getInstance();
+            observer->Observe(instance.getEvictedStreamsCount());
+        }
+        catch (const std::exception &e)
+        {
+
+        }
+    }
+}
+
+/// Observes the bytes held by the queues and logs.
+export void observeMemoryBudgetBytes(
+    opentelemetry::metrics::ObserverResult observerResult,
+    void *)
+{
+    if (opentelemetry::nostd::holds_alternative
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+                opentelemetry::metrics::ObserverResultT<int64_t>
+            >
+        > (observerResult))
+    {
+        auto observer = opentelemetry::nostd::get
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+               opentelemetry::metrics::ObserverResultT<int64_t>
+            >
+        > (observerResult);
+        try
+        {
+            auto &budget = MemoryBudget::getInstance();
+            observer->Observe(budget.getBytes());
+        }
+        catch (const std::exception &e)
+        {
+
+        }
+    }
+}
+
+/// Observes the number of dropped packets by where they were dropped.
+export void observeNumberOfPacketsDropped(
+    opentelemetry::metrics::ObserverResult observerResult,
+    void *)
+{
+    if (opentelemetry::nostd::holds_alternative
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+                opentelemetry::metrics::ObserverResultT<int64_t>
+            >
+        > (observerResult))
+    {
+        auto observer = opentelemetry::nostd::get
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+               opentelemetry::metrics::ObserverResultT<int64_t>
+            >
+        > (observerResult);
+        try
+        {
+            auto &instance = MetricsSingleton::getInstance();
+            for (size_t i = 0; i < dropLocationNames.size(); ++i)
+            {
+                std::map<std::string, std::string> attributes
+                {
+                    {"location", dropLocationNames[i]}
+                };
+                observer->Observe(
+                    instance.getDroppedPacketsCount(
+                        static_cast<DropLocation> (i)),
+                    attributes);
+            }
+        }
+        catch (const std::exception &e)
+        {
+
+        }
+    }
+}
+
+/// Observes the latency quantiles of each pipeline stage since the
+/// previous export.  Stages without traffic are not reported.
+export void observeLatencies(
+    opentelemetry::metrics::ObserverResult observerResult,
+    void *)
+{
+    if (opentelemetry::nostd::holds_alternative
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+                opentelemetry::metrics::ObserverResultT<double>
+            >
+        > (observerResult))
+    {
+        auto observer = opentelemetry::nostd::get
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+               opentelemetry::metrics::ObserverResultT<double>
+            >
+        > (observerResult);
+        try
+        {
+            auto &instance = MetricsSingleton::getInstance();
+            for (size_t i = 0; i < latencyStageNames.size(); ++i)
+            {
+                auto summary
+                    = instance.collectLatency(static_cast<LatencyStage> (i));
+                if (summary.count == 0){continue;}
+                const std::string stage{latencyStageNames[i]};
+                for (const auto &[quantile, value]
+                     : {std::pair {"0.5",   summary.p50},
+                        std::pair {"0.9",   summary.p90},
+                        std::pair {"0.99",  summary.p99},
+                        std::pair {"0.999", summary.p999},
+                        std::pair {"1",     summary.maximum}})
+                {
+                    std::map<std::string, std::string> attributes
+                    {
+                        {"stage", stage},
+                        {"quantile", quantile}
+                    };
+                    observer->Observe(static_cast<double> (value.count()),
+                                      attributes);
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+
+        }
+    }
+}
+
 export void observeUtilization(
     opentelemetry::metrics::ObserverResult observerResult,
     void *)
@@ -15,6 +15,7 @@ module;
 #include <spdlog/version.h>
 
 #include <mutex>
+#include <string>
 
 export module OTelSpdLog;
 
@@ -64,8 +65,15 @@ protected:
   {
     static constexpr auto kLibraryName = "spdlog";
 
-    auto provider   = opentelemetry::logs::Provider::GetLoggerProvider();
-    auto logger     = provider->GetLogger(msg.logger_name.data(), kLibraryName, libraryVersion());
+    // Looking up the logger takes the provider's lock so do it once per
+    // logger name rather than once per message
+    if (!mLogger || mLoggerName != msg.logger_name)
+    {
+      auto provider = opentelemetry::logs::Provider::GetLoggerProvider();
+      mLoggerName   = std::string(msg.logger_name.data(), msg.logger_name.size());
+      mLogger       = provider->GetLogger(mLoggerName, kLibraryName, libraryVersion());
+    }
+    auto &logger    = mLogger;
     auto log_record = logger->CreateLogRecord();
 
     if (log_record)
@@ -86,6 +94,10 @@ protected:
     }
   }
   void flush_() override {}
+
+private:
+  opentelemetry::nostd::shared_ptr<opentelemetry::logs::Logger> mLogger;
+  std::string mLoggerName;
 };
 
 }  // namespace spdlog::sinks
@@ -0,0 +1,745 @@
+module;
+#include <csignal>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+#ifndef NDEBUG
+#include <cassert>
+#endif
+#include <opentelemetry/metrics/meter_provider.h>
+#include <opentelemetry/metrics/provider.h>
+#include <spdlog/spdlog.h>
+#include "uDataPacketImportAPI/v1/packet.pb.h"
+#include "uDataPacketServiceAPI/v1/packet.pb.h"
+#include "uDataPacketService/server.hpp"
+#include "uDataPacketService/serverOptions.hpp"
+#include "uDataPacketService/subscriber.hpp"
+#include "uDataPacketService/subscriberOptions.hpp"
+#include "uDataPacketService/duplicatePacketDetector.hpp"
+#include "uDataPacketService/fairPacketQueue.hpp"
+#include "uDataPacketService/subscriptionManager.hpp"
+#include "uDataPacketService/statistics.hpp"
+
+export module Process;
+
+import ProgramOptions;
+import Metrics;
+import MemoryBudget;
+import Utilities;
+import PacketConverter;
+
+namespace
+{
+std::atomic<bool> mInterrupted{false};
+
+opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>
+    totalPacketsReceivedCounter;
+opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>
+    totalPacketsSentCounter;
+opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>
+    utilizationGauge;
+opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>
+    totalBytesSentCounter;
+opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>
+    totalPacketsDroppedCounter;
+opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>
+    latencyGauge;
+opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>
+    streamsGauge;
+opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>
+    totalStreamsEvictedCounter;
+opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>
+    memoryBudgetGauge;
+std::vector
+<
+    std::pair
+    <
+        opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>,
+        opentelemetry::metrics::ObservableCallbackPtr
+    >
+> statisticsGauges;
+
+/// Observes the statistic for only the N items with the largest value so
+/// the number of time series stays bounded.  The gauges are observed on
+/// the exporter's schedule so failures are summarized in the failure log.
+template<typename T>
+void observeTopN(opentelemetry::metrics::ObserverResult observerResult,
+                 const std::function<std::vector<T> ()> &getStatistics,
+                 const size_t topN,
+                 const std::string &attributeName,
+                 const std::function<std::string (const T &)> &getName,
+                 const std::function<double (const T &)> &getValue,
+                 spdlog::logger *logger,
+                 UDataPacketService::Utilities::RateLimitedLog &failureLog)
+{
+    if (!opentelemetry::nostd::holds_alternative
+        <
+            opentelemetry::nostd::shared_ptr
+            <
+                opentelemetry::metrics::ObserverResultT<double>
+            >
+        > (observerResult))
+    {
+        return;
+    }
+    auto observer = opentelemetry::nostd::get
+    <
+        opentelemetry::nostd::shared_ptr
+        <
+           opentelemetry::metrics::ObserverResultT<double>
+        >
+    > (observerResult);
+    try
+    {
+        auto statistics = getStatistics();
+        auto nObserve = std::min(topN, statistics.size());
+        std::partial_sort(statistics.begin(), statistics.begin() + nObserve,
+                          statistics.end(),
+                          [&getValue](const T &lhs, const T &rhs)
+                          {
+                              return getValue(lhs) > getValue(rhs);
+                          });
+        for (size_t i = 0; i < nObserve; ++i)
+        {
+            std::map<std::string, std::string> attributes
+            {
+                {attributeName, getName(statistics[i])}
+            };
+            observer->Observe(getValue(statistics[i]), attributes);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        if (auto nFailed = failureLog.add(); nFailed > 0)
+        {
+            SPDLOG_LOGGER_WARN(logger,
+                               "Failed to observe {} {} statistics; latest because {}",
+                               nFailed, attributeName, std::string {e.what()});
+        }
+    }
+}
+}
+
+namespace UDataPacketService
+{
+
+/// @class Process
+/// @brief The service's pipeline.  Packets from the import subscriber are
+///        converted, queued, and propagated to the broadcast server.
+/// @note Signals are handled on the thread that calls \c start().  An
+///       embedding program may instead end the process with
+///       \c requestStop().
+export class Process
+{
+public:
+    Process(const UDataPacketService::ProgramOptions &options,
+            std::shared_ptr<spdlog::logger> logger) :
+        mOptions(options),
+        mLogger(logger)
+    {
+#ifndef NDEBUG
+        assert(mLogger != nullptr);
+#endif
+        if (mOptions.importQueueHighWaterMark)
+        {
+            // Let the proxy buffer rather than dropping packets here
+            auto highWaterMark = *mOptions.importQueueHighWaterMark;
+            SPDLOG_LOGGER_INFO(mLogger,
+                               "Import flow control enabled at {} packets",
+                               highWaterMark);
+            mSubscriber
+                = std::make_unique<UDataPacketService::Subscriber>
+                  (mOptions.subscriberOptions,
+                   mAddPacketCallbackFunction,
+                   [this, highWaterMark]()
+                   {
+                       return mImportQueue->size() >= highWaterMark;
+                   },
+                   mLogger);
+        }
+        else
+        {
+            mSubscriber
+                = std::make_unique<UDataPacketService::Subscriber>
+                  (mOptions.subscriberOptions, mAddPacketCallbackFunction,
+                   mLogger);
+        }
+        mService 
+            = std::make_unique<UDataPacketService::Server>
+              (mOptions.serverOptions, mLogger);
+        mSubscriptionManager
+            = std::make_unique<UDataPacketService::SubscriptionManager>
+              (mOptions.subscriptionManagerOptions, mLogger);
+        // Each stream gets its own import queue so a backfilling station
+        // can't push out everyone else's real-time data
+        mImportQueue
+            = std::make_unique<UDataPacketService::FairPacketQueue>
+              (mOptions.maximumImportQueueSize,
+               mOptions.importQueueQuantum);
+        mBackfillThreshold = mOptions.serverOptions.getBackfillThreshold();
+        if (mOptions.memoryBudget)
+        {
+            UDataPacketService::MemoryBudget::getInstance().setLimit(
+                *mOptions.memoryBudget);
+        }
+        // Overlapping import streams will deliver the same packets
+        if (mOptions.subscriberOptions.getNumberOfStreams() > 1)
+        {
+            DuplicatePacketDetectorOptions duplicateOptions;
+            mImportDuplicatePacketDetector
+                = std::make_unique<DuplicatePacketDetector>
+                  (duplicateOptions);
+        }
+
+        if (mOptions.exportMetrics)
+        {
+            // Need a provider from which to get a meter.  This is initialized
+            // once and should last the duration of the application.
+            auto provider 
+                = opentelemetry::metrics::Provider::GetMeterProvider();
+    
+            // Meter will be bound to application (library, module, class, etc.)
+            // so as to identify who is genreating these metrics.
+            auto meter = provider->GetMeter(mOptions.applicationName, "1.2.0");
+
+            namespace UMetrics = UDataPacketService::Metrics;
+            // Packets received from import
+            totalPacketsReceivedCounter
+                = meter->CreateInt64ObservableCounter(
+                    "seismic_data.import.grpc.client.packets.received",
+                    "Number of packets received from the gRPC import data packet proxy.",
+                    "{packets}");
+            totalPacketsReceivedCounter->AddCallback(
+                UMetrics::observeNumberOfPacketsReceived,
+                nullptr);
+
+            // Total packets sent
+            totalPacketsSentCounter
+                = meter->CreateInt64ObservableCounter(
+                    "seismic_data.import.grpc.server.packets.sent",
+                    "Number of packets sent from the gRPC seismic data packet service.",
+                    "{packets}");
+            totalPacketsSentCounter->AddCallback(
+                UMetrics::observeNumberOfPacketsSent,
+                nullptr);
+
+            // Total bytes sent
+            totalBytesSentCounter
+                = meter->CreateInt64ObservableCounter(
+                    "seismic_data.import.grpc.server.bytes.sent",
+                    "Number of serialized packet bytes sent from the gRPC seismic data packet service.",
+                    "By");
+            totalBytesSentCounter->AddCallback(
+                UMetrics::observeNumberOfBytesSent,
+                nullptr);
+
+            // Packets dropped because a queue was full
+            totalPacketsDroppedCounter
+                = meter->CreateInt64ObservableCounter(
+                    "seismic_data.service.packets.dropped",
+                    "Number of packets dropped because a queue was full.",
+                    "{packets}");
+            totalPacketsDroppedCounter->AddCallback(
+                UMetrics::observeNumberOfPacketsDropped,
+                nullptr);
+
+            // Utilization
+            utilizationGauge
+                = meter->CreateDoubleObservableGauge(
+                  "seismic_data.import.grpc.server.utilization",
+                  "Proportion of subscribers receiving packets from the service.",
+                  "");
+            utilizationGauge->AddCallback(
+                UMetrics::observeUtilization,
+                nullptr);
+
+            // Latency through each stage of the pipeline
+            latencyGauge
+                = meter->CreateDoubleObservableGauge(
+                  "seismic_data.service.pipeline.latency",
+                  "Latency quantiles of each pipeline stage since the last export.",
+                  "us");
+            latencyGauge->AddCallback(
+                UMetrics::observeLatencies,
+                nullptr);
+
+            // Size of the stream registry
+            streamsGauge
+                = meter->CreateInt64ObservableGauge(
+                  "seismic_data.service.streams",
+                  "Number of streams held by the subscription manager.",
+                  "{streams}");
+            streamsGauge->AddCallback(
+                UMetrics::observeNumberOfStreams,
+                nullptr);
+
+            // Streams removed because they went idle or the registry was full
+            totalStreamsEvictedCounter
+                = meter->CreateInt64ObservableCounter(
+                    "seismic_data.service.streams.evicted",
+                    "Number of streams removed because they were idle or the registry was full.",
+                    "{streams}");
+            totalStreamsEvictedCounter->AddCallback(
+                UMetrics::observeNumberOfEvictedStreams,
+                nullptr);
+
+            // Bytes held by the queues and logs
+            memoryBudgetGauge
+                = meter->CreateInt64ObservableGauge(
+                  "seismic_data.service.memory.queued",
+                  "Bytes held by the import queue, subscription logs, and writer queues.",
+                  "By");
+            memoryBudgetGauge->AddCallback(
+                UMetrics::observeMemoryBudgetBytes,
+                nullptr);
+
+            // Per-stream and per-subscriber statistics for the top N
+            if (mOptions.statisticsTopN > 0)
+            {
+                createStatisticsGauges(*meter);
+            }
+
+        }
+    }
+
+    ~Process()
+    {
+        stop();
+        // The callbacks refer to me
+        for (auto &[gauge, callback] : statisticsGauges)
+        {
+            gauge->RemoveCallback(callback, this);
+        }
+        statisticsGauges.clear();
+    }
+
+    void stop()
+    {
+        mKeepRunning.store(false);
+        // Stop receiving packets
+        if (mSubscriber){mSubscriber->stop();}
+        std::this_thread::sleep_for(std::chrono::milliseconds {25});
+        // Stop sending packets
+        if (mService){mService->stop();}
+        // Check my futures
+        for (auto &future : mFutures)
+        {   
+            if (future.valid()){future.get();}
+        }   
+    }
+
+    /// Asks the thread that called start() to stop the process and return.
+    void requestStop()
+    {
+        {
+        std::lock_guard<std::mutex> lock(mStopMutex);
+        mStopRequested = true;
+        }
+        mStopCondition.notify_all();
+    }
+
+    void start()
+    {
+#ifndef NDEBUG
+        assert(mLogger != nullptr);
+        assert(mSubscriber != nullptr);
+        assert(mService != nullptr);
+#endif
+        mKeepRunning.store(true);
+        mFutures.push_back(std::async(&Process::propagateImportPackets, this));
+        mService->start();
+        mFutures.push_back(mSubscriber->start());
+        handleMainThread();
+    }
+
+    /// The subscriber calls this from its read callback so the received
+    /// time is effectively when the packet came off the wire.
+    void addPacketCallback(UDataPacketImportAPI::V1::Packet &&inputPacket)
+    {
+        auto &metrics
+            = UDataPacketService::Metrics::MetricsSingleton::getInstance();
+        metrics.incrementReceivedPacketsCounter();
+        try
+        {
+            auto receivedTime
+                = UDataPacketService::Utilities::getNow<std::chrono::nanoseconds> ();
+            auto packet = UDataPacketService::convert(std::move(inputPacket));
+            if (mImportDuplicatePacketDetector &&
+                !mImportDuplicatePacketDetector->allow(packet))
+            {
+                metrics.incrementDroppedPacketsCounter(
+                    UDataPacketService::Metrics::DropLocation::Duplicate);
+                return;
+            }
+            // Backfill waits behind the real-time data
+            auto lane = UDataPacketService::FairPacketQueue::Lane::RealTime;
+            if (UDataPacketService::Utilities::isBackfill(
+                    packet, mBackfillThreshold,
+                    std::chrono::duration_cast<std::chrono::microseconds>
+                        (receivedTime)))
+            {
+                lane = UDataPacketService::FairPacketQueue::Lane::Backfill;
+            }
+            // Send the packet.  If the queue is full then this drops the
+            // oldest packet of the longest stream, backfill first.
+            mImportQueue->push(std::move(packet), receivedTime, lane);
+        }
+        catch (const std::exception &e)
+        {
+            // A malformed stream fails every packet so only summarize
+            if (auto nFailed = mAddPacketFailureLog.add(); nFailed > 0)
+            {
+                SPDLOG_LOGGER_WARN(mLogger,
+                                   "Failed to add {} packets; latest because {}",
+                                   nFailed, std::string {e.what()});
+            }
+        }
+    } 
+
+    /// Sends the import packets to the client(s)
+    void propagateImportPackets()
+    {
+#ifndef NDEBUG
+        assert(mLogger != nullptr);
+        assert(mSubscriptionManager != nullptr);
+#endif
+        const std::chrono::microseconds timeOut{10};
+        auto &metrics
+            = UDataPacketService::Metrics::MetricsSingleton::getInstance();
+        while (mKeepRunning.load())
+        {
+            UDataPacketServiceAPI::V1::Packet packet;
+            std::chrono::nanoseconds receivedTime{0};
+            if (mImportQueue->tryPop(packet, receivedTime))
+            {
+                try
+                {
+                    namespace UMetrics = UDataPacketService::Metrics;
+                    auto dequeueTime
+                        = UDataPacketService::Utilities::getNow<std::chrono::nanoseconds> ();
+                    metrics.recordLatency(
+                        UMetrics::LatencyStage::ImportQueue,
+                        dequeueTime - receivedTime);
+                    mService->enqueuePacket(std::move(packet));
+                    metrics.recordLatency(
+                        UMetrics::LatencyStage::FanOut,
+                        UDataPacketService::Utilities::getNow<std::chrono::nanoseconds> ()
+                      - dequeueTime);
+                }
+                catch (const std::exception &e)
+                {
+                    if (auto nFailed = mEnqueueFailureLog.add(); nFailed > 0)
+                    {
+                        SPDLOG_LOGGER_WARN(mLogger,
+                "Failed to enqueue {} packets into subscription manager; latest because {}",
+                                           nFailed, std::string {e.what()});
+                    }
+                }
+            }
+            else
+            {
+                std::this_thread::sleep_for(timeOut); 
+            }
+        }
+    }
+
+    /// Logs the rate-limited warnings that are still pending
+    void reportSuppressedWarnings()
+    {
+        if (auto nFailed = mAddPacketFailureLog.poll(); nFailed > 0)
+        {
+            SPDLOG_LOGGER_WARN(mLogger, "Failed to add {} more packets",
+                               nFailed);
+        }
+        if (auto nFailed = mEnqueueFailureLog.poll(); nFailed > 0)
+        {
+            SPDLOG_LOGGER_WARN(mLogger,
+                "Failed to enqueue {} more packets into subscription manager",
+                               nFailed);
+        }
+        if (auto nFailed = mObserveFailureLog.poll(); nFailed > 0)
+        {
+            SPDLOG_LOGGER_WARN(mLogger,
+                               "Failed to observe statistics {} more times",
+                               nFailed);
+        }
+        if (mService){mService->reportSuppressedWarnings();}
+    }
+
+    // Print some summary statistics
+    void printSummary()
+    {
+        if (mOptions.printSummaryInterval.count() <= 0){return;}
+        auto now
+            = std::chrono::duration_cast<std::chrono::microseconds>
+              ((std::chrono::high_resolution_clock::now()).time_since_epoch());
+        if (now > mLastPrintSummary + mOptions.printSummaryInterval)
+        {
+            auto &metrics
+                = UDataPacketService::Metrics::MetricsSingleton::getInstance();
+            mLastPrintSummary = now;
+            auto nSubscribers = mService->getNumberOfSubscribers();
+            if (mOptions.exportMetrics)
+            {
+                int64_t currentNumberOfPacketsReceived
+                    = metrics.getReceivedPacketsCount();
+                auto reportPacketsReceived = currentNumberOfPacketsReceived
+                                           - mReportNumberOfPacketsReceived;
+                SPDLOG_LOGGER_INFO(mLogger,
+                                   "Received {} packets since last update.  Currently servicing {} subscribers.",
+                                   reportPacketsReceived, nSubscribers);
+                mReportNumberOfPacketsReceived = currentNumberOfPacketsReceived;
+            }
+            else
+            {
+                SPDLOG_LOGGER_INFO(mLogger,
+                                   "Currently servicing {} subscribers.",
+                                   nSubscribers);
+            }
+        }
+    }
+
+    /// Creates the gauges for the busiest/laggiest streams and subscribers
+    void createStatisticsGauges(opentelemetry::metrics::Meter &meter)
+    {
+        auto addGauge = [&](const std::string &name,
+                            const std::string &description,
+                            const std::string &unit,
+                            opentelemetry::metrics::ObservableCallbackPtr callback)
+        {
+            auto gauge
+                = meter.CreateDoubleObservableGauge(name, description, unit);
+            gauge->AddCallback(callback, this);
+            statisticsGauges.push_back(std::pair {gauge, callback});
+        };
+        addGauge("seismic_data.service.stream.packet_rate",
+                 "Packet rate of the streams with the highest rates.",
+                 "{packets}/s", observeStreamPacketRates);
+        addGauge("seismic_data.service.stream.last_packet_age",
+                 "Time since the last packet of the stalest streams.",
+                 "s", observeStreamPacketAges);
+        addGauge("seismic_data.service.subscriber.packet_rate",
+                 "Write rate of the subscribers with the highest rates.",
+                 "{packets}/s", observeSubscriberPacketRates);
+        addGauge("seismic_data.service.subscriber.queue_depth",
+                 "Packets waiting for the subscribers with the deepest queues.",
+                 "{packets}", observeSubscriberQueueDepths);
+        addGauge("seismic_data.service.subscriber.packets.dropped",
+                 "Packets dropped by the subscribers with the most drops.",
+                 "{packets}", observeSubscriberDroppedPackets);
+    }
+
+    static void observeStreamPacketRates(
+        opentelemetry::metrics::ObserverResult observerResult, void *state)
+    {
+        auto process = static_cast<Process *> (state);
+        ::observeTopN<StreamStatistics>(
+            observerResult,
+            [process](){return process->mService->getStreamStatistics();},
+            static_cast<size_t> (process->mOptions.statisticsTopN),
+            "stream",
+            [](const StreamStatistics &s){return s.identifier;},
+            [](const StreamStatistics &s){return s.packetsPerSecond;},
+            process->mLogger.get(),
+            process->mObserveFailureLog);
+    }
+
+    static void observeStreamPacketAges(
+        opentelemetry::metrics::ObserverResult observerResult, void *state)
+    {
+        auto process = static_cast<Process *> (state);
+        auto now = Utilities::getNow<std::chrono::nanoseconds> ();
+        ::observeTopN<StreamStatistics>(
+            observerResult,
+            [process](){return process->mService->getStreamStatistics();},
+            static_cast<size_t> (process->mOptions.statisticsTopN),
+            "stream",
+            [](const StreamStatistics &s){return s.identifier;},
+            [now](const StreamStatistics &s)
+            {
+                return (now - s.lastPacketTime).count()*1.e-9;
+            },
+            process->mLogger.get(),
+            process->mObserveFailureLog);
+    }
+
+    static void observeSubscriberPacketRates(
+        opentelemetry::metrics::ObserverResult observerResult, void *state)
+    {
+        auto process = static_cast<Process *> (state);
+        ::observeTopN<SubscriberStatistics>(
+            observerResult,
+            [process](){return process->mService->getSubscriberStatistics();},
+            static_cast<size_t> (process->mOptions.statisticsTopN),
+            "subscriber",
+            [](const SubscriberStatistics &s){return s.peer;},
+            [](const SubscriberStatistics &s){return s.packetsPerSecond;},
+            process->mLogger.get(),
+            process->mObserveFailureLog);
+    }
+
+    static void observeSubscriberQueueDepths(
+        opentelemetry::metrics::ObserverResult observerResult, void *state)
+    {
+        auto process = static_cast<Process *> (state);
+        ::observeTopN<SubscriberStatistics>(
+            observerResult,
+            [process](){return process->mService->getSubscriberStatistics();},
+            static_cast<size_t> (process->mOptions.statisticsTopN),
+            "subscriber",
+            [](const SubscriberStatistics &s){return s.peer;},
+            [](const SubscriberStatistics &s)
+            {
+                return static_cast<double> (s.queueDepth);
+            },
+            process->mLogger.get(),
+            process->mObserveFailureLog);
+    }
+
+    static void observeSubscriberDroppedPackets(
+        opentelemetry::metrics::ObserverResult observerResult, void *state)
+    {
+        auto process = static_cast<Process *> (state);
+        ::observeTopN<SubscriberStatistics>(
+            observerResult,
+            [process](){return process->mService->getSubscriberStatistics();},
+            static_cast<size_t> (process->mOptions.statisticsTopN),
+            "subscriber",
+            [](const SubscriberStatistics &s){return s.peer;},
+            [](const SubscriberStatistics &s)
+            {
+                return static_cast<double> (s.packetsDropped);
+            },
+            process->mLogger.get(),
+            process->mObserveFailureLog);
+    }
+
+    /// Check futures
+    [[nodiscard]]
+    bool checkFuturesOkay(const std::chrono::milliseconds &timeOut)
+    {
+        bool isOkay{true};
+        for (auto &future : mFutures)
+        {
+            try
+            {
+                auto status = future.wait_for(timeOut);
+                if (status == std::future_status::ready)
+                {
+                    future.get();
+                }
+            }
+            catch (const std::exception &e)
+            {
+                SPDLOG_LOGGER_CRITICAL(mLogger,
+                                       "Fatal error detected from thread: {}",
+                                       std::string {e.what()});
+                isOkay = false;
+            }
+        }
+        return isOkay;
+    }
+
+    // Let main thread handle signals from OS and deal with exceptions
+    void handleMainThread()
+    {
+        SPDLOG_LOGGER_DEBUG(mLogger, "Main thread entering waiting loop");
+        catchSignals();
+        while (!mStopRequested)
+        {
+            if (mInterrupted)
+            {   
+                SPDLOG_LOGGER_INFO(mLogger,
+                                   "SIGINT/SIGTERM signal received!");
+                mStopRequested = true;
+                mShutdownRequested = true;
+                mShutdownCondition.notify_all();
+                break;
+            }
+            if (!checkFuturesOkay(std::chrono::milliseconds {5}))
+            {
+                SPDLOG_LOGGER_CRITICAL(
+                   mLogger,
+                   "Futures exception caught; terminating app");
+                mStopRequested = true;
+                mShutdownRequested = true;
+                mShutdownCondition.notify_all();
+                break;
+            }
+            printSummary();
+            reportSuppressedWarnings();
+            std::unique_lock<std::mutex> lock(mStopMutex);
+            mStopCondition.wait_for(lock,
+                                    std::chrono::milliseconds {100},
+                                    [this]
+                                    {
+                                          return mStopRequested.load();
+                                    });
+            lock.unlock();
+        }
+        if (mStopRequested)
+        {
+            SPDLOG_LOGGER_DEBUG(mLogger, "Stop request received.  Exiting...");
+            stop();
+        }
+    }
+
+    /// Handles sigterm and sigint
+    static void signalHandler(const int )
+    {   
+        mInterrupted = true;
+    }
+
+    static void catchSignals()
+    {   
+        struct sigaction action;
+        action.sa_handler = signalHandler;
+        action.sa_flags = 0;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT,  &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+    }   
+
+//private:
+    UDataPacketService::ProgramOptions mOptions; 
+    std::shared_ptr<spdlog::logger> mLogger{nullptr};
+    std::unique_ptr<UDataPacketService::Subscriber> mSubscriber{nullptr};
+    std::unique_ptr<UDataPacketService::DuplicatePacketDetector>
+        mImportDuplicatePacketDetector{nullptr};
+    std::shared_ptr<UDataPacketService::SubscriptionManager>
+        mSubscriptionManager{nullptr};
+    std::unique_ptr<UDataPacketService::Server> mService{nullptr};
+    std::vector<std::future<void>> mFutures;
+    std::unique_ptr<UDataPacketService::FairPacketQueue> mImportQueue{nullptr};
+    std::chrono::microseconds mBackfillThreshold{std::chrono::minutes {2}};
+    UDataPacketService::Utilities::RateLimitedLog mAddPacketFailureLog;
+    UDataPacketService::Utilities::RateLimitedLog mEnqueueFailureLog;
+    UDataPacketService::Utilities::RateLimitedLog mObserveFailureLog;
+    std::function<void(UDataPacketImportAPI::V1::Packet &&)>
+        mAddPacketCallbackFunction
+    {
+        std::bind(&Process::addPacketCallback, this,
+                  std::placeholders::_1)
+    };  
+    mutable std::mutex mStopMutex;
+    mutable std::mutex mShutdownMutex;
+    std::condition_variable mStopCondition;
+    std::condition_variable mShutdownCondition;
+    std::chrono::microseconds mLastPrintSummary
+    {
+        UDataPacketService::Utilities::getNow<std::chrono::microseconds> ()
+    };
+    int64_t mReportNumberOfPacketsReceived{0};
+    std::atomic<bool> mKeepRunning{true};
+    std::atomic<bool> mStopRequested{false};
+    bool mShutdownRequested{false};
+};
+
+}
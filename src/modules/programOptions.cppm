@@ -2,7 +2,10 @@ module;
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <optional>
 #include <chrono>
+#include <cmath>
 #include <fstream>
 #include <sstream>
 #include <filesystem>
@@ -48,7 +51,14 @@ export struct ProgramOptions
     OTelHTTPLogOptions otelHTTPLogOptions;
     std::chrono::seconds printSummaryInterval{std::chrono::minutes {15}};
     int verbosity{3};
+    int logQueueSize{8192}; // Messages waiting to be written
+    std::optional<int64_t> memoryBudget; // Bytes the queues may hold
     int maximumImportQueueSize{8192};
+    int importQueueQuantum{8192}; // Bytes per stream per round-robin turn
+    // If set, the subscriber stops reading while the import queue holds
+    // at least this many packets
+    std::optional<int> importQueueHighWaterMark;
+    int statisticsTopN{10};
     bool exportLogs{false};
     bool exportMetrics{false};
 };
@@ -196,6 +206,31 @@ loadStringFromFile(const std::filesystem::path &path)
         options.setClientKey(loadStringFromFile(clientKey));
         options.setClientCertificate(loadStringFromFile(clientCertificate));
     }
+
+    // Channel tuning
+    auto keepAliveTime
+        = propertyTree.get_optional<int> (section + ".keepAliveTimeMS");
+    if (keepAliveTime)
+    {
+        options.setKeepAliveTime(std::chrono::milliseconds {*keepAliveTime});
+    }
+    auto keepAliveTimeout
+        = propertyTree.get<int> (section + ".keepAliveTimeoutMS",
+                                 static_cast<int> (
+                                    options.getKeepAliveTimeout().count()));
+    options.setKeepAliveTimeout(std::chrono::milliseconds {keepAliveTimeout});
+    options.setMaximumReceiveMessageSize(
+        propertyTree.get<int> (section + ".maximumReceiveMessageSize",
+                               options.getMaximumReceiveMessageSize()));
+    auto windowSize
+        = propertyTree.get_optional<int> (section + ".http2InitialWindowSize");
+    if (windowSize){options.setHTTP2InitialWindowSize(*windowSize);}
+    options.enableBDPProbe(
+        propertyTree.get<bool> (section + ".enableBDPProbe",
+                                options.isBDPProbeEnabled()));
+    options.useDedicatedConnection(
+        propertyTree.get<bool> (section + ".useDedicatedConnection",
+                                options.useDedicatedConnection()));
     return options;
 }
 
@@ -267,6 +302,56 @@ loadStringFromFile(const std::filesystem::path &path)
         }
         options.setClientCertificate(loadStringFromFile(clientCertificate));
     }
+
+    // Server tuning
+    auto memoryQuota
+        = propertyTree.get_optional<int64_t> (section + ".memoryQuota");
+    if (memoryQuota){options.setMemoryQuota(*memoryQuota);}
+    auto maximumReceiveMessageSize
+        = propertyTree.get_optional<int> (section + ".maximumReceiveMessageSize");
+    if (maximumReceiveMessageSize)
+    {
+        options.setMaximumReceiveMessageSize(*maximumReceiveMessageSize);
+    }
+    auto maximumSendMessageSize
+        = propertyTree.get_optional<int> (section + ".maximumSendMessageSize");
+    if (maximumSendMessageSize)
+    {
+        options.setMaximumSendMessageSize(*maximumSendMessageSize);
+    }
+    auto writeBufferSize
+        = propertyTree.get_optional<int> (section + ".http2WriteBufferSize");
+    if (writeBufferSize){options.setHTTP2WriteBufferSize(*writeBufferSize);}
+    auto maximumConcurrentStreams
+        = propertyTree.get_optional<int> (section + ".maximumConcurrentStreams");
+    if (maximumConcurrentStreams)
+    {
+        options.setMaximumConcurrentStreams(*maximumConcurrentStreams);
+    }
+    auto keepAliveTime
+        = propertyTree.get_optional<int> (section + ".keepAliveTimeMS");
+    if (keepAliveTime)
+    {
+        options.setKeepAliveTime(std::chrono::milliseconds {*keepAliveTime});
+    }
+    auto keepAliveTimeout
+        = propertyTree.get<int> (section + ".keepAliveTimeoutMS",
+                                 static_cast<int> (
+                                    options.getKeepAliveTimeout().count()));
+    options.setKeepAliveTimeout(std::chrono::milliseconds {keepAliveTimeout});
+    auto minimumClientPingInterval
+        = propertyTree.get_optional<int> (section + ".minimumClientPingIntervalMS");
+    if (minimumClientPingInterval)
+    {
+        options.setMinimumClientPingInterval(
+            std::chrono::milliseconds {*minimumClientPingInterval});
+    }
+    auto permitKeepAliveWithoutCalls
+        = propertyTree.get_optional<bool> (section + ".permitKeepAliveWithoutCalls");
+    if (permitKeepAliveWithoutCalls)
+    {
+        options.permitKeepAliveWithoutCalls(*permitKeepAliveWithoutCalls);
+    }
     return options;        
 }
 
@@ -288,6 +373,21 @@ export ProgramOptions
     }
     options.verbosity
         = propertyTree.get<int> ("General.verbosity", options.verbosity);
+    options.logQueueSize
+        = propertyTree.get<int> ("General.logQueueSize", options.logQueueSize);
+    if (options.logQueueSize < 1)
+    {
+        throw std::invalid_argument("General.logQueueSize must be positive");
+    }
+    options.statisticsTopN
+        = propertyTree.get<int> ("General.statisticsTopN",
+                                 options.statisticsTopN);
+    if (options.statisticsTopN < 0)
+    {
+        throw std::invalid_argument("General.statisticsTopN "
+                                  + std::to_string(options.statisticsTopN)
+                                  + " cannot be negative");
+    }
     options.exportMetrics = false;
     options.exportLogs = false;
 
@@ -333,6 +433,11 @@ export ProgramOptions
             }
         }
     }
+    if (!metricsOptions.url.empty())
+    {
+        options.exportMetrics = true;
+        options.otelHTTPMetricsOptions = metricsOptions;
+    }
 
     // Server
     ServerOptions serverOptions;
@@ -349,6 +454,85 @@ export ProgramOptions
                                   + " must be positive");
     }
     serverOptions.setMaximumNumberOfSubscribers(maxSubscribers);
+    serverOptions.enableAdminService(
+        propertyTree.get<bool> ("Server.enableAdminService",
+                                serverOptions.isAdminServiceEnabled()));
+    auto backfillThreshold
+        = propertyTree.get_optional<double> ("Server.backfillThresholdS");
+    if (backfillThreshold)
+    {
+        serverOptions.setBackfillThreshold(
+            std::chrono::microseconds
+            {static_cast<int64_t> (std::round(*backfillThreshold*1000000))});
+    }
+
+    // Subscription manager
+    SubscriptionManagerOptions subscriptionManagerOptions;
+    subscriptionManagerOptions.setBroadcastLogCapacity(
+        propertyTree.get<int> ("SubscriptionManager.broadcastLogCapacity",
+            subscriptionManagerOptions.getBroadcastLogCapacity()));
+    auto idleStreamTimeout
+        = propertyTree.get<int> ("SubscriptionManager.idleStreamTimeoutS",
+              static_cast<int> (
+                  subscriptionManagerOptions.getIdleStreamTimeout().count()));
+    subscriptionManagerOptions.setIdleStreamTimeout(
+        std::chrono::seconds {idleStreamTimeout});
+    subscriptionManagerOptions.setMaximumNumberOfStreams(
+        propertyTree.get<int> ("SubscriptionManager.maximumNumberOfStreams",
+            subscriptionManagerOptions.getMaximumNumberOfStreams()));
+    StreamOptions streamOptions;
+    streamOptions.setMaximumQueueSize(
+        propertyTree.get<int> ("SubscriptionManager.maximumStreamQueueSize",
+                               streamOptions.getMaximumQueueSize()));
+    auto maximumQueueDuration
+        = propertyTree.get_optional<double>
+          ("SubscriptionManager.maximumStreamQueueDurationS");
+    if (maximumQueueDuration)
+    {
+        streamOptions.setMaximumQueueDuration(
+            std::chrono::milliseconds
+            {static_cast<int64_t> (std::round(*maximumQueueDuration*1000))});
+    }
+    auto maximumQueueBytes
+        = propertyTree.get_optional<int64_t>
+          ("SubscriptionManager.maximumStreamQueueBytes");
+    if (maximumQueueBytes)
+    {
+        streamOptions.setMaximumQueueBytes(*maximumQueueBytes);
+    }
+    subscriptionManagerOptions.setStreamOptions(streamOptions);
+    auto sheddingPolicy
+        = propertyTree.get<std::string> ("SubscriptionManager.sheddingPolicy",
+                                         "laggiest_subscriber");
+    if (sheddingPolicy == "laggiest_subscriber")
+    {
+        subscriptionManagerOptions.setSheddingPolicy(
+            SubscriptionManagerOptions::SheddingPolicy::LaggiestSubscriber);
+    }
+    else if (sheddingPolicy == "none")
+    {
+        subscriptionManagerOptions.setSheddingPolicy(
+            SubscriptionManagerOptions::SheddingPolicy::None);
+    }
+    else
+    {
+        throw std::invalid_argument("Unhandled shedding policy "
+                                  + sheddingPolicy);
+    }
+    auto memoryBudget
+        = propertyTree.get_optional<int64_t> ("SubscriptionManager.memoryBudget");
+    if (memoryBudget)
+    {
+        if (*memoryBudget <= 0)
+        {
+            throw std::invalid_argument("SubscriptionManager.memoryBudget "
+                                      + std::to_string(*memoryBudget)
+                                      + " must be positive");
+        }
+        options.memoryBudget = *memoryBudget;
+    }
+    options.subscriptionManagerOptions = subscriptionManagerOptions;
+    serverOptions.setSubscriptionManagerOptions(subscriptionManagerOptions);
     options.serverOptions = serverOptions;
 
     // Subscriber
@@ -358,7 +542,61 @@ export ProgramOptions
     subscriberOptions.setGRPCOptions(subscriberGRPCOptions);
     subscriberOptions.setIdentifier(options.applicationName
                                   + "-import-subscriber");
+    // Proxy replicas are listed as [SubscriberReplica1], [SubscriberReplica2],
+    // and so on
+    std::vector<UDataPacketService::GRPCClientOptions> replicaGRPCOptions;
+    for (int replica = 1; ; ++replica)
+    {
+        auto section = "SubscriberReplica" + std::to_string(replica);
+        if (!propertyTree.get_child_optional(section)){break;}
+        replicaGRPCOptions.push_back(getGRPCClientOptions(propertyTree,
+                                                          section));
+    }
+    subscriberOptions.setReplicaGRPCOptions(replicaGRPCOptions);
+    // By default every proxy is subscribed to (hot standby) so losing one
+    // leaves no gap
+    auto nProxies = static_cast<int> (replicaGRPCOptions.size()) + 1;
+    auto nImportStreams
+        = propertyTree.get<int> ("Subscriber.numberOfStreams", nProxies);
+    // A proxy sends its whole feed to every subscription so a second
+    // stream to the same proxy only duplicates it
+    if (nImportStreams > nProxies)
+    {
+        throw std::invalid_argument("Subscriber.numberOfStreams "
+                                  + std::to_string(nImportStreams)
+                                  + " cannot exceed the number of proxies "
+                                  + std::to_string(nProxies));
+    }
+    subscriberOptions.setNumberOfStreams(nImportStreams);
     options.subscriberOptions = subscriberOptions;
+    // Packets wait here for the subscription manager
+    options.maximumImportQueueSize
+        = propertyTree.get<int> ("Subscriber.maximumImportQueueSize",
+                                 options.maximumImportQueueSize);
+    if (options.maximumImportQueueSize < 1)
+    {
+        throw std::invalid_argument("Subscriber.maximumImportQueueSize must be positive");
+    }
+    options.importQueueQuantum
+        = propertyTree.get<int> ("Subscriber.importQueueQuantum",
+                                 options.importQueueQuantum);
+    if (options.importQueueQuantum < 1)
+    {
+        throw std::invalid_argument("Subscriber.importQueueQuantum must be positive");
+    }
+    auto highWaterMark
+        = propertyTree.get_optional<int> ("Subscriber.importQueueHighWaterMark");
+    if (highWaterMark)
+    {
+        if (*highWaterMark < 1 ||
+            *highWaterMark > options.maximumImportQueueSize)
+        {
+            throw std::invalid_argument(
+               "Subscriber.importQueueHighWaterMark must be in range [1,"
+             + std::to_string(options.maximumImportQueueSize) + "]");
+        }
+        options.importQueueHighWaterMark = *highWaterMark;
+    }
 
     return options;
 }
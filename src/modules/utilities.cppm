@@ -1,7 +1,9 @@
 module;
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <string>
 #include <google/protobuf/util/time_util.h>
 #include "uDataPacketServiceAPI/v1/packet.pb.h"
@@ -43,6 +45,15 @@ template<typename T>
     return now;
 }
 
+export
+[[nodiscard]] std::chrono::microseconds 
+    getStartTimeInMicroSeconds(const UDataPacketServiceAPI::V1::Packet &packet)
+{
+    return std::chrono::microseconds
+           {google::protobuf::util::TimeUtil::TimestampToMicroseconds(
+               packet.start_time())};
+}
+
 export
 [[nodiscard]] std::chrono::microseconds 
     getEndTimeInMicroSeconds(const UDataPacketServiceAPI::V1::Packet &packet)
@@ -61,6 +72,79 @@ export
     return std::chrono::microseconds {endTimeMuSec};
 }
 
+/// @result True indicates the packet starts more than the threshold behind
+///         now, i.e., it is backfill rather than real-time data.  This is
+///         the same test the expired packet detector applies.
+export
+[[nodiscard]] bool isBackfill(const UDataPacketServiceAPI::V1::Packet &packet,
+                              const std::chrono::microseconds &threshold,
+                              const std::chrono::microseconds &now)
+{
+    auto earliestTime = now - threshold;
+    return getStartTimeInMicroSeconds(packet) < earliestTime;
+}
+
+/// @brief Folds a repetitive hot-path message into periodic summaries.
+///        The first occurrence is reported immediately.  Later occurrences
+///        are counted and reported together once the interval has passed
+///        so that, e.g., a slow client can't produce a log storm.
+/// @note This is thread-safe.
+export
+class RateLimitedLog
+{
+public:
+    explicit RateLimitedLog(const std::chrono::seconds &interval =
+                                std::chrono::seconds {10}) :
+        mInterval(std::chrono::duration_cast<std::chrono::nanoseconds>
+                  (interval).count())
+    {
+    }
+    /// @brief Counts an occurrence.
+    /// @result The number of occurrences to report now.  This is 0 when the
+    ///         occurrence should not be logged.
+    [[nodiscard]] int64_t add() noexcept
+    {
+        mPending.fetch_add(1, std::memory_order_relaxed);
+        auto now = getNow<std::chrono::nanoseconds> ().count();
+        auto nextReport = mNextReport.load(std::memory_order_relaxed);
+        if (now < nextReport){return 0;}
+        // Only one thread gets to report
+        if (!mNextReport.compare_exchange_strong(nextReport, now + mInterval,
+                                                 std::memory_order_relaxed))
+        {
+            return 0;
+        }
+        return mPending.exchange(0, std::memory_order_relaxed);
+    }
+    /// @brief Lets occurrences that stopped arriving still be reported.
+    ///        Call this periodically.
+    /// @result The number of occurrences to report now.  This is 0 when
+    ///         nothing is pending or the interval has yet to pass.
+    [[nodiscard]] int64_t poll() noexcept
+    {
+        if (mPending.load(std::memory_order_relaxed) == 0){return 0;}
+        auto now = getNow<std::chrono::nanoseconds> ().count();
+        auto nextReport = mNextReport.load(std::memory_order_relaxed);
+        if (now < nextReport){return 0;}
+        if (!mNextReport.compare_exchange_strong(nextReport, now + mInterval,
+                                                 std::memory_order_relaxed))
+        {
+            return 0;
+        }
+        return mPending.exchange(0, std::memory_order_relaxed);
+    }
+    /// @result The number of occurrences not yet reported.  These are
+    ///         cleared.
+    [[nodiscard]] int64_t flush() noexcept
+    {
+        return mPending.exchange(0, std::memory_order_relaxed);
+    }
+private:
+    std::atomic<int64_t> mPending{0};
+    std::atomic<int64_t> mNextReport{0};
+    int64_t mInterval{10000000000};
+};
+
 }
 
 
@@ -6,13 +6,80 @@
 #include "uDataPacketService/server.hpp"
 #include "uDataPacketService/serverOptions.hpp"
 #include "uDataPacketService/subscriptionManager.hpp"
+#include "uDataPacketService/statistics.hpp"
 #include "uDataPacketService/grpcServerOptions.hpp"
 #include "uDataPacketServiceAPI/v1/broadcast.grpc.pb.h"
 
 import AsyncWriter;
+import AdminService;
 
 using namespace UDataPacketService;
 
+namespace
+{
+
+/// Applies the memory and transport limits to the server.  Unset values
+/// keep gRPC's defaults.
+void setServerLimits(grpc::ServerBuilder &builder,
+                     const GRPCServerOptions &options,
+                     spdlog::logger *logger)
+{
+    auto memoryQuota = options.getMemoryQuota();
+    if (memoryQuota)
+    {
+        SPDLOG_LOGGER_INFO(logger, "Limiting gRPC memory to {} bytes",
+                           *memoryQuota);
+        grpc::ResourceQuota resourceQuota{"uDataPacketService"};
+        resourceQuota.Resize(static_cast<size_t> (*memoryQuota));
+        builder.SetResourceQuota(resourceQuota);
+    }
+    auto maximumReceiveMessageSize = options.getMaximumReceiveMessageSize();
+    if (maximumReceiveMessageSize)
+    {
+        builder.SetMaxReceiveMessageSize(*maximumReceiveMessageSize);
+    }
+    auto maximumSendMessageSize = options.getMaximumSendMessageSize();
+    if (maximumSendMessageSize)
+    {
+        builder.SetMaxSendMessageSize(*maximumSendMessageSize);
+    }
+    auto writeBufferSize = options.getHTTP2WriteBufferSize();
+    if (writeBufferSize)
+    {
+        builder.AddChannelArgument(GRPC_ARG_HTTP2_WRITE_BUFFER_SIZE,
+                                   *writeBufferSize);
+    }
+    auto maximumConcurrentStreams = options.getMaximumConcurrentStreams();
+    if (maximumConcurrentStreams)
+    {
+        builder.AddChannelArgument(GRPC_ARG_MAX_CONCURRENT_STREAMS,
+                                   *maximumConcurrentStreams);
+    }
+    auto keepAliveTime = options.getKeepAliveTime();
+    if (keepAliveTime)
+    {
+        builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_TIME_MS,
+                                   static_cast<int> (keepAliveTime->count()));
+        builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_TIMEOUT_MS,
+            static_cast<int> (options.getKeepAliveTimeout().count()));
+    }
+    auto minimumClientPingInterval = options.getMinimumClientPingInterval();
+    if (minimumClientPingInterval)
+    {
+        builder.AddChannelArgument(
+            GRPC_ARG_HTTP2_MIN_RECV_PING_INTERVAL_WITHOUT_DATA_MS,
+            static_cast<int> (minimumClientPingInterval->count()));
+    }
+    auto permitKeepAliveWithoutCalls = options.permitKeepAliveWithoutCalls();
+    if (permitKeepAliveWithoutCalls)
+    {
+        builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS,
+                                   *permitKeepAliveWithoutCalls ? 1 : 0);
+    }
+}
+
+}
+
 class Server::ServerImpl :
     public UDataPacketServiceAPI::V1::Broadcast::CallbackService
 {
@@ -45,6 +112,7 @@ public:
         auto grpcOptions = mOptions.getGRPCOptions();
         auto address = makeAddress(grpcOptions);
         grpc::ServerBuilder builder;
+        ::setServerLimits(builder, grpcOptions, mLogger.get());
         if (grpcOptions.getServerKey() == std::nullopt ||
             grpcOptions.getServerCertificate() == std::nullopt)
         {
@@ -70,6 +138,21 @@ public:
             mSecureConnection = true;
         }   
 
+        if (mOptions.isAdminServiceEnabled() &&
+            (!mSecureConnection || !grpcOptions.getAccessToken()))
+        {
+            SPDLOG_LOGGER_WARN(mLogger,
+                "Admin service requires TLS and an access token; not enabling it");
+        }
+        else if (mOptions.isAdminServiceEnabled())
+        {
+            SPDLOG_LOGGER_INFO(mLogger, "Enabling admin service");
+            mAdminService
+                = std::make_unique<UDataPacketService::AdminService>
+                  (mOptions, mSecureConnection, mSubscriptionManager, mLogger);
+            builder.RegisterService(mAdminService.get());
+        }
+
         SPDLOG_LOGGER_INFO(mLogger, "Server listening at {}", address);
         mServer = builder.BuildAndStart();
         mServerStarted = true;
@@ -139,6 +222,7 @@ public:
     ServerOptions mOptions;
     std::shared_ptr<spdlog::logger> mLogger{nullptr};
     std::shared_ptr<SubscriptionManager> mSubscriptionManager{nullptr};
+    std::unique_ptr<UDataPacketService::AdminService> mAdminService{nullptr};
     std::unique_ptr<grpc::Server> mServer{nullptr};
     std::atomic<bool> mKeepRunning{true};
     bool mSecureConnection{false};  
@@ -182,5 +266,22 @@ int Server::getNumberOfSubscribers() const noexcept
     return pImpl->getNumberOfSubscribers();
 }
 
+/// Statistics
+std::vector<StreamStatistics> Server::getStreamStatistics() const
+{
+    return pImpl->mSubscriptionManager->getStreamStatistics();
+}
+
+std::vector<SubscriberStatistics> Server::getSubscriberStatistics() const
+{
+    return pImpl->mSubscriptionManager->getSubscriberStatistics();
+}
+
+/// Pending warnings
+void Server::reportSuppressedWarnings()
+{
+    pImpl->mSubscriptionManager->reportSuppressedWarnings();
+}
+
 /// Destructor
 Server::~Server() = default;
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <chrono>
 #include "uDataPacketService/serverOptions.hpp"
 #include "uDataPacketService/grpcServerOptions.hpp"
 #include "uDataPacketService/subscriptionManagerOptions.hpp"
@@ -10,7 +11,9 @@ class ServerOptions::ServerOptionsImpl
 public:
     GRPCServerOptions mGRPCOptions;
     SubscriptionManagerOptions mSubscriptionManagerOptions;
+    std::chrono::microseconds mBackfillThreshold{std::chrono::minutes {2}};
     int mMaximumNumberOfSubscribers{8};
+    bool mEnableAdminService{false};
 };
 
 /// Constructor
@@ -76,6 +79,33 @@ int ServerOptions::getMaximumNumberOfSubscribers() const noexcept
     return pImpl->mMaximumNumberOfSubscribers;
 }
 
+/// Admin service
+void ServerOptions::enableAdminService(const bool enable) noexcept
+{
+    pImpl->mEnableAdminService = enable;
+}
+
+bool ServerOptions::isAdminServiceEnabled() const noexcept
+{
+    return pImpl->mEnableAdminService;
+}
+
+/// Backfill threshold
+void ServerOptions::setBackfillThreshold(
+    const std::chrono::microseconds &threshold)
+{
+    if (threshold.count() <= 0)
+    {
+        throw std::invalid_argument("Backfill threshold must be positive");
+    }
+    pImpl->mBackfillThreshold = threshold;
+}
+
+std::chrono::microseconds ServerOptions::getBackfillThreshold() const noexcept
+{
+    return pImpl->mBackfillThreshold;
+}
+
 /// Subscription manager options
 void ServerOptions::setSubscriptionManagerOptions(
     const SubscriptionManagerOptions &options)
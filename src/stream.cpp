@@ -1,16 +1,18 @@
 #include <mutex>
+#include <atomic>
 #include <memory>
 #include <algorithm>
-#include <queue>
 #include <cmath>
+#include <chrono>
+#include <string>
 #ifndef NDEBUG
 #include <cassert>
 #endif
 #include <spdlog/spdlog.h>
-#include <oneapi/tbb/concurrent_map.h>
 #include <google/protobuf/util/time_util.h>
 #include "uDataPacketService/stream.hpp"
 #include "uDataPacketService/streamOptions.hpp"
+#include "uDataPacketService/statistics.hpp"
 #include "uDataPacketServiceAPI/v1/packet.pb.h"
 #include "uDataPacketServiceAPI/v1/stream_identifier.pb.h"
 
@@ -26,9 +28,9 @@ public:
                const StreamOptions &options,
                std::shared_ptr<spdlog::logger> logger) :
         mOptions(options),
-        mLogger(logger),
-        mMaximumQueueSize(mOptions.getMaximumQueueSize())
+        mLogger(logger)
     {   
+        initializeQueueBounds();
         mStreamIdentifier = Utilities::toName(packet);
         setNextPacket(std::move(packet));
     }   
@@ -37,176 +39,75 @@ public:
     StreamImpl(UDataPacketServiceAPI::V1::Packet &&packet,
                const StreamOptions &options) :
         mOptions(options),
-        mLogger(nullptr),
-        mMaximumQueueSize(mOptions.getMaximumQueueSize())
+        mLogger(nullptr)
     {   
+        initializeQueueBounds();
         mStreamIdentifier = Utilities::toName(packet);
         setNextPacket(std::move(packet));
     }   
 
-    /// Sets the next packet
-    void setNextPacket(UDataPacketServiceAPI::V1::Packet &&packet)
+    /// Unpacks the queue bounds from the options
+    void initializeQueueBounds()
     {
-        auto thisIdentifier = Utilities::toName(packet);
-        if (thisIdentifier != mStreamIdentifier)
+        mQueueCapacity.store(
+            static_cast<size_t> (mOptions.getMaximumQueueSize()),
+            std::memory_order_relaxed);
+        auto maximumQueueDuration = mOptions.getMaximumQueueDuration();
+        if (maximumQueueDuration)
         {
-            throw std::runtime_error(thisIdentifier
-                                   + " does not match stream identifier "
-                                   + mStreamIdentifier);
-        }
-        // Set the next packets
-        std::lock_guard<std::mutex> lock(mMutex);
-        mMostRecentPacket = std::move(packet);
-        mHaveMostRecentPacket = true;
-        for (auto &it : mSubscribersMap)
-        {
-            if (it.second.size() >= mMaximumQueueSize)
-            {
-                it.second.pop(); 
-            }
-            auto packetCopy = mMostRecentPacket;
-            it.second.push(packetCopy);
+            mMaximumQueueDuration = maximumQueueDuration->count()*1.e-3;
         }
     }
 
-    /// Subscriber gets next packet
-    [[nodiscard]] std::optional<UDataPacketServiceAPI::V1::Packet>
-        getNextPacket(const uintptr_t contextAddress) noexcept
-    {   
-        std::optional<UDataPacketServiceAPI::V1::Packet> result{std::nullopt};
-        auto idx = mSubscribersMap.find(contextAddress);
-        if (idx != mSubscribersMap.end())
-        {
-            if (!idx->second.empty()) 
-            {
-                result 
-                    = std::make_optional<UDataPacketServiceAPI::V1::Packet>
-                      (std::move(idx->second.front()));
-                idx->second.pop();
-            }
-        }
-        return result;
-    }   
-
-    /// Subscribe to the stream 
-    [[nodiscard]] bool subscribe(const uintptr_t contextAddress,
-                                 const bool enqueueLatestPacket)
+    /// Derives the queue's capacity in packets from the duration of the
+    /// stream's packets.  This is smoothed since packet lengths can vary.
+    void updateQueueCapacity(const UDataPacketServiceAPI::V1::Packet &packet)
     {
-        auto contextAddressString = std::to_string(contextAddress);
-        bool wasAdded{false};
-        if (!mSubscribersMap.contains(contextAddress))
+        double samplingRate = packet.sampling_rate();
+        auto nSamples = packet.number_of_samples();
+        if (samplingRate <= 0 || nSamples <= 0){return;}
+        auto duration = nSamples/samplingRate;
+        if (mPacketDuration > 0)
         {
-            std::pair
-            <
-                uintptr_t,
-                std::queue<UDataPacketServiceAPI::V1::Packet>
-            > newElement;
-            newElement.first = contextAddress;
-            if (enqueueLatestPacket && mHaveMostRecentPacket)
-            {
-                newElement.second.push(mMostRecentPacket);
-            }
-            auto [it, added] = mSubscribersMap.insert(std::move(newElement));
-            if (!added)
-            {
-                wasAdded = false;
-#ifndef NDEBUG
-                if (mLogger)
-                {
-                    SPDLOG_LOGGER_WARN(mLogger,
-                                       "Couldn't add new subscriber {} to {}",
-                                       contextAddressString,
-                                       mStreamIdentifier);
-                }
-#endif
-            }
-            else
-            {
-                wasAdded = true;
-            }
+            mPacketDuration = mPacketDuration + 0.125*(duration - mPacketDuration);
         }
-        // All done
-        if (wasAdded)
+        else
         {
-#ifndef NDEBUG
-            if (mLogger)
-            {
-                SPDLOG_LOGGER_DEBUG(mLogger, "{} subscribed to {}", 
-                                    contextAddressString, mStreamIdentifier);
-            }
-#endif
+            mPacketDuration = duration;
         }
-        return wasAdded;
+        auto capacity
+            = std::max(1.0, std::ceil(mMaximumQueueDuration/mPacketDuration));
+        mQueueCapacity.store(static_cast<size_t> (capacity),
+                             std::memory_order_relaxed);
     }
 
-    /// Unsubscribes from the stream.
-    /// @result True indicates the context was subscribed.
-    ///         False indicates the context failed to be unsubscribed.
-    [[nodiscard]]
-    Stream::UnsubscribeResponse unsubscribe(const uintptr_t contextAddress)
+    /// Sets the next packet
+    void setNextPacket(UDataPacketServiceAPI::V1::Packet &&packet)
     {
-        auto result = Stream::UnsubscribeResponse::Unsubscribed;
-        // Erase is not thread safe
-        size_t originalSize{0};
-        size_t newSize{0};
-        bool wasUnsubscribed{false};
-        {
-        std::lock_guard<std::mutex> lock(mMutex);
-        originalSize = mSubscribersMap.size();
-        size_t exists = mSubscribersMap.unsafe_erase(contextAddress);
-        newSize = mSubscribersMap.size();
-        if (exists == 1)
-        {
-            wasUnsubscribed = true;
-            result = Stream::UnsubscribeResponse::Unsubscribed;
-        }
-        else if (exists == 0)
-        {
-            result = Stream::UnsubscribeResponse::NeverSubscribed;
-        }
-        }
-        if (wasUnsubscribed)
-        {
-            if (newSize + 1 != originalSize)
-            {
-                throw std::runtime_error(
-                    "Unexpected behavior during unsubscribe");
-            }
-#ifndef NDEBUG
-            if (mLogger)
-            {
-                SPDLOG_LOGGER_DEBUG(mLogger,
-                                    "{} unsubscribed from {}",
-                                     contextAddressString, mStreamIdentifier);
-            }
-#endif
-        }
-        else
+        auto thisIdentifier = Utilities::toName(packet);
+        if (thisIdentifier != mStreamIdentifier)
         {
-            if (newSize != originalSize)
-            {   
-                throw std::runtime_error(
-                   "Unexpected resize during unsubscribe");
-            }   
-#ifndef NDEBUG
-            if (mLogger)
-            {
-                SPDLOG_LOGGER_DEBUG(mLogger,
-                                    "{} never subscribed to {}",
-                                     contextAddressString, mStreamIdentifier);
-            }
-#endif
+            throw std::runtime_error(thisIdentifier
+                                   + " does not match stream identifier "
+                                   + mStreamIdentifier);
         }
-        return result;
+        setNextPacket(std::make_shared<const UDataPacketServiceAPI::V1::Packet>
+                      (std::move(packet)));
     }
 
-    /// Forcefully purge all subscribers
-    void unsubscribeAll()
+    /// Sets the next packet.  This only swaps the most recent packet.
+    void setNextPacket(
+        std::shared_ptr<const UDataPacketServiceAPI::V1::Packet> &&packet)
     {
+        auto nBytes = static_cast<int64_t> (packet->ByteSizeLong());
+        if (mMaximumQueueDuration > 0){updateQueueCapacity(*packet);}
         {
-        std::lock_guard<std::mutex> lock(mMutex);        
-        mSubscribersMap.clear();
+        std::lock_guard<std::mutex> lock(mMostRecentPacketMutex);
+        mMostRecentPacket.swap(packet);
         }
+        // The previous packet is now in packet so it is freed outside of
+        // the lock
+        mReceived.add(nBytes, Utilities::getNow<std::chrono::nanoseconds> ());
     }
 
     /// Sets the next packet
@@ -216,48 +117,44 @@ public:
         setNextPacket(std::move(copy));
     }   
 
-    /// The number of subscribers.
-    int getNumberOfSubscribers() const noexcept
-    {   
-        return mSubscribersMap.size();
-    }   
+    /// The most recent packet
+    [[nodiscard]] std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>
+        getMostRecentPacket() const
+    {
+        std::lock_guard<std::mutex> lock(mMostRecentPacketMutex);
+        return mMostRecentPacket;
+    }
 
-    /// The current subscribers.
-    std::set<uintptr_t> getSubscribers() const noexcept
-    {   
-        std::vector<uintptr_t> keys;
-        keys.reserve(mSubscribersMap.size());
-        for (const auto &item : mSubscribersMap)
-        {   
-            keys.push_back(item.first);
-        }   
-        // Convert to a set
-        std::set<uintptr_t> result;
-        for (const auto &key : keys)
-        {
-            result.insert(key);
-        }   
+    /// Snapshot of the statistics
+    [[nodiscard]] StreamStatistics getStatistics() const
+    {
+        StreamStatistics result;
+        auto now = Utilities::getNow<std::chrono::nanoseconds> ();
+        result.identifier = mStreamIdentifier;
+        result.lastPacketTime = mReceived.getLastTime();
+        result.packetsPerSecond = mReceived.getPacketsPerSecond(now);
+        result.bytesPerSecond = mReceived.getBytesPerSecond(now);
+        result.packetsReceived = mReceived.getPackets();
+        result.bytesReceived = mReceived.getBytes();
         return result;
     }
-    /// @result True indicates this subscriber is subscribed.
-    [[nodiscard]] bool isSubscribed(const uintptr_t contextAddress) const noexcept
-    {   
-        return mSubscribersMap.contains(contextAddress);
-    }   
 
 //private:
-    mutable std::mutex mMutex;
+    // Protects the most recent packet
+    mutable std::mutex mMostRecentPacketMutex;
     StreamOptions mOptions;
     std::shared_ptr<spdlog::logger> mLogger{nullptr};
-    oneapi::tbb::concurrent_map
-    <
-        uintptr_t,
-        std::queue<UDataPacketServiceAPI::V1::Packet>
-    > mSubscribersMap;
-    UDataPacketServiceAPI::V1::Packet mMostRecentPacket;
+    // Only the publisher updates this
+    ThroughputCounter mReceived;
+    std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>
+        mMostRecentPacket{nullptr};
     std::string mStreamIdentifier;
-    size_t mMaximumQueueSize{8};
-    bool mHaveMostRecentPacket{false};
+    // The number of packets a subscriber may fall behind by.  With a time
+    // bound the publisher derives this from the packet duration.
+    std::atomic<size_t> mQueueCapacity{128};
+    // Only the publisher touches these.  They are in seconds.
+    double mMaximumQueueDuration{0};
+    double mPacketDuration{0};
 };
 
 Stream::Stream(UDataPacketServiceAPI::V1::Packet &&packet,
@@ -283,36 +180,36 @@ void Stream::setNextPacket(const UDataPacketServiceAPI::V1::Packet &packet)
     pImpl->setNextPacket(packet);
 }
 
-std::optional<UDataPacketServiceAPI::V1::Packet>
-    Stream::getNextPacket(const uintptr_t contextAddress) noexcept
+void Stream::setNextPacket(
+    std::shared_ptr<const UDataPacketServiceAPI::V1::Packet> packet)
 {
-    return pImpl->getNextPacket(contextAddress);
+    if (packet == nullptr){throw std::invalid_argument("Packet is null");}
+#ifndef NDEBUG
+    assert(Utilities::toName(*packet) == pImpl->mStreamIdentifier);
+#endif
+    pImpl->setNextPacket(std::move(packet));
 }
 
-bool Stream::subscribe(const uintptr_t contextAddress,
-                       const bool enqueueLatestPacket)
+std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>
+    Stream::getMostRecentPacket() const
 {
-    return pImpl->subscribe(contextAddress, enqueueLatestPacket);
+    return pImpl->getMostRecentPacket();
 }
 
-Stream::UnsubscribeResponse Stream::unsubscribe(const uintptr_t contextAddress)
+StreamStatistics Stream::getStatistics() const
 {
-    return pImpl->unsubscribe(contextAddress);
+    return pImpl->getStatistics();
 }
 
-int Stream::getNumberOfSubscribers() const noexcept
+std::chrono::nanoseconds Stream::getLastPacketTime() const noexcept
 {
-    return pImpl->getNumberOfSubscribers();
+    return pImpl->mReceived.getLastTime();
 }
 
-std::set<uintptr_t> Stream::getSubscribers() const noexcept
-{
-    return pImpl->getSubscribers();
-}
- 
-bool Stream::isSubscribed(const uintptr_t contextAddress) const noexcept
+int Stream::getMaximumQueueSize() const noexcept
 {
-    return pImpl->isSubscribed(contextAddress);
+    return static_cast<int>
+           (pImpl->mQueueCapacity.load(std::memory_order_relaxed));
 }
 
 std::string Stream::getIdentifier() const noexcept
@@ -320,10 +217,5 @@ std::string Stream::getIdentifier() const noexcept
     return pImpl->mStreamIdentifier;
 }
 
-void Stream::unsubscribeAll()
-{
-    pImpl->unsubscribeAll();
-}
-
 /// Destructor
 Stream::~Stream() = default;
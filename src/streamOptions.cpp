@@ -1,3 +1,4 @@
+#include <stdexcept>
 #include "uDataPacketService/streamOptions.hpp"
 
 using namespace UDataPacketService;
@@ -7,7 +8,11 @@ using namespace UDataPacketService;
 class StreamOptions::StreamOptionsImpl
 {
 public:
+    std::chrono::milliseconds mMaximumQueueDuration{0};
+    int64_t mMaximumQueueBytes{0};
     int mMaximumQueueSize{DEFAULT_QUEUE_SIZE};
+    bool mHaveMaximumQueueDuration{false};
+    bool mHaveMaximumQueueBytes{false};
 };
 
 /// Constructor
@@ -60,5 +65,42 @@ void StreamOptions::setMaximumQueueSize(const int queueSize)
 int StreamOptions::getMaximumQueueSize() const noexcept
 {
     return pImpl->mMaximumQueueSize;
-}   
+}
+
+/// Queue duration
+void StreamOptions::setMaximumQueueDuration(
+    const std::chrono::milliseconds &duration)
+{
+    if (duration.count() <= 0)
+    {
+        throw std::invalid_argument("Queue duration must be positive");
+    }
+    pImpl->mMaximumQueueDuration = duration;
+    pImpl->mHaveMaximumQueueDuration = true;
+}
+
+std::optional<std::chrono::milliseconds>
+    StreamOptions::getMaximumQueueDuration() const noexcept
+{
+    return pImpl->mHaveMaximumQueueDuration ?
+           std::make_optional<std::chrono::milliseconds>
+           (pImpl->mMaximumQueueDuration) : std::nullopt;
+}
+
+/// Queue bytes
+void StreamOptions::setMaximumQueueBytes(const int64_t maximumBytes)
+{
+    if (maximumBytes <= 0)
+    {
+        throw std::invalid_argument("Queue bytes must be positive");
+    }
+    pImpl->mMaximumQueueBytes = maximumBytes;
+    pImpl->mHaveMaximumQueueBytes = true;
+}
 
+std::optional<int64_t> StreamOptions::getMaximumQueueBytes() const noexcept
+{
+    return pImpl->mHaveMaximumQueueBytes ?
+           std::make_optional<int64_t> (pImpl->mMaximumQueueBytes) :
+           std::nullopt;
+}
@@ -1,5 +1,9 @@
 #include <mutex>
 #include <atomic>
+#include <string>
+#include <vector>
+#include <future>
+#include <exception>
 #include <condition_variable>
 #ifndef NDEBUG
 #include <cassert>
@@ -39,11 +43,39 @@ public:
     grpc::string mToken;
 };
 
+grpc::ChannelArguments
+    makeChannelArguments(const UDataPacketService::GRPCClientOptions &options)
+{
+    grpc::ChannelArguments arguments;
+    arguments.SetMaxReceiveMessageSize(options.getMaximumReceiveMessageSize());
+    auto keepAliveTime = options.getKeepAliveTime();
+    if (keepAliveTime)
+    {
+        arguments.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS,
+                         static_cast<int> (keepAliveTime->count()));
+        arguments.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS,
+                         static_cast<int> (options.getKeepAliveTimeout().count()));
+    }
+    auto windowSize = options.getHTTP2InitialWindowSize();
+    if (windowSize)
+    {
+        arguments.SetInt(GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES, *windowSize);
+    }
+    arguments.SetInt(GRPC_ARG_HTTP2_BDP_PROBE,
+                     options.isBDPProbeEnabled() ? 1 : 0);
+    if (options.useDedicatedConnection())
+    {
+        arguments.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    }
+    return arguments;
+}
+
 std::shared_ptr<grpc::Channel>
     createChannel(const UDataPacketService::GRPCClientOptions &options,
                   spdlog::logger *logger)
 {
     auto address = UDataPacketService::makeAddress(options);
+    auto arguments = ::makeChannelArguments(options);
     auto serverCertificate = options.getServerCertificate();
     if (serverCertificate)
     {
@@ -68,20 +100,24 @@ std::shared_ptr<grpc::Channel>
                 = grpc::CompositeChannelCredentials(
                       grpc::SslCredentials(sslOptions),
                       callCredentials);
-            return grpc::CreateChannel(address, channelCredentials);
+            return grpc::CreateCustomChannel(address, channelCredentials,
+                                             arguments);
         }
         SPDLOG_LOGGER_INFO(logger,
                            "Creating secure channel without API key to {}",
                            address);
         grpc::SslCredentialsOptions sslOptions;
         sslOptions.pem_root_certs = *serverCertificate;
-        return grpc::CreateChannel(address,
-                                   grpc::SslCredentials(sslOptions));
+        return grpc::CreateCustomChannel(address,
+                                         grpc::SslCredentials(sslOptions),
+                                         arguments);
      }
      SPDLOG_LOGGER_INFO(logger,
                         "Creating non-secure channel to {}",
                          address);
-     return grpc::CreateChannel(address, grpc::InsecureChannelCredentials());
+     return grpc::CreateCustomChannel(address,
+                                      grpc::InsecureChannelCredentials(),
+                                      arguments);
 }
 
 class AsyncPacketSubscriber :
@@ -93,11 +129,13 @@ public:
         UDataPacketImportAPI::V1::Backend::Stub *stub,
         const UDataPacketImportAPI::V1::SubscriptionRequest &request,
         std::function<void (UDataPacketImportAPI::V1::Packet &&)> &addPacketCallback,
+        std::function<bool ()> &isSaturated,
         std::shared_ptr<spdlog::logger> logger,
         std::atomic<bool> *keepRunning
     ) :
         mRequest(request),
         mAddPacketCallback(addPacketCallback),
+        mIsSaturated(isSaturated),
         mLogger(logger),
         mKeepRunning(keepRunning)
     {
@@ -133,6 +171,13 @@ public:
                     mClientContext.TryCancel();
                 }
             }
+            else if (mIsSaturated && mIsSaturated())
+            {
+                // Leave the next packet with the proxy.  await() resumes
+                // reading once the consumer drains.
+                SPDLOG_LOGGER_DEBUG(mLogger, "Holding reads");
+                mReadHeld.store(true);
+            }
             else
             {
                 StartRead(&mPacket);
@@ -174,10 +219,21 @@ public:
                     mClientContext.TryCancel();
                 }
             }
+            else if (mReadHeld.load() && !mIsSaturated())
+            {
+                SPDLOG_LOGGER_DEBUG(mLogger, "Resuming reads");
+                mReadHeld.store(false);
+                StartRead(&mPacket);
+            }
+            // Check back quickly on held reads so the proxy isn't stalled
+            // longer than necessary
+            constexpr std::chrono::milliseconds heldTimeOut{1};
             constexpr std::chrono::milliseconds timeOut{250};
             std::unique_lock<std::mutex> lock(mMutex);
             //mConditionVariable.wait(lock, [this] {return mDone;});
-            mConditionVariable.wait_for(lock, timeOut,
+            mConditionVariable.wait_for(lock,
+                                        mReadHeld.load() ?
+                                        heldTimeOut : timeOut,
                                         [this]
                                         {
                                             return mDone;
@@ -207,6 +263,7 @@ private:
     <
         void (UDataPacketImportAPI::V1::Packet &&packet)
     > mAddPacketCallback;
+    std::function<bool ()> mIsSaturated;
     std::shared_ptr<spdlog::logger> mLogger;
     std::mutex mMutex;
     std::condition_variable mConditionVariable;
@@ -215,6 +272,9 @@ private:
     bool mDone{false};
     std::atomic<bool> *mKeepRunning{nullptr};
     std::atomic<bool> mTryCancel{false};
+    // True when a read was withheld because the consumer was saturated.
+    // Only OnReadDone sets this and only await clears it.
+    std::atomic<bool> mReadHeld{false};
     bool mHadSuccessfulRead{false}; 
 };
 
@@ -225,11 +285,23 @@ class Subscriber::SubscriberImpl
 public:
     SubscriberImpl(const SubscriberOptions &options,
                    const std::function<void (UDataPacketImportAPI::V1::Packet &&)> &callback,
+                   const std::function<bool ()> &isSaturated,
                    std::shared_ptr<spdlog::logger> logger) :
         mOptions(options),
         mAddPacketCallback(callback),
+        mIsSaturated(isSaturated),
         mLogger(logger)
     {
+        // A proxy sends its whole feed to every subscription so a second
+        // stream to the same proxy only duplicates it
+        auto nProxies
+            = static_cast<int> (mOptions.getReplicaGRPCOptions().size()) + 1;
+        if (mOptions.getNumberOfStreams() > nProxies)
+        {
+            SPDLOG_LOGGER_WARN(mLogger,
+                               "{} import streams but only {} proxies; the extra streams duplicate a proxy's feed",
+                               mOptions.getNumberOfStreams(), nProxies);
+        }
     }
                    
     ~SubscriberImpl()
@@ -246,14 +318,49 @@ public:
     {
         mShutdownRequested = false;
         mKeepRunning.store(true);
-        auto result = std::async(&SubscriberImpl::acquirePackets, this);
+        auto result = std::async(&SubscriberImpl::acquireAllPackets, this);
         return result;
     }
-    void acquirePackets()
+    /// Runs each import stream on its own thread
+    void acquireAllPackets()
+    {
+        auto nStreams = mOptions.getNumberOfStreams();
+        if (nStreams == 1)
+        {
+            acquirePackets(0);
+            return;
+        }
+        std::vector<std::future<void>> futures;
+        for (int stream = 0; stream < nStreams; ++stream)
+        {
+            futures.push_back(std::async(std::launch::async,
+                                         &SubscriberImpl::acquirePackets,
+                                         this, stream));
+        }
+        std::exception_ptr firstError{nullptr};
+        for (auto &future : futures)
+        {
+            try
+            {
+                future.get();
+            }
+            catch (...)
+            {
+                if (!firstError){firstError = std::current_exception();}
+            }
+        }
+        if (firstError){std::rethrow_exception(firstError);}
+    }
+    void acquirePackets(const int stream)
     {
 #ifndef NDEBUG
         assert(mLogger != nullptr);
 #endif
+        // The channel outlives the RPCs and reconnects on its own so a
+        // retry doesn't pay for a new channel and TLS handshake
+        auto channel
+            = ::createChannel(mOptions.getGRPCOptions(stream), mLogger.get());
+        auto stub = UDataPacketImportAPI::V1::Backend::NewStub(channel);
         auto reconnectSchedule = mOptions.getReconnectSchedule();
         auto nReconnect = static_cast<int> (reconnectSchedule.size());
         for (int kReconnect =-1; kReconnect < nReconnect; ++kReconnect)
@@ -274,10 +381,6 @@ public:
                 lock.unlock();
                 if (!mKeepRunning.load()){break;}
             }
-            // Create channel
-            auto channel
-                = ::createChannel(mOptions.getGRPCOptions(), mLogger.get());
-            auto stub = UDataPacketImportAPI::V1::Backend::NewStub(channel);
             UDataPacketImportAPI::V1::SubscriptionRequest request;
             auto subscriberIdentifier = mOptions.getIdentifier();
             if (subscriberIdentifier)
@@ -287,6 +390,7 @@ public:
             AsyncPacketSubscriber subscriber{stub.get(),
                                              request,
                                              mAddPacketCallback,
+                                             mIsSaturated,
                                              mLogger,
                                              &mKeepRunning};
             auto [status, hadSuccessfulRead] = subscriber.await();
@@ -334,10 +438,10 @@ public:
         if (mKeepRunning.load())
         {
             SPDLOG_LOGGER_CRITICAL(mLogger,
-                                   "Subscriber thread quitting!");
+                                   "Subscriber thread {} quitting!", stream);
             throw std::runtime_error("Premature end of subscriber thread");
         }
-        SPDLOG_LOGGER_INFO(mLogger, "Subscriber thread exiting");
+        SPDLOG_LOGGER_INFO(mLogger, "Subscriber thread {} exiting", stream);
     }
 //private:
     SubscriberOptions mOptions;
@@ -345,6 +449,7 @@ public:
     <   
         void (UDataPacketImportAPI::V1::Packet &&packet)
     > mAddPacketCallback;
+    std::function<bool ()> mIsSaturated;
     std::shared_ptr<spdlog::logger> mLogger{nullptr};
     mutable std::mutex mShutdownMutex;
     std::condition_variable mShutdownCondition;
@@ -360,7 +465,22 @@ Subscriber::Subscriber
     const std::function<void (UDataPacketImportAPI::V1::Packet &&)> &callback,
     std::shared_ptr<spdlog::logger> logger
 ) :
-    pImpl(std::make_unique<SubscriberImpl> (options, callback, logger))
+    pImpl(std::make_unique<SubscriberImpl> (options, callback,
+                                            std::function<bool ()> {},
+                                            logger))
+{
+}
+
+/// Constructor with flow control
+Subscriber::Subscriber
+(
+    const SubscriberOptions &options,
+    const std::function<void (UDataPacketImportAPI::V1::Packet &&)> &callback,
+    const std::function<bool ()> &isSaturated,
+    std::shared_ptr<spdlog::logger> logger
+) :
+    pImpl(std::make_unique<SubscriberImpl> (options, callback, isSaturated,
+                                            logger))
 {
 }
 
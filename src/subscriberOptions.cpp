@@ -1,3 +1,4 @@
+#include <string>
 #include <vector>
 #include <algorithm>
 #include <chrono>
@@ -10,6 +11,7 @@ class SubscriberOptions::SubscriberOptionsImpl
 {
 public:
     GRPCClientOptions mGRPCOptions;
+    std::vector<GRPCClientOptions> mReplicaGRPCOptions;
     std::vector<std::chrono::milliseconds> mReconnectSchedule
     {
         std::chrono::seconds {0},
@@ -17,6 +19,7 @@ public:
         std::chrono::seconds {15}
     };
     std::string mIdentifier;
+    int mNumberOfStreams{1};
 };
 
 /// Constructor
@@ -66,6 +69,49 @@ GRPCClientOptions SubscriberOptions::getGRPCOptions() const
     return pImpl->mGRPCOptions;
 }
 
+/// Replicas
+void SubscriberOptions::setReplicaGRPCOptions(
+    const std::vector<GRPCClientOptions> &options)
+{
+    pImpl->mReplicaGRPCOptions = options;
+}
+
+std::vector<GRPCClientOptions> SubscriberOptions::getReplicaGRPCOptions() const
+{
+    return pImpl->mReplicaGRPCOptions;
+}
+
+GRPCClientOptions SubscriberOptions::getGRPCOptions(const int stream) const
+{
+    if (stream < 0 || stream >= getNumberOfStreams())
+    {
+        throw std::invalid_argument("Stream " + std::to_string(stream)
+                                  + " must be in range [0,"
+                                  + std::to_string(getNumberOfStreams())
+                                  + ")");
+    }
+    auto nEndpoints
+        = static_cast<int> (pImpl->mReplicaGRPCOptions.size()) + 1;
+    auto endpoint = stream%nEndpoints;
+    if (endpoint == 0){return pImpl->mGRPCOptions;}
+    return pImpl->mReplicaGRPCOptions.at(endpoint - 1);
+}
+
+/// Number of streams
+void SubscriberOptions::setNumberOfStreams(const int nStreams)
+{
+    if (nStreams < 1)
+    {
+        throw std::invalid_argument("Number of streams must be positive");
+    }
+    pImpl->mNumberOfStreams = nStreams;
+}
+
+int SubscriberOptions::getNumberOfStreams() const noexcept
+{
+    return pImpl->mNumberOfStreams;
+}
+
 /// Reconnect schedule
 void SubscriberOptions::setReconnectSchedule(
     const std::vector<std::chrono::milliseconds> &schedule)
@@ -1,24 +1,213 @@
 #include <mutex>
+#include <shared_mutex>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <optional>
+#include <atomic>
+#include <limits>
 #include <string>
 #include <set>
+#include <map>
+#include <unordered_map>
+#include <queue>
+#include <functional>
 #include <algorithm>
 #ifndef NDEBUG
 #include <cassert>
 #endif
 #include <spdlog/spdlog.h>
 #include <oneapi/tbb/concurrent_map.h>
-#include <oneapi/tbb/concurrent_set.h>
 #include <grpcpp/server.h>
 #include "uDataPacketService/subscriptionManager.hpp"
 #include "uDataPacketService/subscriptionManagerOptions.hpp"
+#include "uDataPacketService/broadcastLog.hpp"
+#include "uDataPacketService/subscriberHandle.hpp"
+#include "uDataPacketService/statistics.hpp"
 #include "uDataPacketService/stream.hpp"
 #include "uDataPacketService/streamOptions.hpp"
 #include "uDataPacketServiceAPI/v1/packet.pb.h"
 
 import Utilities;
+import Metrics;
+import MemoryBudget;
 
 using namespace UDataPacketService;
 
+namespace
+{
+
+/// Subscribers with identical selections share a group.  The publisher
+/// writes each packet once to every group that selected its stream and
+/// the group's members read the group's log through their own cursors.
+/// The fan-out work therefore scales with the number of distinct
+/// selections rather than the number of subscribers.  The group's
+/// bookkeeping is charged to the memory budget for as long as it exists;
+/// its log charges its own ring.
+struct SubscriptionGroup
+{
+    SubscriptionGroup(std::string keyIn,
+                      std::set<std::string> &&streamIdentifiersIn,
+                      const bool allIn,
+                      const int capacity) :
+        key(std::move(keyIn)),
+        streamIdentifiers(std::move(streamIdentifiersIn)),
+        log(capacity),
+        all(allIn)
+    {
+        // A set node holds the string and roughly four pointers
+        nBytes = static_cast<int64_t> (sizeof(SubscriptionGroup)
+                                     + key.capacity());
+        for (const auto &streamIdentifier : streamIdentifiers)
+        {
+            nBytes = nBytes
+                   + static_cast<int64_t> (sizeof(std::string)
+                                         + 4*sizeof(void *)
+                                         + streamIdentifier.capacity());
+        }
+        MemoryBudget::getInstance().charge(nBytes);
+    }
+    ~SubscriptionGroup()
+    {
+        MemoryBudget::getInstance().release(nBytes);
+    }
+    SubscriptionGroup(const SubscriptionGroup &) = delete;
+    SubscriptionGroup& operator=(const SubscriptionGroup &) = delete;
+    /// The canonical selection.
+    std::string key;
+    /// The selected streams.  This is empty for the group that selects
+    /// all streams.
+    std::set<std::string> streamIdentifiers;
+    /// The packets from the selected streams.
+    BroadcastLog log;
+    /// The number of subscribers in the group.
+    std::atomic<int> nMembers{0};
+    /// True indicates the group selects all streams.
+    bool all{false};
+    /// The bytes charged to the memory budget.
+    int64_t nBytes{0};
+};
+
+/// Where a group member is in the group's log.
+struct BroadcastCursor
+{
+    explicit BroadcastCursor(const uint64_t sequenceIn) :
+        sequence(sequenceIn)
+    {
+    }
+    /// Serializes reads so the cursor only moves forward.
+    std::mutex mutex;
+    /// The sequence number of the next packet to read.
+    std::atomic<uint64_t> sequence{0};
+    /// Packets overwritten before they could be read.
+    std::atomic<int64_t> packetsDropped{0};
+};
+
+/// The subscription manager's view of a subscriber.
+struct SubscriberSlot
+{
+    /// The group to which the subscriber belongs.
+    std::shared_ptr<SubscriptionGroup> group{nullptr};
+    /// The subscriber's position in the group's log.
+    std::shared_ptr<BroadcastCursor> cursor{nullptr};
+    /// The subscriber's live counters.
+    std::shared_ptr<SubscriberCounters> counters{nullptr};
+    /// The slot's generation.  This advances each time the slot is freed.
+    uint32_t generation{1};
+    /// True indicates the slot has been issued.
+    bool inUse{false};
+    /// True indicates the subscriber is in the subscriber count.
+    bool counted{false};
+};
+
+/// A subscriber as seen by the readers and the statistics.
+struct RegistryEntry
+{
+    std::shared_ptr<SubscriberCounters> counters{nullptr};
+    std::shared_ptr<SubscriptionGroup> group{nullptr};
+    std::shared_ptr<BroadcastCursor> cursor{nullptr};
+    /// The slot's generation when this was published.
+    uint32_t generation{0};
+};
+
+/// An immutable copy of the subscriber slab indexed by the handles' slots.
+/// Unused slots have no counters.  This is republished whenever a
+/// subscriber comes, goes, or changes groups so polling, shedding, and the
+/// statistics never take the subscription manager's lock.
+using SubscriberRegistry = std::vector<RegistryEntry>;
+
+/// Finds the handle's entry in the registry.
+/// @result A pointer to the entry or nullptr if the handle is stale.
+[[nodiscard]] const RegistryEntry *findEntry(
+    const SubscriberRegistry &registry, const SubscriberHandle &handle)
+{
+    auto slotIndex = handle.getSlot();
+    if (slotIndex >= registry.size()){return nullptr;}
+    const auto &entry = registry[slotIndex];
+    if (!entry.counters || entry.generation != handle.getGeneration())
+    {
+        return nullptr;
+    }
+    return &entry;
+}
+
+/// An immutable index from a stream to the groups that selected it.  This
+/// is republished whenever a group is created or retired so the publisher
+/// never takes the subscription manager's lock.
+using GroupIndex
+    = std::unordered_map<std::string,
+                         std::vector<std::shared_ptr<SubscriptionGroup>>>;
+
+/// A stream waiting in the eviction queue.  The time is that of the
+/// stream's last packet when the entry was made so it may be stale.
+struct EvictionCandidate
+{
+    [[nodiscard]] bool operator>(const EvictionCandidate &rhs) const noexcept
+    {
+        return lastPacketTime > rhs.lastPacketTime;
+    }
+    std::chrono::nanoseconds lastPacketTime{0};
+    std::string streamIdentifier;
+};
+
+/// Shares the packet between the logs and the stream.  The packet is
+/// charged to the memory budget until the last of them lets go of it.
+[[nodiscard]] std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>
+    makeChargedPacket(UDataPacketServiceAPI::V1::Packet &&packet,
+                      MemoryBudget &memoryBudget)
+{
+    auto nBytes = static_cast<int64_t> (packet.ByteSizeLong());
+    memoryBudget.charge(nBytes);
+    return std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>
+           (new UDataPacketServiceAPI::V1::Packet(std::move(packet)),
+            [&memoryBudget, nBytes](const UDataPacketServiceAPI::V1::Packet *p)
+            {
+                memoryBudget.release(nBytes);
+                delete p;
+            });
+}
+
+[[nodiscard]] std::string toString(const SubscriberHandle &handle)
+{
+    return std::to_string(handle.getSlot()) + "."
+         + std::to_string(handle.getGeneration());
+}
+
+/// Canonicalizes a selection.  The set is sorted so equivalent selections
+/// produce the same key.
+[[nodiscard]] std::string toKey(const std::set<std::string> &streamIdentifiers)
+{
+    std::string result;
+    for (const auto &streamIdentifier : streamIdentifiers)
+    {
+        if (!result.empty()){result.push_back(' ');}
+        result.append(streamIdentifier);
+    }
+    return result;
+}
+
+}
+
 class SubscriptionManager::SubscriptionManagerImpl
 {
 public:
@@ -26,35 +215,102 @@ public:
                             std::shared_ptr<spdlog::logger> logger) :
         mOptions(options),
         mLogger(logger),
-        mStreamOptions(mOptions.getStreamOptions())
+        mStreamOptions(mOptions.getStreamOptions()),
+        mMaximumQueueBytes(mStreamOptions.getMaximumQueueBytes()),
+        mIdleStreamTimeout(mOptions.getIdleStreamTimeout()),
+        mEvictionCheckInterval(std::min<std::chrono::nanoseconds>
+                               (mIdleStreamTimeout, std::chrono::seconds {60})),
+        mMaximumNumberOfStreams(
+            static_cast<size_t> (mOptions.getMaximumNumberOfStreams())),
+        mSheddingPolicy(mOptions.getSheddingPolicy())
     {
+        // Until streams arrive the ring holds one default queue
+        mAllGroup
+            = std::make_shared<SubscriptionGroup>
+              ("*", std::set<std::string> {}, true, getAllRetention());
+        updateRetention(*mAllGroup);
     }
- 
-    /// Add packet (and, if it is a new stream, update subscribers)
-    void enqueuePacket(UDataPacketServiceAPI::V1::Packet &&packet)
+
+    /// Add packet (and, if it is a new stream, create it).  The packet is
+    /// moved into a single shared copy which is handed to the interested
+    /// groups' logs and the stream.  A stream nobody selected only swaps
+    /// its most recent packet.
+    void enqueuePacket(UDataPacketServiceAPI::V1::Packet &&packetIn)
     {
-        auto streamIdentifier = Utilities::toName(packet);
+        checkIdleStreams();
+        auto streamIdentifier = Utilities::toName(packetIn);
+        auto packet = ::makeChargedPacket(std::move(packetIn), mMemoryBudget);
+        // Fan out to the groups
+        {
+        auto groupIndex = mGroupIndex.load(std::memory_order_acquire);
+        if (mAllGroup->nMembers.load(std::memory_order_acquire) > 0)
+        {
+            mAllGroup->log.append(packet);
+        }
+        if (!groupIndex->empty())
+        {
+            auto gdx = groupIndex->find(streamIdentifier);
+            if (gdx != groupIndex->end())
+            {
+                for (const auto &group : gdx->second)
+                {
+                    group->log.append(packet);
+                }
+            }
+        }
+        }
+        if (mMemoryBudget.isExceeded()){shedMemory();}
+        // Update the stream
+        bool exists{false};
+        int64_t queueCapacityChange{0};
+        {
+        std::shared_lock<std::shared_mutex> lock(mStreamsMutex);
         auto idx = mStreamsMap.find(streamIdentifier);
         if (idx != mStreamsMap.end())
         {
+            exists = true;
             try
             {
-                idx->second->setNextPacket(std::move(packet));
+                auto &stream = *idx->second;
+                auto queueCapacity = stream.getMaximumQueueSize();
+                stream.setNextPacket(std::move(packet));
+                queueCapacityChange
+                    = static_cast<int64_t> (stream.getMaximumQueueSize())
+                    - queueCapacity;
             }
             catch (const std::exception &e)
             {
                 throw std::runtime_error(
-                    "Subscription manager failed to enqueue " 
+                    "Subscription manager failed to enqueue "
                   + streamIdentifier + " because " + std::string {e.what()});
             }
+        }
+        }
+        if (exists)
+        {
+            // The groups that selected this stream get more or less room
+            if (queueCapacityChange != 0)
+            {
+                mTotalQueueCapacity.fetch_add(queueCapacityChange,
+                                              std::memory_order_relaxed);
+                updateRetention(streamIdentifier);
+                updateRetention(*mAllGroup);
+            }
             return;
         }
+        // Make room for the new stream
+        if (getNumberOfStreams() >= mMaximumNumberOfStreams)
+        {
+            evictStalestStream();
+        }
         // Do it the hard way
-        std::unique_ptr<Stream> stream{nullptr};
+        std::shared_ptr<Stream> stream{nullptr};
         try
         {
+            auto firstPacket = *packet;
             stream
-                = std::make_unique<Stream> (std::move(packet), mStreamOptions);
+                = std::make_shared<Stream> (std::move(firstPacket),
+                                            mStreamOptions);
         }
         catch (const std::exception &e)
         {
@@ -65,426 +321,784 @@ public:
         assert(stream != nullptr);
 #endif
         SPDLOG_LOGGER_DEBUG(mLogger, "Adding {}", streamIdentifier);
+        auto lastPacketTime = stream->getLastPacketTime();
+        auto queueCapacity
+            = static_cast<int64_t> (stream->getMaximumQueueSize());
         std::pair
         <
             std::string,
-            std::unique_ptr<Stream>
+            std::shared_ptr<Stream>
         > newStream{streamIdentifier, std::move(stream)};
-        auto [jdx, inserted] = mStreamsMap.insert(std::move(newStream));
-        if (inserted)
+        bool inserted{false};
+        {
+        std::shared_lock<std::shared_mutex> lock(mStreamsMutex);
+        inserted = mStreamsMap.insert(std::move(newStream)).second;
+        }
+        if (!inserted)
+        {
+            throw std::runtime_error("Failed to insert " + streamIdentifier
+                                   + " into streams map");
+        }
+        mTotalQueueCapacity.fetch_add(queueCapacity,
+                                      std::memory_order_relaxed);
+        mMetrics.updateNumberOfStreams(
+            static_cast<int64_t> (getNumberOfStreams()));
+        {
+        std::lock_guard<std::mutex> evictionLock(mEvictionMutex);
+        pushEvictionCandidate(streamIdentifier, lastPacketTime);
+        }
+        updateRetention(streamIdentifier);
+        updateRetention(*mAllGroup);
+    }
+
+    /// Bounds the logs of the groups that selected the stream by their
+    /// streams' current queue capacities.
+    void updateRetention(const std::string &streamIdentifier) const
+    {
+        auto groupIndex = mGroupIndex.load(std::memory_order_acquire);
+        auto gdx = groupIndex->find(streamIdentifier);
+        if (gdx == groupIndex->end()){return;}
+        for (const auto &group : gdx->second){updateRetention(*group);}
+    }
+
+    /// Bounds the group's log by the queues of the streams it selected.  A
+    /// group is given as many packets as the streams' queues would have
+    /// held, up to the broadcast log capacity, and as many bytes as the
+    /// streams' byte bounds.  The group that selects all streams is sized
+    /// the same way from every live stream.
+    /// @note The caller must not hold mStreamsMutex.
+    void updateRetention(SubscriptionGroup &group) const
+    {
+        int64_t nStreams{0};
+        if (group.all)
         {
-            auto streamIdentifier = jdx->second->getIdentifier();
-            // Whoever was subscribed to all is not subscribed to this stream
-            for (const auto &pendingSubscription : mPendingSubscribeToAllRequests)
+            nStreams = static_cast<int64_t> (getNumberOfStreams());
+            group.log.setMaximumNumberOfPackets(getAllRetention());
+        }
+        else
+        {
+            nStreams = static_cast<int64_t> (group.streamIdentifiers.size());
+            group.log.setMaximumNumberOfPackets(
+                getRetention(group.streamIdentifiers));
+        }
+        if (mMaximumQueueBytes)
+        {
+            group.log.setMaximumBytes(std::max<int64_t> (1, nStreams)
+                                     *(*mMaximumQueueBytes));
+        }
+    }
+
+    /// The number of packets a group selecting these streams retains
+    [[nodiscard]] int getRetention(
+        const std::set<std::string> &streamIdentifiers) const
+    {
+        auto retention
+            = std::min<int64_t> (mOptions.getBroadcastLogCapacity(),
+                                 getQueueCapacity(streamIdentifiers));
+        return static_cast<int> (std::max<int64_t> (1, retention));
+    }
+
+    /// The number of packets the group that selects all streams retains,
+    /// i.e., the combined capacity of the live streams' queues.  With no
+    /// streams this is one default queue.
+    [[nodiscard]] int getAllRetention() const
+    {
+        auto retention = mTotalQueueCapacity.load(std::memory_order_relaxed);
+        if (retention <= 0)
+        {
+            retention = mStreamOptions.getMaximumQueueSize();
+        }
+        retention = std::min<int64_t> (mOptions.getBroadcastLogCapacity(),
+                                       retention);
+        return static_cast<int> (std::max<int64_t> (1, retention));
+    }
+
+    /// The combined capacity of the selected streams' queues.  A stream
+    /// bounded by duration has a capacity derived from its packets' durations
+    /// so a group of busy streams gets more room than a group of slow ones.
+    /// Streams that have yet to arrive get the default queue size.
+    [[nodiscard]] int64_t getQueueCapacity(
+        const std::set<std::string> &streamIdentifiers) const
+    {
+        int64_t capacity{0};
+        for (const auto &streamIdentifier : streamIdentifiers)
+        {
+            auto stream = findStream(streamIdentifier);
+            if (stream)
             {
-                auto contextAddress
-                    = reinterpret_cast<uintptr_t> (pendingSubscription);
-                constexpr bool enqueueNextPacket{true};
-                if (jdx->second->subscribe(contextAddress, enqueueNextPacket))
-                {
-                    // Successful subscribe to all; add to active
-                    // subscriptions 
-                    addToActiveSubscriptionsMap(contextAddress,
-                                                streamIdentifier);
-                }
-                else
-                {
-                    SPDLOG_LOGGER_WARN(mLogger,
-                                       "Failed to subscribe {} to {}",
-                                       contextAddress, streamIdentifier);
-                }
+                capacity = capacity + stream->getMaximumQueueSize();
             }
-            // Whoever was particularly interested in this stream should be
-            // subscribed
-            for (auto &pendingSubscription : mPendingSubscriptionRequests)
+            else
             {
-                auto kdx = pendingSubscription.second.find(streamIdentifier);
-                if (kdx != pendingSubscription.second.end())
-                {
-                    auto contextAddress
-                        = reinterpret_cast<uintptr_t> (pendingSubscription.first);
-                    constexpr bool enqueueNextPacket{true}; 
-                    if (jdx->second->subscribe(contextAddress, enqueueNextPacket))
-                    {
-                        // Successful subscribe; add to the active subscriptions
-                        addToActiveSubscriptionsMap(contextAddress,
-                                                    streamIdentifier);
-                    }
-                    else
-                    {
-                        SPDLOG_LOGGER_WARN(mLogger,
-                                           "Failed to subscribe {} to {}",
-                                           contextAddress, streamIdentifier);
-                    }
-                    pendingSubscription.second.erase(streamIdentifier);
-                } 
+                capacity = capacity + mStreamOptions.getMaximumQueueSize();
             }
-            // If all of the subscriber's requests have been filled then purge
-            // it from the pending list
-            for (auto it = mPendingSubscriptionRequests.cbegin();
-                 it != mPendingSubscriptionRequests.cend();
-                 )
+        }
+        return capacity;
+    }
+
+    /// Brings the queues back within the memory budget.  First the packets
+    /// every member of a group has read are released.  Then, if that is not
+    /// enough, the laggiest subscriber's backlog is skipped and released,
+    /// and so on, until the budget is met.  Only one publisher sheds at a
+    /// time and, when shedding could not meet the budget, e.g., because the
+    /// import queue holds the memory, it backs off for a little while.
+    void shedMemory()
+    {
+        if (mSheddingPolicy == SubscriptionManagerOptions::SheddingPolicy::None)
+        {
+            return;
+        }
+        auto now = Utilities::getNow<std::chrono::nanoseconds> ();
+        if (now.count() < mNextShedTime.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        if (mShedding.exchange(true, std::memory_order_acquire)){return;}
+        int nShed{0};
+        int64_t packetsShed{0};
+        {
+        // Nobody may join a group while it is trimmed.  Polls read the
+        // published registry so this does not block them.
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto registry = mSubscriberRegistry.load(std::memory_order_acquire);
+        trimGroups(*registry);
+        while (mMemoryBudget.isExceeded())
+        {
+            // Find the laggiest subscriber
+            const RegistryEntry *laggiest{nullptr};
+            int largestLag{0};
+            for (const auto &entry : *registry)
             {
-                // This guy is fully subscribed
-                if (it->second.empty())
-                {
-                    SPDLOG_LOGGER_DEBUG(mLogger,
-                                        "All pending subscriptions filled for {}",
-                                        std::to_string {it->first});
-                    {
-                    std::lock_guard<std::mutex> lock(mMutex);
-                    mPendingSubscriptionRequests.unsafe_erase(it++);
-                    }
-                }
-                else
+                if (!entry.group || !entry.cursor){continue;}
+                auto lag = entry.group->log.getLag(
+                    entry.cursor->sequence.load(std::memory_order_acquire));
+                if (lag > largestLag)
                 {
-                    ++it;
+                    laggiest = &entry;
+                    largestLag = lag;
                 }
             }
+            if (laggiest == nullptr){break;}
+            // Skip its backlog and release what nobody else needs
+            int lag{0};
+            {
+            std::lock_guard<std::mutex> cursorLock(laggiest->cursor->mutex);
+            auto &log = laggiest->group->log;
+            lag = log.getLag(
+                laggiest->cursor->sequence.load(std::memory_order_relaxed));
+            laggiest->cursor->sequence.store(log.getHead(),
+                                             std::memory_order_relaxed);
+            }
+            laggiest->cursor->packetsDropped.fetch_add(
+                lag, std::memory_order_relaxed);
+            mMetrics.addDroppedPackets(Metrics::DropLocation::MemoryBudget,
+                                       lag);
+            trimGroup(*registry, *laggiest->group);
+            nShed = nShed + 1;
+            packetsShed = packetsShed + lag;
         }
-        else
+        }
+        if (mMemoryBudget.isExceeded())
         {
-            throw std::runtime_error("Failed to insert " + streamIdentifier
-                                   + " into streams map");
+            mNextShedTime.store((now + mShedBackOff).count(),
+                                std::memory_order_relaxed);
+        }
+        mShedding.store(false, std::memory_order_release);
+        if (nShed > 0)
+        {
+            SPDLOG_LOGGER_WARN(mLogger,
+                               "Memory budget exceeded; shed {} packets from {} subscribers",
+                               packetsShed, nShed);
         }
     }
 
-    /// Context is subscribing to set of streams
-    void subscribe(
-        uintptr_t contextAddress, 
-        const std::vector<UDataPacketServiceAPI::V1::StreamIdentifier>
-            &streamIdentifiers)
+    /// Releases the packets that every member of a group has read.  The
+    /// groups without members were already trimmed when their last member
+    /// left.
+    /// @note The caller must hold mMutex.
+    void trimGroups(const SubscriberRegistry &registry)
     {
-        if (streamIdentifiers.empty()){return;}
-        for (const auto &identifier : streamIdentifiers)
+        std::map<SubscriptionGroup *, uint64_t> oldestCursors;
+        for (const auto &entry : registry)
+        {
+            if (!entry.group || !entry.cursor){continue;}
+            auto sequence
+                = entry.cursor->sequence.load(std::memory_order_acquire);
+            auto [idx, inserted]
+                = oldestCursors.try_emplace(entry.group.get(), sequence);
+            if (!inserted){idx->second = std::min(idx->second, sequence);}
+        }
+        for (auto &oldestCursor : oldestCursors)
+        {
+            oldestCursor.first->log.trim(oldestCursor.second);
+        }
+    }
+
+    /// Releases the packets that every member of the group has read.
+    /// @note The caller must hold mMutex.
+    void trimGroup(const SubscriberRegistry &registry,
+                   SubscriptionGroup &group)
+    {
+        auto oldestCursor = group.log.getHead();
+        for (const auto &entry : registry)
+        {
+            if (entry.group.get() != &group || !entry.cursor){continue;}
+            oldestCursor
+                = std::min(oldestCursor,
+                           entry.cursor->sequence.load(std::memory_order_acquire));
+        }
+        group.log.trim(oldestCursor);
+    }
+
+    /// Finds the stream.  The lock is only held for the lookup so an
+    /// eviction waits on one lookup rather than a caller's whole loop.
+    /// @result The stream or nullptr if it does not exist.
+    [[nodiscard]] std::shared_ptr<Stream>
+        findStream(const std::string &streamIdentifier) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mStreamsMutex);
+        auto idx = mStreamsMap.find(streamIdentifier);
+        if (idx == mStreamsMap.end()){return nullptr;}
+        return idx->second;
+    }
+
+    /// The streams.  Only the pointers are copied under the lock.
+    [[nodiscard]] std::vector<std::shared_ptr<Stream>> getStreams() const
+    {
+        std::vector<std::shared_ptr<Stream>> result;
+        std::shared_lock<std::shared_mutex> lock(mStreamsMutex);
+        result.reserve(mStreamsMap.size());
+        for (const auto &stream : mStreamsMap)
         {
-            auto streamIdentifier = Utilities::toName(identifier);
-            auto idx = mStreamsMap.find(streamIdentifier);
-            if (idx != mStreamsMap.end())
+            result.push_back(stream.second);
+        }
+        return result;
+    }
+
+    /// The number of streams in the registry
+    [[nodiscard]] size_t getNumberOfStreams() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mStreamsMutex);
+        return mStreamsMap.size();
+    }
+
+    /// Runs the idle stream eviction if it is due.  Only one publisher
+    /// will win the race to do it.
+    void checkIdleStreams()
+    {
+        auto now = Utilities::getNow<std::chrono::nanoseconds> ();
+        auto nextCheck = mNextEvictionCheck.load(std::memory_order_relaxed);
+        if (now.count() < nextCheck){return;}
+        if (!mNextEvictionCheck.compare_exchange_strong(
+                nextCheck, (now + mEvictionCheckInterval).count()))
+        {
+            return;
+        }
+        (void) evictIdleStreams(now);
+    }
+
+    /// Removes the streams that have been silent for longer than the idle
+    /// stream timeout.  Their subscribers' groups are keyed on the stream
+    /// names so the subscribers simply wait for the streams to return.
+    int evictIdleStreams(const std::chrono::nanoseconds &now)
+    {
+        std::vector<std::string> evictedStreams;
+        {
+        std::lock_guard<std::mutex> evictionLock(mEvictionMutex);
+        auto cutOff = now - mIdleStreamTimeout;
+        std::vector<EvictionCandidate> candidates;
+        {
+        std::shared_lock<std::shared_mutex> lock(mStreamsMutex);
+        while (!mEvictionQueue.empty() &&
+               mEvictionQueue.top().lastPacketTime < cutOff)
+        {
+            auto candidate = popStalestStream();
+            if (!candidate){break;}
+            if (candidate->lastPacketTime >= cutOff)
             {
-                // Stream exists - add it
-                try
-                {
-                    // I'm joining late
-                    constexpr bool enqueueNextPacket{false}; 
-                    if (idx->second->subscribe(contextAddress,
-                                               enqueueNextPacket))
-                    {
-                        addToActiveSubscriptionsMap(contextAddress,
-                                                    streamIdentifier);
-                        SPDLOG_LOGGER_DEBUG(mLogger,
-                                            "Subscribed {} to {}",
-                                            std::to_string(contextAddress),
-                                            streamIdentifier);
-                    }
-                    else
-                    {
-                        SPDLOG_LOGGER_DEBUG(mLogger,
-                                            "Failed to subscribe {} to {}",
-                                            std::to_string(contextAddress),
-                                            streamIdentifier);
-                    }
-                }
-                catch (const std::exception &e)
-                {
-                    SPDLOG_LOGGER_WARN(mLogger,
-                                      "Failed to subscribe {} to {} because {}",
-                                      std::to_string(contextAddress),
-                                      streamIdentifier,
-                                      std::string {e.what()});                          
-                }
+                pushEvictionCandidate(std::move(candidate->streamIdentifier),
+                                      candidate->lastPacketTime);
+                break;
             }
-            else
+            candidates.push_back(std::move(*candidate));
+        }
+        }
+        if (!candidates.empty())
+        {
+            std::unique_lock<std::shared_mutex> lock(mStreamsMutex);
+            for (auto &candidate : candidates)
             {
-                // Stream doesn't exist yet, add stream to pending subscriptions
-                // Check our pending subscriptions for this context
-                auto jdx = mPendingSubscriptionRequests.find(contextAddress);
-                if (jdx != mPendingSubscriptionRequests.end())
+                auto idx = mStreamsMap.find(candidate.streamIdentifier);
+                if (idx == mStreamsMap.end()){continue;}
+                // A packet may have arrived since I looked
+                auto lastPacketTime = idx->second->getLastPacketTime();
+                if (lastPacketTime > candidate.lastPacketTime)
                 {
-                    // The context already has this subscription pending
-                    if (jdx->second.contains(streamIdentifier))
-                    {
-                        SPDLOG_LOGGER_DEBUG(mLogger,
-                                  "{} already has a pending subscription for {}",
-                                  std::to_string(contextAddress),
-                                  streamIdentifier);
-                    }
-                    else
-                    {
-                        // Now it's pending
-                        jdx->second.insert(streamIdentifier);
-                    }
+                    pushEvictionCandidate(
+                        std::move(candidate.streamIdentifier), lastPacketTime);
+                    continue;
                 }
-                else
-                {
-                    // Need a new context with a new pending subscription
-                    std::set<std::string> tempSet{streamIdentifier};
-                    mPendingSubscriptionRequests.insert(
-                        std::pair {contextAddress, std::move(tempSet)}
-                    );
-                }
-
+                mTotalQueueCapacity.fetch_sub(
+                    idx->second->getMaximumQueueSize(),
+                    std::memory_order_relaxed);
+                mStreamsMap.unsafe_erase(candidate.streamIdentifier);
+                evictedStreams.push_back(
+                    std::move(candidate.streamIdentifier));
             }
-        } // Loop on desired streams
-        // Update number of subscribers 
+        }
+        }
+        auto nEvicted = static_cast<int> (evictedStreams.size());
+        if (nEvicted > 0)
         {
-        std::lock_guard<std::mutex> lock(mMutex);
-        mNumberOfSubscribers =-1; // Reset for getNumberOfSubscribers()
+            mNumberOfEvictedStreams.fetch_add(nEvicted,
+                                              std::memory_order_relaxed);
+            mMetrics.addEvictedStreams(nEvicted);
+            mMetrics.updateNumberOfStreams(
+                static_cast<int64_t> (getNumberOfStreams()));
+            SPDLOG_LOGGER_INFO(mLogger, "Evicted {} idle streams", nEvicted);
+            for (const auto &streamIdentifier : evictedStreams)
+            {
+                SPDLOG_LOGGER_DEBUG(mLogger,
+                                    "Evicted idle stream {}",
+                                    streamIdentifier);
+                updateRetention(streamIdentifier);
+            }
+            updateRetention(*mAllGroup);
         }
+        return nEvicted;
     }
 
-    /// Context is subscribe to all streams
-    void subscribeToAll(uintptr_t contextAddress)
+    /// Removes the stream that has been silent the longest to make room in
+    /// a full registry.
+    void evictStalestStream()
     {
-        if (mPendingSubscribeToAllRequests.contains(contextAddress))
+        std::string stalestStream;
         {
-            SPDLOG_LOGGER_INFO(mLogger,
-                               "{} already waiting to subscribe to all",
-                               std::to_string (contextAddress));
-            return;
-        }
-        // Attach to all streams
-        for (auto &stream : mStreamsMap)
+        std::lock_guard<std::mutex> evictionLock(mEvictionMutex);
+        while (stalestStream.empty())
         {
-            auto streamIdentifier = stream.second->getIdentifier();
-#ifndef NDEBUG
-            assert(!streamIdentifier.empty());
-#endif
-            try
+            std::optional<EvictionCandidate> candidate;
             {
-                // I'm joining late - don't load packet that existed before me
-                constexpr bool enqueueLatestPacket{false};
-                if (stream.second->subscribe(contextAddress,
-                                             enqueueLatestPacket))
-                {
-                    // Subscribed - add to active subscriptions
-                    addToActiveSubscriptionsMap(contextAddress,
-                                                streamIdentifier);
-
-#ifndef NDEBUG
-                    SPDLOG_LOGGER_DEBUG(mLogger,
-                                        "{} subscribed to {}",
-                                        std::to_string (contextAddress),
-                                        streamIdentifier);
-#endif
-                }
-                else
-                {
-                    SPDLOG_LOGGER_WARN(mLogger,
-                                       "{} did not subscribe to {}",
-                                       std::to_string (contextAddress),
-                                       streamIdentifier);
-                } 
+            std::shared_lock<std::shared_mutex> lock(mStreamsMutex);
+            // Someone else may have made room
+            if (mStreamsMap.size() < mMaximumNumberOfStreams){return;}
+            candidate = popStalestStream();
             }
-            catch (const std::exception &e)
+            if (!candidate){return;}
+            std::unique_lock<std::shared_mutex> lock(mStreamsMutex);
+            auto idx = mStreamsMap.find(candidate->streamIdentifier);
+            if (idx == mStreamsMap.end()){continue;}
+            // A packet may have arrived since I looked
+            auto lastPacketTime = idx->second->getLastPacketTime();
+            if (lastPacketTime > candidate->lastPacketTime)
             {
-                SPDLOG_LOGGER_WARN(mLogger,
-                                   "{} failed to subscribe to {} because {}",
-                                   std::to_string (contextAddress),
-                                   streamIdentifier,
-                                   std::string {e.what()});
+                pushEvictionCandidate(std::move(candidate->streamIdentifier),
+                                      lastPacketTime);
+                continue;
             }
+            mTotalQueueCapacity.fetch_sub(idx->second->getMaximumQueueSize(),
+                                          std::memory_order_relaxed);
+            mStreamsMap.unsafe_erase(candidate->streamIdentifier);
+            stalestStream = std::move(candidate->streamIdentifier);
         }
-        // And be ready for all future streams that come online
-        mPendingSubscribeToAllRequests.insert(contextAddress);
-        // Signal update number of subscribers 
+        }
+        mNumberOfEvictedStreams.fetch_add(1, std::memory_order_relaxed);
+        mMetrics.addEvictedStreams(1);
+        updateRetention(stalestStream);
+        if (auto nEvicted = mRegistryFullLog.add(); nEvicted > 0)
         {
-        std::lock_guard<std::mutex> lock(mMutex);
-        mNumberOfSubscribers =-1; // Reset for getNumberOfSubscribers()
+            SPDLOG_LOGGER_WARN(mLogger,
+                               "Stream registry is full; evicted {} streams, latest {}",
+                               nEvicted, stalestStream);
         }
     }
 
-    [[nodiscard]] std::vector<UDataPacketServiceAPI::V1::Packet>
-        getPackets(uintptr_t contextAddress) const
+    /// Logs the rate-limited warnings that are still pending
+    void reportSuppressedWarnings()
     {
-        std::vector<UDataPacketServiceAPI::V1::Packet> result;
-        result.reserve(16);
-        // Look through my active subscriptions
-        for (const auto &activeSubscription : mActiveSubscriptionsMap)
+        if (auto nEvicted = mRegistryFullLog.poll(); nEvicted > 0)
         {
-            for (const auto &streamIdentifier : activeSubscription.second)
+            SPDLOG_LOGGER_WARN(mLogger,
+                               "Stream registry is full; evicted {} more streams",
+                               nEvicted);
+        }
+    }
+
+    /// Pops the stream that has been silent the longest.  The queue's
+    /// entries are only refreshed here so an entry whose stream has
+    /// received packets since is pushed back with the stream's current
+    /// time.  Every refresh follows at least one packet so the work is
+    /// amortized over the packets rather than paid by a scan of every
+    /// stream.
+    /// @result The stalest stream or nullopt if there are no streams.
+    /// @note The caller must hold mEvictionMutex and mStreamsMutex.
+    [[nodiscard]] std::optional<EvictionCandidate> popStalestStream()
+    {
+        while (!mEvictionQueue.empty())
+        {
+            auto candidate = mEvictionQueue.top();
+            mEvictionQueue.pop();
+            // Skip entries that were superseded
+            auto tdx = mEvictionTimes.find(candidate.streamIdentifier);
+            if (tdx == mEvictionTimes.end() ||
+                tdx->second != candidate.lastPacketTime)
             {
-                const auto streamIndex = mStreamsMap.find(streamIdentifier);
-                if (streamIndex != mStreamsMap.end())
-                {
-                    try
-                    {
-                        auto packet
-                            = streamIndex->second->getNextPacket(contextAddress);
-                        if (packet)
-                        {
-                            result.push_back(std::move(*packet));
-                        }
-                    }
-                    catch (const std::exception &e)
-                    {
-                        SPDLOG_LOGGER_WARN(mLogger,
-                        "Failed to get packet from stream {} for {} because {}",
-                          streamIndex->first,
-                          std::to_string(contextAddress),
-                          std::string {e.what()});
-                    }
-                }
-                else
-                {
-                    SPDLOG_LOGGER_WARN(mLogger,
-                          "Failed to find stream {} for active subscriber {}",
-                          streamIndex->first, std::to_string(contextAddress));
-                }
+                continue;
             }
+            auto idx = mStreamsMap.find(candidate.streamIdentifier);
+            if (idx == mStreamsMap.end())
+            {
+                mEvictionTimes.erase(tdx);
+                continue;
+            }
+            auto lastPacketTime = idx->second->getLastPacketTime();
+            if (lastPacketTime > candidate.lastPacketTime)
+            {
+                tdx->second = lastPacketTime;
+                mEvictionQueue.push(EvictionCandidate {lastPacketTime,
+                                    std::move(candidate.streamIdentifier)});
+                continue;
+            }
+            mEvictionTimes.erase(tdx);
+            return std::make_optional<EvictionCandidate> (std::move(candidate));
         }
-        return result;
+        return std::nullopt;
     }
 
-    /// Context is leaving
-    void unsubscribeFromAll(uintptr_t contextAddress)
+    /// Adds the stream to the eviction queue.  This supersedes the stream's
+    /// previous entry.
+    /// @note The caller must hold mEvictionMutex.
+    void pushEvictionCandidate(std::string streamIdentifier,
+                               const std::chrono::nanoseconds &lastPacketTime)
+    {
+        mEvictionTimes.insert_or_assign(streamIdentifier, lastPacketTime);
+        mEvictionQueue.push(EvictionCandidate {lastPacketTime,
+                                               std::move(streamIdentifier)});
+    }
+
+    /// Issues a new subscriber handle
+    [[nodiscard]] SubscriberHandle createSubscriber(const std::string &peer)
     {
-        bool wasUnsubscribed{false};
-        // Pop from the pending fine-grained requests
-        {
         std::lock_guard<std::mutex> lock(mMutex);
-        size_t erased = mPendingSubscriptionRequests.unsafe_erase(contextAddress);
-        if (erased == 1){wasUnsubscribed = true;}
-        // Pop from the pending subscribe to all requests
-        erased = mPendingSubscribeToAllRequests.unsafe_erase(contextAddress);
-        if (erased == 1){wasUnsubscribed = true;}
+        uint32_t slotIndex{0};
+        if (!mFreeSlots.empty())
+        {
+            slotIndex = mFreeSlots.back();
+            mFreeSlots.pop_back();
         }
-        // Pop from the active subscriptions 
-        bool purgedFromActiveSubscriptions{false};
-        for (auto &stream : mStreamsMap)
+        else
         {
-            try
+            if (mSubscriberSlots.size() >=
+                std::numeric_limits<uint32_t>::max())
             {
-                auto unsubscribeResponse
-                    = stream.second->unsubscribe(contextAddress);
-                if (unsubscribeResponse ==
-                    Stream::UnsubscribeResponse::Unsubscribed)
-                {
-                    wasUnsubscribed = true;
-                    if (!purgedFromActiveSubscriptions)
-                    {   
-                        {
-                        std::lock_guard<std::mutex> lock(mMutex);
-                        mActiveSubscriptionsMap.unsafe_erase(contextAddress);
-                        }
-                        purgedFromActiveSubscriptions = true; 
-                    }   
-                }
-                else if (unsubscribeResponse ==
-                         Stream::UnsubscribeResponse::NeverSubscribed)
-                {
-                    // The lock-guard above ensures we this context was purged
-                    // from the pending subscriptions.  So that this was never
-                    // subscribed is okay.
-                    if (mActiveSubscriptionsMap.contains(contextAddress))
-                    {
-                        SPDLOG_LOGGER_WARN(mLogger,
-                          "{}'s subscription to {} noted as actived but {} not subscribed to stream", 
-                            std::to_string(contextAddress),
-                            stream.first,
-                            std::to_string(contextAddress)
-                            );
-                        {
-                        std::lock_guard<std::mutex> lock(mMutex);
-                        mActiveSubscriptionsMap.unsafe_erase(contextAddress);
-                        }
-                        purgedFromActiveSubscriptions = true; 
-                    }
+                throw std::runtime_error("No subscriber slots available");
+            }
+            slotIndex = static_cast<uint32_t> (mSubscriberSlots.size());
+            mSubscriberSlots.emplace_back();
+        }
+        auto &slot = mSubscriberSlots[slotIndex];
 #ifndef NDEBUG
-                    SPDLOG_LOGGER_DEBUG(mLogger,
-                                        "{} was never subscribed to {}",
-                                        std::to_string(contextAddress),
-                                        stream.first);
+        assert(!slot.inUse);
 #endif
-                }
-                else if (unsubscribeResponse ==
-                         Stream::UnsubscribeResponse::NotUnsubscribed)
-                {
-                    SPDLOG_LOGGER_WARN(mLogger,
-                                       "Did not unsubscribe {} from {}",
-                                        std::to_string(contextAddress),
-                                        stream.first);
-                }
-                else
-                {
-                    SPDLOG_LOGGER_ERROR(mLogger, "Unhandled case");
-                }
-            }
-            catch (const std::exception &e)
+        slot.inUse = true;
+        SubscriberHandle handle{slotIndex, slot.generation};
+        slot.counters
+            = std::make_shared<SubscriberCounters>
+              (handle,
+               peer.empty() ? ::toString(handle) : peer,
+               Utilities::getNow<std::chrono::nanoseconds> ());
+        publishSubscriberRegistry();
+        return handle;
+    }
+
+    /// Subscriber is subscribing to set of streams.  Streams that do not
+    /// yet exist are delivered once they come online.
+    void subscribe(
+        const SubscriberHandle &handle,
+        const std::vector<UDataPacketServiceAPI::V1::StreamIdentifier>
+            &streamIdentifiers)
+    {
+        if (streamIdentifiers.empty()){return;}
+        std::set<std::string> selections;
+        for (const auto &identifier : streamIdentifiers)
+        {
+            selections.insert(Utilities::toName(identifier));
+        }
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto slot = findSlot(handle);
+        if (slot == nullptr)
+        {
+            throw std::invalid_argument("Subscriber handle "
+                                      + ::toString(handle) + " is stale");
+        }
+        if (slot->group)
+        {
+            if (slot->group->all)
             {
-                SPDLOG_LOGGER_WARN(mLogger,
-                                  "Failed to unsubscribe {} from {} because {}",
-                                  std::to_string(contextAddress),
-                                  stream.first,
-                                  std::string {e.what()});
+                SPDLOG_LOGGER_INFO(mLogger,
+                                   "{} already subscribed to all",
+                                   ::toString(handle));
+                return;
             }
+            // Widen the existing selection
+            auto nSelections = slot->group->streamIdentifiers.size();
+            selections.insert(slot->group->streamIdentifiers.begin(),
+                              slot->group->streamIdentifiers.end());
+            if (selections.size() == nSelections){return;}
+            leaveGroup(*slot);
         }
-        // Signal update number of subscribers 
+        registerSubscriber(*slot);
+        auto key = ::toKey(selections);
+        auto idx = mGroups.find(key);
+        if (idx == mGroups.end())
         {
+            // The ring starts at the group's retention and grows if that
+            // does
+            auto retention = getRetention(selections);
+            auto group
+                = std::make_shared<SubscriptionGroup>
+                  (key, std::move(selections), false, retention);
+            idx = mGroups.insert(std::pair {key, std::move(group)}).first;
+            // Publish first so the publisher's updates are not missed
+            publishGroupIndex();
+            updateRetention(*idx->second);
+            SPDLOG_LOGGER_DEBUG(mLogger,
+                                "Created group for {} streams",
+                                idx->second->streamIdentifiers.size());
+        }
+        joinGroup(*slot, idx->second);
+        SPDLOG_LOGGER_DEBUG(mLogger,
+                            "{} subscribed to {} streams",
+                            ::toString(handle),
+                            idx->second->streamIdentifiers.size());
+    }
+
+    /// Subscriber is subscribing to all streams
+    void subscribeToAll(const SubscriberHandle &handle)
+    {
         std::lock_guard<std::mutex> lock(mMutex);
-        mNumberOfSubscribers =-1; // Reset for getNumberOfSubscribers()
+        auto slot = findSlot(handle);
+        if (slot == nullptr)
+        {
+            throw std::invalid_argument("Subscriber handle "
+                                      + ::toString(handle) + " is stale");
+        }
+        if (slot->group && slot->group->all)
+        {
+            SPDLOG_LOGGER_INFO(mLogger,
+                               "{} already subscribed to all",
+                               ::toString(handle));
+            return;
+        }
+        if (slot->group){leaveGroup(*slot);}
+        registerSubscriber(*slot);
+        joinGroup(*slot, mAllGroup);
+        slot->counters->subscribedToAll.store(true, std::memory_order_relaxed);
+        SPDLOG_LOGGER_DEBUG(mLogger,
+                            "{} subscribed to all",
+                            ::toString(handle));
+    }
+
+    [[nodiscard]]
+    std::vector<std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>>
+        getPackets(const SubscriberHandle &handle) const
+    {
+        std::vector<std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>>
+            result;
+        // Find my group and cursor in the published registry.  The registry
+        // keeps them alive while I read.  A stale handle simply gets
+        // nothing.
+        auto registry = mSubscriberRegistry.load(std::memory_order_acquire);
+        auto entry = ::findEntry(*registry, handle);
+        if (entry == nullptr || !entry->group || !entry->cursor)
+        {
+            return result;
+        }
+        auto &group = entry->group;
+        auto &cursor = entry->cursor;
+        std::lock_guard<std::mutex> lock(cursor->mutex);
+        auto sequence = cursor->sequence.load(std::memory_order_relaxed);
+        auto packetsDropped
+            = group->log.read(sequence, mMaximumBatchSize, result);
+        cursor->sequence.store(sequence, std::memory_order_relaxed);
+        if (packetsDropped > 0)
+        {
+            cursor->packetsDropped.fetch_add(packetsDropped,
+                                             std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    /// Subscriber is leaving
+    void unsubscribeFromAll(const SubscriberHandle &handle)
+    {
+        bool wasUnsubscribed{false};
+        {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto slot = findSlot(handle);
+        if (slot == nullptr)
+        {
+            SPDLOG_LOGGER_DEBUG(mLogger,
+                                "{} was already released",
+                                ::toString(handle));
+            return;
+        }
+        if (slot->group || slot->counted){wasUnsubscribed = true;}
+        releaseSlot(handle.getSlot());
         }
         if (wasUnsubscribed)
         {
             SPDLOG_LOGGER_DEBUG(mLogger,
-                                "{} was unsubscribed from all", 
-                                std::to_string(contextAddress));
+                                "{} was unsubscribed from all",
+                                ::toString(handle));
         }
         else
         {
-            SPDLOG_LOGGER_WARN(mLogger,
-                               "{} may not have been subscribed to anything",
-                               std::to_string(contextAddress));
+            SPDLOG_LOGGER_DEBUG(mLogger,
+                                "{} released without subscribing to anything",
+                                ::toString(handle));
         }
     }
 
     /// @brief Gets the number of subscribers
     [[nodiscard]] int getNumberOfSubscribers() const noexcept
     {
+        return mNumberOfSubscribers.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Gets the number of streams to which the subscriber is actively
+    ///        subscribed.
+    [[nodiscard]] int getNumberOfSubscriptions(
+        const SubscriberHandle &handle) const
+    {
+        auto registry = mSubscriberRegistry.load(std::memory_order_acquire);
+        auto entry = ::findEntry(*registry, handle);
+        if (entry == nullptr){return 0;}
+        return getNumberOfSubscriptions(entry->group.get());
+    }
+
+    /// The number of selected streams that exist
+    [[nodiscard]] int getNumberOfSubscriptions(
+        const SubscriptionGroup *group) const
+    {
+        if (group == nullptr){return 0;}
+        if (group->all){return static_cast<int> (getNumberOfStreams());}
+        int nSubscriptions{0};
+        for (const auto &streamIdentifier : group->streamIdentifiers)
         {
-        std::lock_guard<std::mutex> lock(mMutex);
-        // Early return?
-        if (mNumberOfSubscribers >= 0){return mNumberOfSubscribers;}
-        std::set<uintptr_t> allSubscribers;
-        // Count them
-        for (const auto &subscriber : mActiveSubscriptionsMap)
-        {
-            allSubscribers.insert(subscriber.first);
+            if (findStream(streamIdentifier)){nSubscriptions++;}
         }
-        for (const auto &subscriber : mPendingSubscriptionRequests)
+        return nSubscriptions;
+    }
+
+    /// The subscriber's live counters
+    [[nodiscard]] std::shared_ptr<SubscriberCounters>
+        getSubscriberCounters(const SubscriberHandle &handle) const
+    {
+        auto registry = mSubscriberRegistry.load(std::memory_order_acquire);
+        auto entry = ::findEntry(*registry, handle);
+        if (entry != nullptr){return entry->counters;}
+        return nullptr;
+    }
+
+    /// Statistics of a stream including the members of the groups that
+    /// selected it
+    [[nodiscard]] StreamStatistics getStreamStatistics(
+        const Stream &stream, const GroupIndex &groupIndex) const
+    {
+        auto statistics = stream.getStatistics();
+        auto gdx = groupIndex.find(statistics.identifier);
+        if (gdx != groupIndex.end())
         {
-            allSubscribers.insert(subscriber.first);
+            for (const auto &group : gdx->second)
+            {
+                statistics.numberOfSubscribers
+                    += group->nMembers.load(std::memory_order_relaxed);
+            }
         }
-        for (const auto &subscriber : mPendingSubscribeToAllRequests)
+        return statistics;
+    }
+
+    /// Snapshot of the stream statistics
+    [[nodiscard]] std::vector<StreamStatistics> getStreamStatistics() const
+    {
+        std::vector<StreamStatistics> result;
+        auto groupIndex = mGroupIndex.load(std::memory_order_acquire);
+        auto streams = getStreams();
+        result.reserve(streams.size());
+        for (const auto &stream : streams)
         {
-            allSubscribers.insert(subscriber);
+            result.push_back(getStreamStatistics(*stream, *groupIndex));
         }
-        // Update and finish
-        mNumberOfSubscribers = static_cast<int> (allSubscribers.size());
-        return mNumberOfSubscribers;
+        return result;
+    }
+
+    /// Statistics of a single stream
+    [[nodiscard]] std::optional<StreamStatistics>
+        getStreamStatistics(const std::string &streamIdentifier) const
+    {
+        auto stream = findStream(streamIdentifier);
+        if (!stream){return std::nullopt;}
+        auto groupIndex = mGroupIndex.load(std::memory_order_acquire);
+        return std::make_optional<StreamStatistics>
+               (getStreamStatistics(*stream, *groupIndex));
+    }
+
+    /// The stream names
+    [[nodiscard]] std::vector<std::string> getStreamIdentifiers() const
+    {
+        std::vector<std::string> result;
+        std::shared_lock<std::shared_mutex> lock(mStreamsMutex);
+        for (const auto &stream : mStreamsMap)
+        {
+            result.push_back(stream.first);
         }
-        /* 
-        if (mNumberOfSubscribers < 0)
+        return result;
+    }
+
+    /// Snapshot of the subscriber statistics.  This reads the published
+    /// registry and the logs' atomics so it never takes the lock.
+    [[nodiscard]] std::vector<SubscriberStatistics>
+        getSubscriberStatistics() const
+    {
+        std::vector<SubscriberStatistics> result;
+        auto registry = mSubscriberRegistry.load(std::memory_order_acquire);
+        result.reserve(registry->size());
+        auto now = Utilities::getNow<std::chrono::nanoseconds> ();
+        for (const auto &entry : *registry)
         {
-            std::set<uintptr_t> allSubscribers;
-            for (const auto &stream : mStreamsMap)
+            if (!entry.counters){continue;}
+            const auto &counters = *entry.counters;
+            SubscriberStatistics statistics;
+            statistics.peer = counters.getPeer();
+            statistics.handle = counters.getHandle();
+            statistics.connectedTime = counters.getConnectedTime();
+            statistics.packetsPerSecond
+                = counters.delivered.getPacketsPerSecond(now);
+            statistics.bytesPerSecond
+                = counters.delivered.getBytesPerSecond(now);
+            statistics.packetsDelivered = counters.delivered.getPackets();
+            statistics.bytesDelivered = counters.delivered.getBytes();
+            statistics.packetsDropped
+                = counters.packetsDropped.load(std::memory_order_relaxed);
+            statistics.queueDepth
+                = counters.queueDepth.load(std::memory_order_relaxed);
+            statistics.subscribedToAll
+                = counters.subscribedToAll.load(std::memory_order_relaxed);
+            // Add what is waiting on and was dropped by the group's log
+            if (entry.group && entry.cursor)
             {
-                auto subscribers = stream.second->getSubscribers();
-                allSubscribers.insert(subscribers.begin(), subscribers.end());
-            }
-            if (allSubscribers.empty())
-            {
-                mNumberOfSubscribers
-                   = mPendingSubscriptionRequests.size()
-                   + mPendingSubscribeToAllRequests.size();
-            }
-            else
-            {
-                mNumberOfSubscribers = static_cast<int> (allSubscribers.size());
+                const auto &cursor = *entry.cursor;
+                statistics.queueDepth += entry.group->log.getLag(
+                    cursor.sequence.load(std::memory_order_relaxed));
+                statistics.packetsDropped
+                    += cursor.packetsDropped.load(std::memory_order_relaxed);
+                statistics.numberOfSubscriptions
+                    = getNumberOfSubscriptions(entry.group.get());
             }
+            result.push_back(std::move(statistics));
         }
-        */
-        return mNumberOfSubscribers;
+        return result;
     }
 
     void unsubscribeAll()
@@ -492,14 +1106,15 @@ public:
         // Do not let these get filled while I'm clearing
         {
         std::lock_guard<std::mutex> lock(mMutex);
-        mNumberOfSubscribers =-1;
-        mPendingSubscriptionRequests.clear();
-        mPendingSubscribeToAllRequests.clear();
-        // Purge the active subscriptions 
-        for (auto &stream : mStreamsMap)
+        // Release every issued handle.  Their holders will find them stale.
+        for (size_t i = 0; i < mSubscriberSlots.size(); ++i)
         {
-             stream.second->unsubscribeAll();
+            if (mSubscriberSlots[i].inUse)
+            {
+                releaseSlot(static_cast<uint32_t> (i), false);
+            }
         }
+        publishSubscriberRegistry();
         }
         std::this_thread::sleep_for(std::chrono::milliseconds {10});
         // Check
@@ -513,44 +1128,186 @@ public:
         }
     }
 
-    void addToActiveSubscriptionsMap(uintptr_t contextAddress,
-                                     const std::string &streamIdentifier)
+    /// Finds the slot corresponding to the handle.
+    /// @result A pointer to the slot or nullptr if the handle is stale.
+    /// @note The caller must hold mMutex.
+    [[nodiscard]] SubscriberSlot *findSlot(const SubscriberHandle &handle)
     {
-        if (mActiveSubscriptionsMap.contains(contextAddress))
+        auto slotIndex = handle.getSlot();
+        if (slotIndex >= mSubscriberSlots.size()){return nullptr;}
+        auto &slot = mSubscriberSlots[slotIndex];
+        if (!slot.inUse || slot.generation != handle.getGeneration())
         {
-            mActiveSubscriptionsMap[contextAddress].insert(streamIdentifier);
+            return nullptr;
         }
-        else
+        return &slot;
+    }
+    /// Returns the slot to the free list and advances its generation.
+    /// @note The caller must hold mMutex.
+    void releaseSlot(const uint32_t slotIndex, const bool publish = true)
+    {
+        auto &slot = mSubscriberSlots[slotIndex];
+        unregisterSubscriber(slot);
+        if (slot.group){leaveGroup(slot, false);}
+        auto generation = slot.generation + 1;
+        if (generation == 0){generation = 1;} // Zero is reserved
+        slot = SubscriberSlot {};
+        slot.generation = generation;
+        mFreeSlots.push_back(slotIndex);
+        if (publish){publishSubscriberRegistry();}
+    }
+    /// Publishes the current subscribers for the readers and statistics.
+    /// @note The caller must hold mMutex.
+    void publishSubscriberRegistry()
+    {
+        auto registry
+            = std::make_shared<SubscriberRegistry> (mSubscriberSlots.size());
+        for (size_t i = 0; i < mSubscriberSlots.size(); ++i)
         {
-            std::set<std::string> newSet{streamIdentifier};
-            mActiveSubscriptionsMap[contextAddress] = std::move(newSet);
+            const auto &slot = mSubscriberSlots[i];
+            if (slot.inUse && slot.counters)
+            {
+                (*registry)[i] = RegistryEntry {slot.counters,
+                                                slot.group,
+                                                slot.cursor,
+                                                slot.generation};
+            }
         }
+        mSubscriberRegistry.store(std::move(registry),
+                                  std::memory_order_release);
     }
+    /// Publishes the index from streams to groups for the publisher.
+    /// @note The caller must hold mMutex.
+    void publishGroupIndex()
+    {
+        auto groupIndex = std::make_shared<GroupIndex> ();
+        for (const auto &group : mGroups)
+        {
+            for (const auto &streamIdentifier : group.second->streamIdentifiers)
+            {
+                (*groupIndex)[streamIdentifier].push_back(group.second);
+            }
+        }
+        mGroupIndex.store(std::move(groupIndex), std::memory_order_release);
+    }
+    /// Adds the subscriber to the group.  The subscriber is joining late
+    /// so it starts at the head of the group's log.
+    /// @note The caller must hold mMutex.
+    void joinGroup(SubscriberSlot &slot,
+                   const std::shared_ptr<SubscriptionGroup> &group)
+    {
+        if (group->nMembers.fetch_add(1, std::memory_order_acq_rel) == 0)
+        {
+            // A publisher that raced the last member out may have left
+            // packets that nobody will read
+            group->log.trim(group->log.getHead());
+        }
+        slot.group = group;
+        slot.cursor = std::make_shared<BroadcastCursor> (group->log.getHead());
+        publishSubscriberRegistry();
+    }
+    /// Removes the subscriber from its group.  The last member out releases
+    /// the group's packets and retires the group.
+    /// @note The caller must hold mMutex.
+    void leaveGroup(SubscriberSlot &slot, const bool publish = true)
+    {
+        auto group = std::move(slot.group);
+        slot.cursor = nullptr;
+        if (!group){return;}
+        auto nMembers
+            = group->nMembers.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        if (nMembers == 0)
+        {
+            group->log.trim(group->log.getHead());
+            if (!group->all)
+            {
+                mGroups.erase(group->key);
+                publishGroupIndex();
+            }
+        }
+        if (publish){publishSubscriberRegistry();}
+    }
+    /// Counts the subscriber if it is not already counted.
+    /// @note The caller must hold mMutex.
+    void registerSubscriber(SubscriberSlot &slot)
+    {
+        if (!slot.counted)
+        {
+            slot.counted = true;
+            mNumberOfSubscribers.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    /// Stops counting the subscriber.
+    /// @note The caller must hold mMutex.
+    void unregisterSubscriber(SubscriberSlot &slot)
+    {
+        if (slot.counted)
+        {
+            slot.counted = false;
+            mNumberOfSubscribers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
 //private:
     SubscriptionManagerOptions mOptions;
     std::shared_ptr<spdlog::logger> mLogger{nullptr};
     mutable std::mutex mMutex;
+    // Streams are found and added concurrently but removing one requires
+    // exclusive access.  Readers hold this only for a lookup or to copy
+    // the streams' pointers so an eviction is never stuck behind a loop.
+    mutable std::shared_mutex mStreamsMutex;
+    Metrics::MetricsSingleton &mMetrics
+    {
+        Metrics::MetricsSingleton::getInstance()
+    };
+    MemoryBudget &mMemoryBudget{MemoryBudget::getInstance()};
     oneapi::tbb::concurrent_map
     <
         std::string,            // Stream identifier
-        std::unique_ptr<Stream> // Stream
+        std::shared_ptr<Stream> // Stream
     > mStreamsMap;
-    oneapi::tbb::concurrent_map
-    <
-        uintptr_t,            // Context identifier
-        std::set<std::string> // Stream identifiers
-    > mActiveSubscriptionsMap;
-    oneapi::tbb::concurrent_map
-    <
-        uintptr_t, //T *, //grpc::CallbackServerContext *,
-        std::set<std::string>
-    > mPendingSubscriptionRequests;
-    oneapi::tbb::concurrent_set
-    <
-        uintptr_t //T * //grpc::CallbackServerContext *
-    > mPendingSubscribeToAllRequests;
+    // The subscriber slab.  A handle's slot indexes directly into this.
+    // Guarded by mMutex.
+    std::vector<SubscriberSlot> mSubscriberSlots;
+    std::vector<uint32_t> mFreeSlots;
+    // The groups keyed on their canonical selection.  Guarded by mMutex.
+    std::map<std::string, std::shared_ptr<SubscriptionGroup>> mGroups;
+    // The group of subscribers to all streams
+    std::shared_ptr<SubscriptionGroup> mAllGroup{nullptr};
+    // The groups as seen by the publisher
+    std::atomic<std::shared_ptr<const GroupIndex>> mGroupIndex{
+        std::make_shared<const GroupIndex> ()};
+    // The subscribers as seen by the readers and the statistics
+    std::atomic<std::shared_ptr<const SubscriberRegistry>> mSubscriberRegistry{
+        std::make_shared<const SubscriberRegistry> ()};
     StreamOptions mStreamOptions;
-    mutable int mNumberOfSubscribers{-1};
+    std::optional<int64_t> mMaximumQueueBytes;
+    // The combined capacity of the live streams' queues
+    std::atomic<int64_t> mTotalQueueCapacity{0};
+    std::chrono::nanoseconds mIdleStreamTimeout{std::chrono::hours {1}};
+    std::chrono::nanoseconds mEvictionCheckInterval{std::chrono::minutes {1}};
+    // The streams ordered by the times of their last packets when they
+    // were last looked at, and the time of each stream's current entry.
+    // Guarded by mEvictionMutex.
+    std::mutex mEvictionMutex;
+    std::priority_queue
+    <
+        EvictionCandidate,
+        std::vector<EvictionCandidate>,
+        std::greater<EvictionCandidate>
+    > mEvictionQueue;
+    std::unordered_map<std::string, std::chrono::nanoseconds> mEvictionTimes;
+    std::atomic<int64_t> mNextEvictionCheck{0};
+    std::atomic<int64_t> mNumberOfEvictedStreams{0};
+    Utilities::RateLimitedLog mRegistryFullLog;
+    size_t mMaximumNumberOfStreams{65536};
+    std::atomic<int> mNumberOfSubscribers{0};
+    int mMaximumBatchSize{256};
+    SubscriptionManagerOptions::SheddingPolicy mSheddingPolicy{
+        SubscriptionManagerOptions::SheddingPolicy::LaggiestSubscriber};
+    std::chrono::nanoseconds mShedBackOff{std::chrono::milliseconds {100}};
+    std::atomic<int64_t> mNextShedTime{0};
+    std::atomic<bool> mShedding{false};
 };
 
 SubscriptionManager::SubscriptionManager(
@@ -611,11 +1368,57 @@ void SubscriptionManager::subscribeToAll(U *serverContext)
 }
 */
 
+/// Issue a subscriber handle
+SubscriberHandle SubscriptionManager::createSubscriber()
+{
+    return pImpl->createSubscriber("");
+}
+
+SubscriberHandle SubscriptionManager::createSubscriber(const std::string &peer)
+{
+    return pImpl->createSubscriber(peer);
+}
+
+/// Counters
+std::shared_ptr<SubscriberCounters>
+SubscriptionManager::getSubscriberCounters(
+    const SubscriberHandle &handle) const
+{
+    return pImpl->getSubscriberCounters(handle);
+}
+
+/// Statistics
+std::vector<StreamStatistics> SubscriptionManager::getStreamStatistics() const
+{
+    return pImpl->getStreamStatistics();
+}
+
+std::optional<StreamStatistics> SubscriptionManager::getStreamStatistics(
+    const std::string &streamIdentifier) const
+{
+    return pImpl->getStreamStatistics(streamIdentifier);
+}
+
+std::vector<std::string> SubscriptionManager::getStreamIdentifiers() const
+{
+    return pImpl->getStreamIdentifiers();
+}
+
+std::vector<SubscriberStatistics>
+SubscriptionManager::getSubscriberStatistics() const
+{
+    return pImpl->getSubscriberStatistics();
+}
+
 void SubscriptionManager::subscribe(
-    uintptr_t contextAddress,
+    const SubscriberHandle &handle,
     const std::vector<UDataPacketServiceAPI::V1::StreamIdentifier>
         &streamIdentifiersIn)
 {
+    if (!handle.isValid())
+    {
+        throw std::invalid_argument("Subscriber handle is invalid");
+    }
     if (streamIdentifiersIn.empty())
     {
         throw std::invalid_argument("No streams selected");
@@ -636,13 +1439,17 @@ void SubscriptionManager::subscribe(
     {
         throw std::runtime_error("Failed to create stream identifier list");
     }
-    pImpl->subscribe(contextAddress, streamIdentifiers);
+    pImpl->subscribe(handle, streamIdentifiers);
 }
 
 
-void SubscriptionManager::subscribeToAll(uintptr_t contextAddress)
+void SubscriptionManager::subscribeToAll(const SubscriberHandle &handle)
 {
-    pImpl->subscribeToAll(contextAddress);
+    if (!handle.isValid())
+    {
+        throw std::invalid_argument("Subscriber handle is invalid");
+    }
+    pImpl->subscribeToAll(handle);
 }
 
 /*
@@ -659,16 +1466,16 @@ void SubscriptionManager::unsubscribeFromAll(U *serverContext)
 }
 */
 
-void SubscriptionManager::unsubscribeFromAll(uintptr_t contextAddress)
+void SubscriptionManager::unsubscribeFromAll(const SubscriberHandle &handle)
 {
-    return pImpl->unsubscribeFromAll(contextAddress);
+    return pImpl->unsubscribeFromAll(handle);
 }
 
 /// Gets the next packets
-std::vector<UDataPacketServiceAPI::V1::Packet>
-SubscriptionManager::getPackets(uintptr_t contextAddress) const
+std::vector<std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>>
+SubscriptionManager::getPackets(const SubscriberHandle &handle) const
 {
-    return pImpl->getPackets(contextAddress);
+    return pImpl->getPackets(handle);
 }
 
 /// Destructor
@@ -680,12 +1487,44 @@ int SubscriptionManager::getNumberOfSubscribers() const noexcept
     return pImpl->getNumberOfSubscribers();
 }
 
+/// Number of streams a subscriber is receiving
+int SubscriptionManager::getNumberOfSubscriptions(
+    const SubscriberHandle &handle) const
+{
+    return pImpl->getNumberOfSubscriptions(handle);
+}
+
 /// Forcefully removes all subscxribers
 void SubscriptionManager::unsubscribeAll()
 {
     pImpl->unsubscribeAll();
 }
 
+/// Number of streams
+int SubscriptionManager::getNumberOfStreams() const
+{
+    return static_cast<int> (pImpl->getNumberOfStreams());
+}
+
+/// Evicts idle streams
+int SubscriptionManager::evictIdleStreams()
+{
+    return pImpl->evictIdleStreams(
+        Utilities::getNow<std::chrono::nanoseconds> ());
+}
+
+/// Number of evicted streams
+int64_t SubscriptionManager::getNumberOfEvictedStreams() const noexcept
+{
+    return pImpl->mNumberOfEvictedStreams.load(std::memory_order_relaxed);
+}
+
+/// Pending warnings
+void SubscriptionManager::reportSuppressedWarnings()
+{
+    pImpl->reportSuppressedWarnings();
+}
+
 ///--------------------------------------------------------------------------///
 ///                            Template Instantiation                        ///
 ///--------------------------------------------------------------------------///
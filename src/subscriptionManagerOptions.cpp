@@ -1,4 +1,5 @@
 #include <string>
+#include <stdexcept>
 #include "uDataPacketService/subscriptionManagerOptions.hpp"
 #include "uDataPacketService/streamOptions.hpp"
 
@@ -8,6 +9,10 @@ class SubscriptionManagerOptions::SubscriptionManagerOptionsImpl
 {
 public:
     StreamOptions mStreamOptions;
+    std::chrono::seconds mIdleStreamTimeout{3600};
+    int mBroadcastLogCapacity{8388608};
+    int mMaximumNumberOfStreams{65536};
+    SheddingPolicy mSheddingPolicy{SheddingPolicy::LaggiestSubscriber};
     //int mMaximumNumberOfSubscribers{16};
 };
 
@@ -63,6 +68,68 @@ StreamOptions SubscriptionManagerOptions::getStreamOptions() const noexcept
     return pImpl->mStreamOptions;
 }
 
+/// Broadcast log capacity
+void SubscriptionManagerOptions::setBroadcastLogCapacity(const int capacity)
+{
+    if (capacity <= 0)
+    {
+        throw std::invalid_argument("Broadcast log capacity must be positive");
+    }
+    pImpl->mBroadcastLogCapacity = capacity;
+}
+
+int SubscriptionManagerOptions::getBroadcastLogCapacity() const noexcept
+{
+    return pImpl->mBroadcastLogCapacity;
+}
+
+/// Idle stream timeout
+void SubscriptionManagerOptions::setIdleStreamTimeout(
+    const std::chrono::seconds &timeout)
+{
+    if (timeout.count() <= 0)
+    {
+        throw std::invalid_argument("Idle stream timeout must be positive");
+    }
+    pImpl->mIdleStreamTimeout = timeout;
+}
+
+std::chrono::seconds
+SubscriptionManagerOptions::getIdleStreamTimeout() const noexcept
+{
+    return pImpl->mIdleStreamTimeout;
+}
+
+/// Maximum number of streams
+void SubscriptionManagerOptions::setMaximumNumberOfStreams(
+    const int maximumNumberOfStreams)
+{
+    if (maximumNumberOfStreams <= 0)
+    {
+        throw std::invalid_argument(
+            "Maximum number of streams must be positive");
+    }
+    pImpl->mMaximumNumberOfStreams = maximumNumberOfStreams;
+}
+
+int SubscriptionManagerOptions::getMaximumNumberOfStreams() const noexcept
+{
+    return pImpl->mMaximumNumberOfStreams;
+}
+
+/// Shedding policy
+void SubscriptionManagerOptions::setSheddingPolicy(
+    const SheddingPolicy policy) noexcept
+{
+    pImpl->mSheddingPolicy = policy;
+}
+
+SubscriptionManagerOptions::SheddingPolicy
+    SubscriptionManagerOptions::getSheddingPolicy() const noexcept
+{
+    return pImpl->mSheddingPolicy;
+}
+
 /*
 /// Max subscribers
 void SubscriptionManagerOptions::setMaximumNumberOfSubscribers(
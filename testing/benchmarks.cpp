@@ -0,0 +1,187 @@
+#include <cmath>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <bit>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+#include <google/protobuf/util/time_util.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "uDataPacketService/stream.hpp"
+#include "uDataPacketService/streamOptions.hpp"
+#include "uDataPacketService/subscriptionManager.hpp"
+#include "uDataPacketService/subscriptionManagerOptions.hpp"
+#include "uDataPacketService/subscriberHandle.hpp"
+#include "uDataPacketService/duplicatePacketDetector.hpp"
+#include "uDataPacketServiceAPI/v1/packet.pb.h"
+#include "uDataPacketServiceAPI/v1/stream_identifier.pb.h"
+#include "uDataPacketImportAPI/v1/packet.pb.h"
+#include "utilities.hpp"
+
+import PacketConverter;
+
+// Run with, e.g., benchmarks --reporter JSON::out=benchmarks.json to track
+// regressions.  The runBenchmarks target does exactly this.
+
+namespace
+{
+
+[[nodiscard]] std::shared_ptr<spdlog::logger> makeQuietLogger()
+{
+    auto nullSink = std::make_shared<spdlog::sinks::null_sink_mt> ();
+    auto logger = std::make_shared<spdlog::logger> ("Benchmark", nullSink);
+    logger->set_level(spdlog::level::off);
+    return logger;
+}
+
+/// One packet for each of nStreams streams
+[[nodiscard]] std::vector<UDataPacketServiceAPI::V1::Packet>
+    generateStreamPackets(const int nStreams)
+{
+    std::vector<UDataPacketServiceAPI::V1::Packet> result;
+    result.reserve(nStreams);
+    for (int i = 0; i < nStreams; ++i)
+    {
+        auto packets = ::generatePackets(1, "UU", "S" + std::to_string(i),
+                                         "HHZ", "01");
+        result.push_back(std::move(packets.at(0)));
+    }
+    return result;
+}
+
+}
+
+TEST_CASE("UDataPacketService::Stream", "[benchmark][stream]")
+{
+    using namespace UDataPacketService;
+    StreamOptions options;
+    auto packet = ::generatePackets(1).at(0);
+
+    auto copy = packet;
+    Stream stream{std::move(copy), options};
+    BENCHMARK("setNextPacket")
+    {
+        stream.setNextPacket(packet);
+    };
+    auto sharedPacket
+        = std::make_shared<const UDataPacketServiceAPI::V1::Packet> (packet);
+    BENCHMARK("setNextPacket shared")
+    {
+        stream.setNextPacket(sharedPacket);
+    };
+}
+
+TEST_CASE("UDataPacketService::SubscriptionManager",
+          "[benchmark][subscriptionManager]")
+{
+    using namespace UDataPacketService;
+    SubscriptionManagerOptions options;
+    auto logger = ::makeQuietLogger();
+
+    SECTION("enqueuePacket")
+    {
+        for (const int nStreams : {100, 1000, 10000})
+        {
+            auto packets = ::generateStreamPackets(nStreams);
+            SubscriptionManager subscriptionManager{options, logger};
+            for (const auto &packet : packets)
+            {
+                subscriptionManager.enqueuePacket(packet);
+            }
+            BENCHMARK_ADVANCED("enqueuePacket with "
+                             + std::to_string(nStreams) + " streams")
+                (Catch::Benchmark::Chronometer meter)
+            {
+                meter.measure([&](const int i)
+                {
+                    subscriptionManager.enqueuePacket(
+                        packets[i % nStreams]);
+                });
+            };
+        }
+    }
+
+    SECTION("getPackets subscribe to all")
+    {
+        for (const int nStreams : {100, 1000})
+        {
+            auto packets = ::generateStreamPackets(nStreams);
+            SubscriptionManager subscriptionManager{options, logger};
+            for (const auto &packet : packets)
+            {
+                subscriptionManager.enqueuePacket(packet);
+            }
+            auto handle = subscriptionManager.createSubscriber();
+            subscriptionManager.subscribeToAll(handle);
+            // This is what a reactor does when there's nothing to send
+            BENCHMARK("idle getPackets with "
+                    + std::to_string(nStreams) + " streams")
+            {
+                return subscriptionManager.getPackets(handle);
+            };
+            BENCHMARK("enqueue and getPackets with "
+                    + std::to_string(nStreams) + " streams")
+            {
+                for (const auto &packet : packets)
+                {
+                    subscriptionManager.enqueuePacket(packet);
+                }
+                return subscriptionManager.getPackets(handle);
+            };
+            subscriptionManager.unsubscribeFromAll(handle);
+        }
+    }
+}
+
+TEST_CASE("UDataPacketService::PacketConverter",
+          "[benchmark][packetConverter]")
+{
+    std::vector<int> data(250);
+    for (int i = 0; i < static_cast<int> (data.size()); ++i){data[i] = i;}
+
+    UDataPacketImportAPI::V1::StreamIdentifier importIdentifier;
+    importIdentifier.set_network("Uu");
+    importIdentifier.set_station("CwU");
+    importIdentifier.set_channel("HHz");
+    importIdentifier.set_location_code("01");
+
+    UDataPacketImportAPI::V1::Packet importPacket;
+    *importPacket.mutable_stream_identifier() = importIdentifier;
+    *importPacket.mutable_start_time()
+        = google::protobuf::util::TimeUtil::NanosecondsToTimestamp(
+             1769631059123321000);
+    importPacket.set_sampling_rate(100);
+    importPacket.set_number_of_samples(data.size());
+    importPacket.set_data_type(
+        UDataPacketImportAPI::V1::DataType::DATA_TYPE_INTEGER_32);
+    importPacket.set_data(::pack(data));
+
+    BENCHMARK_ADVANCED("convert")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<UDataPacketImportAPI::V1::Packet>
+            inputs(meter.runs(), importPacket);
+        meter.measure([&](const int i)
+        {
+            return UDataPacketService::convert(std::move(inputs[i]));
+        });
+    };
+}
+
+TEST_CASE("UDataPacketService::DuplicatePacketDetector",
+          "[benchmark][duplicatePacketDetector]")
+{
+    using namespace UDataPacketService;
+    constexpr int nPackets{1000};
+    auto packets = ::generatePackets(nPackets);
+
+    DuplicatePacketDetectorOptions options;
+    DuplicatePacketDetector detector{options};
+    BENCHMARK_ADVANCED("allow")(Catch::Benchmark::Chronometer meter)
+    {
+        meter.measure([&](const int i)
+        {
+            return detector.allow(packets[i % nPackets]);
+        });
+    };
+}
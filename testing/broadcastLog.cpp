@@ -0,0 +1,191 @@
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <google/protobuf/util/time_util.h>
+#include <catch2/catch_test_macros.hpp>
+#include "uDataPacketService/broadcastLog.hpp"
+#include "uDataPacketServiceAPI/v1/packet.pb.h"
+#include "uDataPacketServiceAPI/v1/stream_identifier.pb.h"
+#include "utilities.hpp"
+
+import MemoryBudget;
+
+TEST_CASE("UDataPacketService", "[BroadcastLog]")
+{
+    using namespace UDataPacketService;
+    constexpr int capacity{8};
+    auto packets = ::generatePackets(20);
+    std::vector<std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>>
+        packetsRead;
+
+    SECTION("Append and read")
+    {
+        BroadcastLog log{capacity};
+        REQUIRE(log.getCapacity() == capacity);
+        REQUIRE(log.getMaximumNumberOfPackets() == capacity);
+        REQUIRE_FALSE(log.getMaximumBytes().has_value());
+        int64_t bytes{0};
+        for (int i = 0; i < 5; ++i)
+        {
+            bytes = bytes + static_cast<int64_t> (packets.at(i).ByteSizeLong());
+            log.append(packets.at(i));
+        }
+        REQUIRE(log.getHead() == 5);
+        REQUIRE(log.getBytes() == bytes);
+        uint64_t cursor{0};
+        REQUIRE(log.getLag(cursor) == 5);
+        REQUIRE(log.read(cursor, 3, packetsRead) == 0);
+        REQUIRE(cursor == 3);
+        REQUIRE(log.read(cursor, 100, packetsRead) == 0);
+        REQUIRE(cursor == 5);
+        REQUIRE(log.getLag(cursor) == 0);
+        REQUIRE(packetsRead.size() == 5);
+        for (int i = 0; i < 5; ++i)
+        {
+            REQUIRE(::comparePacket(*packetsRead.at(i), packets.at(i)));
+        }
+    }
+
+    SECTION("Lapped reader")
+    {
+        BroadcastLog log{capacity};
+        for (const auto &packet : packets){log.append(packet);}
+        uint64_t cursor{0};
+        auto nDropped = log.read(cursor, 100, packetsRead);
+        REQUIRE(nDropped == static_cast<int64_t> (packets.size()) - capacity);
+        REQUIRE(packetsRead.size() == capacity);
+        REQUIRE(::comparePacket(*packetsRead.back(), packets.back()));
+    }
+
+    SECTION("Shrinking the packet bound trims immediately")
+    {
+        BroadcastLog log{capacity};
+        for (int i = 0; i < capacity; ++i){log.append(packets.at(i));}
+        log.setMaximumNumberOfPackets(2);
+        REQUIRE(log.getMaximumNumberOfPackets() == 2);
+        REQUIRE(log.getBytes() ==
+                static_cast<int64_t> (packets.at(capacity - 2).ByteSizeLong()
+                                    + packets.at(capacity - 1).ByteSizeLong()));
+        uint64_t cursor{0};
+        REQUIRE(log.getLag(cursor) == 2);
+        REQUIRE(log.read(cursor, 100, packetsRead) == capacity - 2);
+        REQUIRE(packetsRead.size() == 2);
+        REQUIRE(::comparePacket(*packetsRead.back(),
+                                packets.at(capacity - 1)));
+    }
+
+    SECTION("Byte bound retains the newest packet")
+    {
+        BroadcastLog log{capacity};
+        for (int i = 0; i < 4; ++i){log.append(packets.at(i));}
+        // Shrinking the bound trims more than one packet at once
+        log.setMaximumBytes(1);
+        REQUIRE(log.getMaximumBytes().has_value());
+        REQUIRE(*log.getMaximumBytes() == 1);
+        REQUIRE(log.getBytes() ==
+                static_cast<int64_t> (packets.at(3).ByteSizeLong()));
+        log.append(packets.at(4));
+        REQUIRE(log.getBytes() ==
+                static_cast<int64_t> (packets.at(4).ByteSizeLong()));
+        uint64_t cursor{0};
+        REQUIRE(log.read(cursor, 100, packetsRead) == 4);
+        REQUIRE(packetsRead.size() == 1);
+        REQUIRE(::comparePacket(*packetsRead.back(), packets.at(4)));
+    }
+
+    SECTION("Ring grows to the packet bound")
+    {
+        auto &memoryBudget = MemoryBudget::getInstance();
+        auto bytesBefore = memoryBudget.getBytes();
+        int64_t ringBytes{0};
+        {
+        BroadcastLog log{2};
+        // The ring's slots are charged
+        ringBytes = memoryBudget.getBytes() - bytesBefore;
+        REQUIRE(ringBytes > 0);
+        log.setMaximumNumberOfPackets(capacity);
+        // It only grows once it fills
+        REQUIRE(log.getCapacity() == 2);
+        for (int i = 0; i < 2; ++i){log.append(packets.at(i));}
+        REQUIRE(log.getCapacity() == 2);
+        uint64_t cursor{0};
+        REQUIRE(log.read(cursor, 1, packetsRead) == 0);
+        for (int i = 2; i < capacity; ++i){log.append(packets.at(i));}
+        REQUIRE(log.getCapacity() == capacity);
+        REQUIRE(log.getLag(cursor) == capacity - 1);
+        // The packets appended before the growth moved to the new ring
+        REQUIRE(log.read(cursor, 100, packetsRead) == 0);
+        REQUIRE(packetsRead.size() == capacity);
+        for (int i = 0; i < capacity; ++i)
+        {
+            REQUIRE(::comparePacket(*packetsRead.at(i), packets.at(i)));
+        }
+        // Once at the bound the ring is lapped as usual
+        log.append(packets.at(capacity));
+        REQUIRE(log.getCapacity() == capacity);
+        REQUIRE(memoryBudget.getBytes() > bytesBefore + ringBytes);
+        }
+        packetsRead.clear();
+        REQUIRE(memoryBudget.getBytes() == bytesBefore);
+    }
+
+    SECTION("Invalid bounds")
+    {
+        REQUIRE_THROWS(BroadcastLog {0});
+        BroadcastLog log{capacity};
+        REQUIRE_THROWS(log.setMaximumNumberOfPackets(0));
+        REQUIRE_THROWS(log.setMaximumBytes(0));
+    }
+}
+
+TEST_CASE("UDataPacketService", "[BroadcastLogConcurrentReader]")
+{
+    using namespace UDataPacketService;
+    constexpr int capacity{16};
+    constexpr int nPackets{20000};
+    auto packets = ::generatePackets(capacity);
+    BroadcastLog log{capacity};
+
+    // One publisher and one reader.  Every packet must be either read in
+    // order or reported as dropped.
+    std::atomic<bool> done{false};
+    int64_t nRead{0};
+    int64_t nDropped{0};
+    bool inOrder{true};
+    std::thread reader([&]()
+    {
+        std::vector<std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>>
+            packetsRead;
+        uint64_t cursor{0};
+        while (true)
+        {
+            auto finished = done.load();
+            packetsRead.clear();
+            auto cursorBefore = cursor;
+            auto dropped = log.read(cursor, 4, packetsRead);
+            if (cursor - cursorBefore !=
+                static_cast<uint64_t> (dropped) + packetsRead.size())
+            {
+                inOrder = false;
+            }
+            for (const auto &packet : packetsRead)
+            {
+                if (packet == nullptr){inOrder = false;}
+            }
+            nRead = nRead + static_cast<int64_t> (packetsRead.size());
+            nDropped = nDropped + dropped;
+            if (finished && cursor == log.getHead()){break;}
+        }
+    });
+    for (int i = 0; i < nPackets; ++i)
+    {
+        log.append(packets.at(i%capacity));
+    }
+    done = true;
+    reader.join();
+    REQUIRE(inOrder);
+    REQUIRE(nRead + nDropped == nPackets);
+    REQUIRE(log.getHead() == nPackets);
+}
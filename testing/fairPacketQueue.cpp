@@ -0,0 +1,153 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <google/protobuf/util/time_util.h>
+#include <catch2/catch_test_macros.hpp>
+#include "uDataPacketService/fairPacketQueue.hpp"
+#include "uDataPacketServiceAPI/v1/packet.pb.h"
+#include "uDataPacketServiceAPI/v1/stream_identifier.pb.h"
+#include "utilities.hpp"
+
+TEST_CASE("UDataPacketService", "[fairPacketQueue]")
+{
+    using namespace UDataPacketService;
+    const std::string network{"UU"};
+    const std::string station{"CTU"};
+    const std::string locationCode{"01"};
+    constexpr int nBackfillPackets{6};
+    constexpr int nRealTimePackets{2};
+    auto backfillPackets
+        = ::generatePackets(nBackfillPackets, network, station,
+                            "HHZ", locationCode);
+    auto realTimePackets
+        = ::generatePackets(nRealTimePackets, network, station,
+                            "HHN", locationCode);
+    int quantum{0};
+    for (const auto &packet : backfillPackets)
+    {
+        quantum = std::max(quantum, static_cast<int> (packet.ByteSizeLong()));
+    }
+    for (const auto &packet : realTimePackets)
+    {
+        quantum = std::max(quantum, static_cast<int> (packet.ByteSizeLong()));
+    }
+    const std::chrono::nanoseconds receivedTime{1};
+
+    REQUIRE_THROWS(FairPacketQueue(0, quantum));
+    REQUIRE_THROWS(FairPacketQueue(1, 0));
+
+    SECTION("RoundRobin")
+    {
+        FairPacketQueue queue{128, quantum};
+        // The backfill arrives first but can't starve the real-time stream
+        for (auto packet : backfillPackets)
+        {
+            queue.push(std::move(packet), receivedTime);
+        }
+        for (auto packet : realTimePackets)
+        {
+            queue.push(std::move(packet), receivedTime);
+        }
+        REQUIRE(queue.size() == nBackfillPackets + nRealTimePackets);
+        REQUIRE(queue.getNumberOfStreams() == 2);
+        std::vector<UDataPacketServiceAPI::V1::Packet> backfillBack;
+        std::vector<UDataPacketServiceAPI::V1::Packet> realTimeBack;
+        UDataPacketServiceAPI::V1::Packet packet;
+        std::chrono::nanoseconds timeBack{0};
+        int nPopped{0};
+        int lastRealTimePosition{-1};
+        while (queue.tryPop(packet, timeBack))
+        {
+            REQUIRE(timeBack == receivedTime);
+            if (packet.stream_identifier().channel() == "HHN")
+            {
+                realTimeBack.push_back(packet);
+                lastRealTimePosition = nPopped;
+            }
+            else
+            {
+                backfillBack.push_back(packet);
+            }
+            nPopped = nPopped + 1;
+        }
+        REQUIRE(queue.size() == 0);
+        REQUIRE(queue.getNumberOfStreams() == 0);
+        // Each stream's packets are in order
+        REQUIRE(backfillBack.size() == backfillPackets.size());
+        REQUIRE(::comparePackets(backfillBack, backfillPackets, false));
+        REQUIRE(realTimeBack.size() == realTimePackets.size());
+        REQUIRE(::comparePackets(realTimeBack, realTimePackets, false));
+        // First in, first out would put these last
+        REQUIRE(lastRealTimePosition < 2*nRealTimePackets + 1);
+        REQUIRE(queue.getNumberOfDroppedPackets() == 0);
+    }
+
+    SECTION("Overflow")
+    {
+        constexpr int capacity{4};
+        FairPacketQueue queue{capacity, quantum};
+        for (int i = 0; i < capacity; ++i)
+        {
+            auto packet = backfillPackets.at(i);
+            queue.push(std::move(packet), receivedTime);
+        }
+        // The backfill pays for the new stream
+        auto packet = realTimePackets.at(0);
+        queue.push(std::move(packet), receivedTime);
+        REQUIRE(queue.size() == capacity);
+        REQUIRE(queue.getNumberOfStreams() == 2);
+        REQUIRE(queue.getNumberOfDroppedPackets() == 1);
+        std::vector<UDataPacketServiceAPI::V1::Packet> packetsBack;
+        std::chrono::nanoseconds timeBack{0};
+        while (queue.tryPop(packet, timeBack))
+        {
+            packetsBack.push_back(packet);
+        }
+        REQUIRE(packetsBack.size() == capacity);
+        std::vector<UDataPacketServiceAPI::V1::Packet> expectedPackets
+        {
+            backfillPackets.at(1), backfillPackets.at(2),
+            backfillPackets.at(3), realTimePackets.at(0)
+        };
+        REQUIRE(::comparePackets(packetsBack, expectedPackets, true));
+    }
+
+    SECTION("Lanes")
+    {
+        constexpr int capacity{4};
+        FairPacketQueue queue{capacity, quantum};
+        for (int i = 0; i < 3; ++i)
+        {
+            auto packet = backfillPackets.at(i);
+            queue.push(std::move(packet), receivedTime,
+                       FairPacketQueue::Lane::Backfill);
+        }
+        for (const auto &realTimePacket : realTimePackets)
+        {
+            auto packet = realTimePacket;
+            queue.push(std::move(packet), receivedTime,
+                       FairPacketQueue::Lane::RealTime);
+        }
+        // The backfill pays for the overflow
+        REQUIRE(queue.size() == capacity);
+        REQUIRE(queue.size(FairPacketQueue::Lane::RealTime) == 2);
+        REQUIRE(queue.size(FairPacketQueue::Lane::Backfill) == 2);
+        REQUIRE(queue.getNumberOfDroppedPackets() == 1);
+        // Real-time packets come out first
+        std::vector<UDataPacketServiceAPI::V1::Packet> packetsBack;
+        UDataPacketServiceAPI::V1::Packet packet;
+        std::chrono::nanoseconds timeBack{0};
+        while (queue.tryPop(packet, timeBack))
+        {
+            packetsBack.push_back(packet);
+        }
+        std::vector<UDataPacketServiceAPI::V1::Packet> expectedPackets
+        {
+            realTimePackets.at(0), realTimePackets.at(1),
+            backfillPackets.at(1), backfillPackets.at(2)
+        };
+        REQUIRE(::comparePackets(packetsBack, expectedPackets, false));
+        REQUIRE(queue.size(FairPacketQueue::Lane::Backfill) == 0);
+    }
+}
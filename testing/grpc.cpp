@@ -9,6 +9,7 @@
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 #include "uDataPacketService/grpcClientOptions.hpp"
 #include "uDataPacketService/grpcServerOptions.hpp"
+#include "uDataPacketService/subscriberOptions.hpp"
 
 TEST_CASE("UDataPacketService", "[grpcClientOptions]")
 {
@@ -21,6 +22,12 @@ TEST_CASE("UDataPacketService", "[grpcClientOptions]")
         REQUIRE(options.getServerCertificate() == std::nullopt);
         REQUIRE(options.getClientCertificate() == std::nullopt);
         REQUIRE(options.getClientKey() == std::nullopt);
+        REQUIRE(options.getKeepAliveTime() == std::nullopt);
+        REQUIRE(options.getKeepAliveTimeout() == std::chrono::seconds {20});
+        REQUIRE(options.getMaximumReceiveMessageSize() == 4*1024*1024);
+        REQUIRE(options.getHTTP2InitialWindowSize() == std::nullopt);
+        REQUIRE(options.isBDPProbeEnabled());
+        REQUIRE(!options.useDedicatedConnection());
     }
 
     SECTION("Options")
@@ -47,6 +54,54 @@ TEST_CASE("UDataPacketService", "[grpcClientOptions]")
         REQUIRE(*options.getClientCertificate() == clientCertificate);
         REQUIRE(*options.getClientKey() == clientKey);
     }
+
+    SECTION("Channel Tuning")
+    {
+        const std::chrono::milliseconds keepAliveTime{30000};
+        const std::chrono::milliseconds keepAliveTimeout{5000};
+        constexpr int maximumMessageSize{16*1024*1024};
+        constexpr int windowSize{8*1024*1024};
+        UDataPacketService::GRPCClientOptions options;
+
+        options.setKeepAliveTime(keepAliveTime);
+        options.setKeepAliveTimeout(keepAliveTimeout);
+        options.setMaximumReceiveMessageSize(maximumMessageSize);
+        options.setHTTP2InitialWindowSize(windowSize);
+        options.enableBDPProbe(false);
+        options.useDedicatedConnection(true);
+
+        REQUIRE(*options.getKeepAliveTime() == keepAliveTime);
+        REQUIRE(options.getKeepAliveTimeout() == keepAliveTimeout);
+        REQUIRE(options.getMaximumReceiveMessageSize() == maximumMessageSize);
+        REQUIRE(*options.getHTTP2InitialWindowSize() == windowSize);
+        REQUIRE(!options.isBDPProbeEnabled());
+        REQUIRE(options.useDedicatedConnection());
+        REQUIRE_THROWS(options.setKeepAliveTime(std::chrono::milliseconds {0}));
+        REQUIRE_THROWS(options.setHTTP2InitialWindowSize(0));
+    }
+}
+
+TEST_CASE("UDataPacketService", "[subscriberOptions]")
+{
+    UDataPacketService::GRPCClientOptions primary;
+    primary.setHost("proxy1.domain.org");
+    UDataPacketService::GRPCClientOptions replica;
+    replica.setHost("proxy2.domain.org");
+
+    UDataPacketService::SubscriberOptions options;
+    options.setGRPCOptions(primary);
+    REQUIRE(options.getNumberOfStreams() == 1);
+    REQUIRE(options.getGRPCOptions(0).getHost() == primary.getHost());
+    REQUIRE_THROWS(options.getGRPCOptions(1));
+    REQUIRE_THROWS(options.setNumberOfStreams(0));
+
+    // Streams alternate between the primary and the replica
+    options.setReplicaGRPCOptions(std::vector {replica});
+    options.setNumberOfStreams(3);
+    REQUIRE(options.getReplicaGRPCOptions().size() == 1);
+    REQUIRE(options.getGRPCOptions(0).getHost() == primary.getHost());
+    REQUIRE(options.getGRPCOptions(1).getHost() == replica.getHost());
+    REQUIRE(options.getGRPCOptions(2).getHost() == primary.getHost());
 }
 
 TEST_CASE("UDataPacketService", "[grpcServerOptions]")
@@ -60,6 +115,14 @@ TEST_CASE("UDataPacketService", "[grpcServerOptions]")
         REQUIRE(options.getServerCertificate() == std::nullopt);
         REQUIRE(options.getServerKey() == std::nullopt);
         REQUIRE(options.getClientCertificate() == std::nullopt);
+        REQUIRE(options.getMemoryQuota() == std::nullopt);
+        REQUIRE(options.getMaximumReceiveMessageSize() == std::nullopt);
+        REQUIRE(options.getMaximumSendMessageSize() == std::nullopt);
+        REQUIRE(options.getHTTP2WriteBufferSize() == std::nullopt);
+        REQUIRE(options.getMaximumConcurrentStreams() == std::nullopt);
+        REQUIRE(options.getKeepAliveTime() == std::nullopt);
+        REQUIRE(options.getMinimumClientPingInterval() == std::nullopt);
+        REQUIRE(options.permitKeepAliveWithoutCalls() == std::nullopt);
     }   
 
     SECTION("Options")
@@ -87,5 +150,35 @@ TEST_CASE("UDataPacketService", "[grpcServerOptions]")
         REQUIRE(*options.getClientCertificate() == clientCertificate);
     }   
 
+    SECTION("Server Tuning")
+    {
+        constexpr int64_t memoryQuota{512*1024*1024};
+        constexpr int messageSize{1024*1024};
+        constexpr int writeBufferSize{256*1024};
+        constexpr int nStreams{100};
+        const std::chrono::milliseconds keepAliveTime{60000};
+        const std::chrono::milliseconds pingInterval{10000};
+        UDataPacketService::GRPCServerOptions options;
+
+        options.setMemoryQuota(memoryQuota);
+        options.setMaximumReceiveMessageSize(messageSize);
+        options.setMaximumSendMessageSize(messageSize);
+        options.setHTTP2WriteBufferSize(writeBufferSize);
+        options.setMaximumConcurrentStreams(nStreams);
+        options.setKeepAliveTime(keepAliveTime);
+        options.setMinimumClientPingInterval(pingInterval);
+        options.permitKeepAliveWithoutCalls(true);
+
+        REQUIRE(*options.getMemoryQuota() == memoryQuota);
+        REQUIRE(*options.getMaximumReceiveMessageSize() == messageSize);
+        REQUIRE(*options.getMaximumSendMessageSize() == messageSize);
+        REQUIRE(*options.getHTTP2WriteBufferSize() == writeBufferSize);
+        REQUIRE(*options.getMaximumConcurrentStreams() == nStreams);
+        REQUIRE(*options.getKeepAliveTime() == keepAliveTime);
+        REQUIRE(*options.getMinimumClientPingInterval() == pingInterval);
+        REQUIRE(*options.permitKeepAliveWithoutCalls());
+        REQUIRE_THROWS(options.setMaximumReceiveMessageSize(0));
+        REQUIRE_THROWS(options.setMemoryQuota(0));
+    }
 }
 
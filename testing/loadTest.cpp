@@ -0,0 +1,608 @@
+// End-to-end load generator.  A fake import proxy backend emits synthetic
+// packets, the real service pipeline relays them, and K broadcast clients
+// measure end-to-end latency and drops.  Everything runs over localhost.
+//
+// Example usage:
+//
+//     loadtest --streams=1000 --rate=1 --samples=100 \
+//              --subscribe-to-all-clients=2 --subscribe-clients=16 \
+//              --selections=20 --duration=60
+import ProgramOptions;
+import Metrics;
+import Process;
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <bit>
+#include <mutex>
+#include <condition_variable>
+#include <boost/program_options.hpp>
+#include <google/protobuf/util/time_util.h>
+#include <grpcpp/grpcpp.h>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "uDataPacketService/serverOptions.hpp"
+#include "uDataPacketService/subscriberOptions.hpp"
+#include "uDataPacketService/grpcServerOptions.hpp"
+#include "uDataPacketService/grpcClientOptions.hpp"
+#include "uDataPacketImportAPI/v1/packet.pb.h"
+#include "uDataPacketImportAPI/v1/backend.grpc.pb.h"
+#include "uDataPacketServiceAPI/v1/packet.pb.h"
+#include "uDataPacketServiceAPI/v1/broadcast.grpc.pb.h"
+#include "utilities.hpp"
+
+namespace
+{
+
+struct LoadTestOptions
+{
+    std::string host{"localhost"};
+    std::chrono::seconds duration{30};
+    std::chrono::seconds warmUp{2};
+    double packetsPerSecond{1}; // Per stream
+    int nStreams{100};
+    int samplesPerPacket{100};
+    int nSubscribeToAllClients{1};
+    int nSubscribeClients{4};
+    int selectionsPerClient{10};
+    uint16_t backendPort{50100};
+    uint16_t servicePort{50101};
+};
+
+[[nodiscard]] std::string toStation(const int iStream)
+{
+    return "S" + std::to_string(iStream);
+}
+
+[[nodiscard]] std::chrono::nanoseconds getNowNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>
+           ((std::chrono::system_clock::now()).time_since_epoch());
+}
+
+///--------------------------------------------------------------------------///
+///                                 Histogram                                ///
+///--------------------------------------------------------------------------///
+
+/// A latency histogram with power-of-two microsecond buckets.  Each client
+/// owns one and only updates it from its read callback so it needn't be
+/// synchronized.
+class LatencyHistogram
+{
+public:
+    void record(const int64_t latencyMicroSeconds)
+    {
+        auto value = static_cast<uint64_t> (std::max<int64_t> (0, latencyMicroSeconds));
+        auto bucket = static_cast<size_t> (std::bit_width(value));
+        mCounts[std::min(bucket, mCounts.size() - 1)]++;
+        mMaximum = std::max(mMaximum, value);
+        mCount++;
+    }
+    void merge(const LatencyHistogram &other)
+    {
+        for (size_t i = 0; i < mCounts.size(); ++i)
+        {
+            mCounts[i] += other.mCounts[i];
+        }
+        mMaximum = std::max(mMaximum, other.mMaximum);
+        mCount += other.mCount;
+    }
+    /// @result The upper bound of the bucket holding the q'th quantile.
+    [[nodiscard]] uint64_t getQuantile(const double q) const
+    {
+        if (mCount == 0){return 0;}
+        auto target = static_cast<uint64_t> (std::ceil(q*mCount));
+        uint64_t cumulative{0};
+        for (size_t i = 0; i < mCounts.size(); ++i)
+        {
+            cumulative += mCounts[i];
+            if (cumulative >= target)
+            {
+                auto upperBound = i == 0 ? 0 : (uint64_t {1} << i) - 1;
+                return std::min(upperBound, mMaximum);
+            }
+        }
+        return mMaximum;
+    }
+    [[nodiscard]] uint64_t getMaximum() const noexcept{return mMaximum;}
+    [[nodiscard]] uint64_t getCount() const noexcept{return mCount;}
+private:
+    std::array<uint64_t, 64> mCounts{};
+    uint64_t mMaximum{0};
+    uint64_t mCount{0};
+};
+
+///--------------------------------------------------------------------------///
+///                                Fake Backend                              ///
+///--------------------------------------------------------------------------///
+
+/// Emits packets for all streams at a fixed rate.  Stream s's n'th packet
+/// ends at t0 + n/rate + (s + 1)/(nStreams*rate) which is also when it is
+/// written.  Hence, a packet's end time is its emission time and each
+/// stream's packets are contiguous.
+class PacketGenerator :
+    public grpc::ServerWriteReactor<UDataPacketImportAPI::V1::Packet>
+{
+public:
+    PacketGenerator(grpc::CallbackServerContext *context,
+                    const LoadTestOptions &options,
+                    std::atomic<bool> *keepRunning) :
+        mContext(context),
+        mOptions(options),
+        mKeepRunning(keepRunning)
+    {
+        mSamplingRate = mOptions.samplesPerPacket*mOptions.packetsPerSecond;
+        mPacketDuration
+            = std::chrono::nanoseconds {static_cast<int64_t> (
+                 std::round(1.e9/mOptions.packetsPerSecond))};
+        mEmissionInterval = mPacketDuration/mOptions.nStreams;
+        mStartTime = ::getNowNanoseconds();
+        std::vector<int> data(mOptions.samplesPerPacket);
+        for (int i = 0; i < static_cast<int> (data.size()); ++i){data[i] = i;}
+        mPackedData = ::pack(data);
+        nextWrite();
+    }
+    void OnWriteDone(bool ok) override
+    {
+        if (!ok)
+        {
+            Finish(grpc::Status {grpc::StatusCode::UNAVAILABLE,
+                                 "Failed to write packet"});
+            return;
+        }
+        nextWrite();
+    }
+    void OnDone() override
+    {
+        delete this;
+    }
+private:
+    void nextWrite()
+    {
+        while (mKeepRunning->load())
+        {
+            if (mContext->IsCancelled())
+            {
+                Finish(grpc::Status::CANCELLED);
+                return;
+            }
+            auto emissionTime
+                = mStartTime + mEmissionInterval*(mPacketsWritten + 1);
+            auto now = ::getNowNanoseconds();
+            if (now >= emissionTime)
+            {
+                auto iStream = static_cast<int> (mPacketsWritten % mOptions.nStreams);
+                auto startTime = emissionTime - mPacketDuration;
+                mPacket.Clear();
+                auto identifier = mPacket.mutable_stream_identifier();
+                identifier->set_network("LT");
+                identifier->set_station(::toStation(iStream));
+                identifier->set_channel("HHZ");
+                identifier->set_location_code("01");
+                *mPacket.mutable_start_time()
+                    = google::protobuf::util::TimeUtil::NanosecondsToTimestamp(
+                         startTime.count());
+                mPacket.set_sampling_rate(mSamplingRate);
+                mPacket.set_number_of_samples(mOptions.samplesPerPacket);
+                mPacket.set_data_type(
+                    UDataPacketImportAPI::V1::DataType::DATA_TYPE_INTEGER_32);
+                mPacket.set_data(mPackedData);
+                mPacketsWritten++;
+                StartWrite(&mPacket);
+                return;
+            }
+            std::this_thread::sleep_for(
+                std::min<std::chrono::nanoseconds>
+                   (emissionTime - now, std::chrono::milliseconds {1}));
+        }
+        Finish(grpc::Status::OK);
+    }
+    grpc::CallbackServerContext *mContext{nullptr};
+    LoadTestOptions mOptions;
+    std::atomic<bool> *mKeepRunning{nullptr};
+    UDataPacketImportAPI::V1::Packet mPacket;
+    std::string mPackedData;
+    std::chrono::nanoseconds mStartTime;
+    std::chrono::nanoseconds mPacketDuration;
+    std::chrono::nanoseconds mEmissionInterval;
+    double mSamplingRate{100};
+    int64_t mPacketsWritten{0};
+};
+
+class FakeBackend final :
+    public UDataPacketImportAPI::V1::Backend::CallbackService
+{
+public:
+    explicit FakeBackend(const LoadTestOptions &options) :
+        mOptions(options)
+    {
+    }
+    ~FakeBackend() override
+    {
+        stop();
+    }
+    void start()
+    {
+        mKeepRunning.store(true);
+        auto address = "0.0.0.0:" + std::to_string(mOptions.backendPort);
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort(address, grpc::InsecureServerCredentials());
+        builder.RegisterService(this);
+        mServer = builder.BuildAndStart();
+        if (mServer == nullptr)
+        {
+            throw std::runtime_error("Failed to start fake backend at "
+                                   + address);
+        }
+    }
+    void stop()
+    {
+        mKeepRunning.store(false);
+        if (mServer)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds {15});
+            mServer->Shutdown();
+            mServer.reset();
+        }
+    }
+    grpc::ServerWriteReactor<UDataPacketImportAPI::V1::Packet> *
+        Subscribe(grpc::CallbackServerContext *context,
+                  const UDataPacketImportAPI::V1::SubscriptionRequest *) override
+    {
+        return new PacketGenerator(context, mOptions, &mKeepRunning);
+    }
+private:
+    LoadTestOptions mOptions;
+    std::unique_ptr<grpc::Server> mServer{nullptr};
+    std::atomic<bool> mKeepRunning{true};
+};
+
+///--------------------------------------------------------------------------///
+///                                 Clients                                  ///
+///--------------------------------------------------------------------------///
+
+/// Records end-to-end latency and infers drops from gaps in each stream.
+class LoadClient final :
+    public grpc::ClientReadReactor<UDataPacketServiceAPI::V1::Packet>
+{
+public:
+    LoadClient(UDataPacketServiceAPI::V1::Broadcast::Stub *stub,
+               const UDataPacketServiceAPI::V1::SubscribeToAllRequest &request,
+               const std::chrono::nanoseconds &measureAfter) :
+        mSubscribeToAllRequest(request),
+        mMeasureAfter(measureAfter)
+    {
+        mContext.set_wait_for_ready(true);
+        stub->async()->SubscribeToAll(&mContext, &mSubscribeToAllRequest, this);
+        StartRead(&mPacket);
+        StartCall();
+    }
+    LoadClient(UDataPacketServiceAPI::V1::Broadcast::Stub *stub,
+               const UDataPacketServiceAPI::V1::SubscriptionRequest &request,
+               const std::chrono::nanoseconds &measureAfter) :
+        mSubscriptionRequest(request),
+        mMeasureAfter(measureAfter)
+    {
+        mContext.set_wait_for_ready(true);
+        stub->async()->Subscribe(&mContext, &mSubscriptionRequest, this);
+        StartRead(&mPacket);
+        StartCall();
+    }
+    void OnReadDone(bool ok) override
+    {
+        if (!ok){return;}
+        auto now = ::getNowNanoseconds();
+        auto startTime
+            = std::chrono::nanoseconds
+              {google::protobuf::util::TimeUtil::TimestampToNanoseconds(
+                  mPacket.start_time())};
+        auto duration
+            = std::chrono::nanoseconds {static_cast<int64_t> (std::round(
+                 1.e9*mPacket.number_of_samples()/mPacket.sampling_rate()))};
+        auto endTime = startTime + duration;
+        auto &expectedStartTime = mExpectedStartTimes[mPacket.stream_identifier().station()];
+        if (now > mMeasureAfter)
+        {
+            mHistogram.record(
+                std::chrono::duration_cast<std::chrono::microseconds>
+                   (now - endTime).count());
+            mPacketsReceived++;
+            // A gap in the stream means we lost packets
+            if (expectedStartTime.count() > 0 &&
+                startTime > expectedStartTime + duration/2)
+            {
+                mPacketsDropped
+                    += static_cast<int64_t> (std::round(
+                          static_cast<double> ((startTime - expectedStartTime).count())
+                         /duration.count()));
+            }
+        }
+        expectedStartTime = endTime;
+        StartRead(&mPacket);
+    }
+    void OnDone(const grpc::Status &status) override
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mStatus = status;
+        mDone = true;
+        mConditionVariable.notify_one();
+    }
+    void cancel()
+    {
+        mContext.TryCancel();
+    }
+    [[nodiscard]] grpc::Status await()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mConditionVariable.wait(lock, [this] {return mDone;});
+        return mStatus;
+    }
+    [[nodiscard]] const LatencyHistogram &getHistogram() const noexcept
+    {
+        return mHistogram;
+    }
+    [[nodiscard]] int64_t getPacketsReceived() const noexcept
+    {
+        return mPacketsReceived;
+    }
+    [[nodiscard]] int64_t getPacketsDropped() const noexcept
+    {
+        return mPacketsDropped;
+    }
+private:
+    std::mutex mMutex;
+    std::condition_variable mConditionVariable;
+    grpc::ClientContext mContext;
+    UDataPacketServiceAPI::V1::SubscriptionRequest mSubscriptionRequest;
+    UDataPacketServiceAPI::V1::SubscribeToAllRequest mSubscribeToAllRequest;
+    UDataPacketServiceAPI::V1::Packet mPacket;
+    grpc::Status mStatus;
+    std::map<std::string, std::chrono::nanoseconds> mExpectedStartTimes;
+    LatencyHistogram mHistogram;
+    std::chrono::nanoseconds mMeasureAfter;
+    int64_t mPacketsReceived{0};
+    int64_t mPacketsDropped{0};
+    bool mDone{false};
+};
+
+void summarize(const std::string &label,
+               const std::vector<std::unique_ptr<LoadClient>> &clients,
+               const std::chrono::seconds &duration)
+{
+    if (clients.empty()){return;}
+    LatencyHistogram histogram;
+    int64_t nReceived{0};
+    int64_t nDropped{0};
+    for (const auto &client : clients)
+    {
+        histogram.merge(client->getHistogram());
+        nReceived += client->getPacketsReceived();
+        nDropped += client->getPacketsDropped();
+    }
+    auto seconds = std::max<double> (1, duration.count());
+    std::cout << label << " (" << clients.size() << " clients)" << std::endl
+              << "  Packets received:    " << nReceived
+              << " (" << std::fixed << std::setprecision(1)
+              << nReceived/seconds << " packets/s)" << std::endl
+              << "  Packets dropped:     " << nDropped << std::endl
+              << "  Latency p50 (us):   <= " << histogram.getQuantile(0.5) << std::endl
+              << "  Latency p90 (us):   <= " << histogram.getQuantile(0.9) << std::endl
+              << "  Latency p99 (us):   <= " << histogram.getQuantile(0.99) << std::endl
+              << "  Latency p99.9 (us): <= " << histogram.getQuantile(0.999) << std::endl
+              << "  Latency max (us):      " << histogram.getMaximum() << std::endl;
+}
+
+[[nodiscard]] std::pair<LoadTestOptions, bool>
+    parseCommandLine(int argc, char *argv[])
+{
+    LoadTestOptions options;
+    boost::program_options::options_description desc(R"""(
+The loadtest drives the uDataPacketService pipeline with a synthetic import
+proxy and measures what synthetic subscribers receive.
+
+Example usage is:
+
+    loadtest --streams=1000 --rate=1 --subscribe-clients=16 --duration=60
+
+Allowed options)""");
+    desc.add_options()
+        ("help", "Produces this help message")
+        ("streams",
+         boost::program_options::value<int> ()->default_value(options.nStreams),
+         "The number of synthetic streams")
+        ("rate",
+         boost::program_options::value<double> ()->default_value(options.packetsPerSecond),
+         "The number of packets per second per stream")
+        ("samples",
+         boost::program_options::value<int> ()->default_value(options.samplesPerPacket),
+         "The number of 32-bit samples per packet")
+        ("subscribe-to-all-clients",
+         boost::program_options::value<int> ()->default_value(options.nSubscribeToAllClients),
+         "The number of clients subscribing to all streams")
+        ("subscribe-clients",
+         boost::program_options::value<int> ()->default_value(options.nSubscribeClients),
+         "The number of clients subscribing to selected streams")
+        ("selections",
+         boost::program_options::value<int> ()->default_value(options.selectionsPerClient),
+         "The number of streams each subscribe client selects")
+        ("duration",
+         boost::program_options::value<int> ()->default_value(options.duration.count()),
+         "The measurement duration in seconds")
+        ("backend-port",
+         boost::program_options::value<uint16_t> ()->default_value(options.backendPort),
+         "The fake import backend's port")
+        ("service-port",
+         boost::program_options::value<uint16_t> ()->default_value(options.servicePort),
+         "The service's broadcast port");
+    boost::program_options::variables_map vm;
+    boost::program_options::store(
+        boost::program_options::parse_command_line(argc, argv, desc), vm);
+    boost::program_options::notify(vm);
+    if (vm.count("help"))
+    {
+        std::cout << desc << std::endl;
+        return {options, true};
+    }
+    options.nStreams = vm["streams"].as<int> ();
+    options.packetsPerSecond = vm["rate"].as<double> ();
+    options.samplesPerPacket = vm["samples"].as<int> ();
+    options.nSubscribeToAllClients = vm["subscribe-to-all-clients"].as<int> ();
+    options.nSubscribeClients = vm["subscribe-clients"].as<int> ();
+    options.selectionsPerClient = vm["selections"].as<int> ();
+    options.duration = std::chrono::seconds {vm["duration"].as<int> ()};
+    options.backendPort = vm["backend-port"].as<uint16_t> ();
+    options.servicePort = vm["service-port"].as<uint16_t> ();
+    if (options.nStreams < 1)
+    {
+        throw std::invalid_argument("Number of streams must be positive");
+    }
+    if (options.packetsPerSecond <= 0)
+    {
+        throw std::invalid_argument("Packet rate must be positive");
+    }
+    if (options.samplesPerPacket < 1)
+    {
+        throw std::invalid_argument("Samples per packet must be positive");
+    }
+    if (options.nSubscribeToAllClients < 0 || options.nSubscribeClients < 0)
+    {
+        throw std::invalid_argument("Number of clients cannot be negative");
+    }
+    if (options.nSubscribeToAllClients + options.nSubscribeClients < 1)
+    {
+        throw std::invalid_argument("At least one client is required");
+    }
+    if (options.selectionsPerClient < 1)
+    {
+        throw std::invalid_argument("Selections must be positive");
+    }
+    options.selectionsPerClient
+        = std::min(options.selectionsPerClient, options.nStreams);
+    if (options.duration.count() <= 0)
+    {
+        throw std::invalid_argument("Duration must be positive");
+    }
+    return {options, false};
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    auto logger = spdlog::stdout_color_mt("loadtest");
+    LoadTestOptions options;
+    try
+    {
+        auto [parsedOptions, isHelp] = ::parseCommandLine(argc, argv);
+        if (isHelp){return EXIT_SUCCESS;}
+        options = parsedOptions;
+    }
+    catch (const std::exception &e)
+    {
+        SPDLOG_LOGGER_CRITICAL(logger,
+                               "Failed getting command line options because {}",
+                               std::string {e.what()});
+        return EXIT_FAILURE;
+    }
+
+    // The service under test
+    UDataPacketService::ProgramOptions programOptions;
+    programOptions.applicationName = "uDataPacketServiceLoadTest";
+    programOptions.printSummaryInterval = std::chrono::seconds {0};
+    {
+    UDataPacketService::GRPCClientOptions clientOptions;
+    clientOptions.setHost(options.host);
+    clientOptions.setPort(options.backendPort);
+    programOptions.subscriberOptions.setGRPCOptions(clientOptions);
+
+    UDataPacketService::GRPCServerOptions serverOptions;
+    serverOptions.setHost("0.0.0.0");
+    serverOptions.setPort(options.servicePort);
+    programOptions.serverOptions.setGRPCOptions(serverOptions);
+    programOptions.serverOptions.setMaximumNumberOfSubscribers(
+        options.nSubscribeToAllClients + options.nSubscribeClients);
+    }
+    UDataPacketService::Metrics::initializeMetricsSingleton();
+
+    try
+    {
+        SPDLOG_LOGGER_INFO(logger,
+           "Emitting {} packets/s over {} streams with {} samples per packet",
+           options.nStreams*options.packetsPerSecond,
+           options.nStreams, options.samplesPerPacket);
+        ::FakeBackend backend{options};
+        backend.start();
+
+        auto serviceLogger = spdlog::stdout_color_mt("uDataPacketService");
+        serviceLogger->set_level(spdlog::level::warn);
+        UDataPacketService::Process process(programOptions, serviceLogger);
+        std::thread processThread([&process]()
+        {
+            process.start();
+        });
+
+        // Connect the clients
+        auto address = options.host + ":" + std::to_string(options.servicePort);
+        auto channel = grpc::CreateChannel(address,
+                                           grpc::InsecureChannelCredentials());
+        auto stub = UDataPacketServiceAPI::V1::Broadcast::NewStub(channel);
+        auto measureAfter = ::getNowNanoseconds() + options.warmUp;
+        std::vector<std::unique_ptr<::LoadClient>> subscribeToAllClients;
+        for (int i = 0; i < options.nSubscribeToAllClients; ++i)
+        {
+            UDataPacketServiceAPI::V1::SubscribeToAllRequest request;
+            request.set_identifier("loadtest-all-" + std::to_string(i));
+            subscribeToAllClients.push_back(
+                std::make_unique<::LoadClient> (stub.get(), request,
+                                                measureAfter));
+        }
+        std::vector<std::unique_ptr<::LoadClient>> subscribeClients;
+        for (int i = 0; i < options.nSubscribeClients; ++i)
+        {
+            UDataPacketServiceAPI::V1::SubscriptionRequest request;
+            request.set_identifier("loadtest-some-" + std::to_string(i));
+            for (int j = 0; j < options.selectionsPerClient; ++j)
+            {
+                auto iStream = (i*options.selectionsPerClient + j)
+                             % options.nStreams;
+                *request.add_selections()
+                    = ::toIdentifier("LT", ::toStation(iStream), "HHZ", "01");
+            }
+            subscribeClients.push_back(
+                std::make_unique<::LoadClient> (stub.get(), request,
+                                                measureAfter));
+        }
+        SPDLOG_LOGGER_INFO(logger, "Connected {} clients; running for {} s",
+                           subscribeToAllClients.size()
+                         + subscribeClients.size(),
+                           (options.warmUp + options.duration).count());
+        std::this_thread::sleep_for(options.warmUp + options.duration);
+
+        // Tear it down
+        for (auto &client : subscribeToAllClients){client->cancel();}
+        for (auto &client : subscribeClients){client->cancel();}
+        for (auto &client : subscribeToAllClients){(void) client->await();}
+        for (auto &client : subscribeClients){(void) client->await();}
+        process.requestStop();
+        if (processThread.joinable()){processThread.join();}
+        backend.stop();
+
+        ::summarize("SubscribeToAll", subscribeToAllClients, options.duration);
+        ::summarize("Subscribe", subscribeClients, options.duration);
+    }
+    catch (const std::exception &e)
+    {
+        SPDLOG_LOGGER_CRITICAL(logger, "Load test failed with {}",
+                               std::string {e.what()});
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
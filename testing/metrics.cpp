@@ -0,0 +1,73 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+import Metrics;
+
+TEST_CASE("UDataPacketService::Metrics", "[latencyHistogram]")
+{
+    using namespace UDataPacketService::Metrics;
+    LatencyHistogram histogram;
+
+    SECTION("Empty")
+    {
+        auto summary = histogram.collect();
+        REQUIRE(summary.count == 0);
+        REQUIRE(summary.maximum.count() == 0);
+    }
+
+    SECTION("Quantiles")
+    {
+        // 1, 2, ..., 1000 microseconds
+        for (int i = 1; i <= 1000; ++i)
+        {
+            histogram.record(std::chrono::microseconds {i});
+        }
+        // Clock skew shows up as zero
+        histogram.record(std::chrono::microseconds {-5});
+        auto summary = histogram.collect();
+        REQUIRE(summary.count == 1001);
+        REQUIRE(summary.maximum.count() == 1000);
+        // Buckets are within 12.5 pct and report their upper bound
+        REQUIRE(summary.p50.count() >= 500);
+        REQUIRE(summary.p50.count() <= 500*1.125);
+        REQUIRE(summary.p99.count() >= 990);
+        REQUIRE(summary.p99.count() <= 1000);
+        REQUIRE(summary.p999.count() == 1000);
+        REQUIRE(summary.p90 <= summary.p99);
+        // Collecting resets
+        REQUIRE(histogram.collect().count == 0);
+    }
+
+    SECTION("Small values are exact")
+    {
+        histogram.record(std::chrono::microseconds {3});
+        histogram.record(std::chrono::nanoseconds {3999});
+        auto summary = histogram.collect();
+        REQUIRE(summary.p50.count() == 3);
+        REQUIRE(summary.maximum.count() == 3);
+    }
+}
+
+TEST_CASE("UDataPacketService::Metrics", "[shardedCounter]")
+{
+    using namespace UDataPacketService::Metrics;
+    ShardedCounter counter;
+    constexpr int nThreads{8};
+    constexpr int nIncrements{10000};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nThreads; ++i)
+    {
+        threads.emplace_back([&counter]()
+        {
+            for (int j = 0; j < nIncrements; ++j){counter.increment();}
+        });
+    }
+    for (auto &thread : threads){thread.join();}
+    REQUIRE(counter.load() == nThreads*nIncrements);
+    counter.add(5);
+    REQUIRE(counter.load() == nThreads*nIncrements + 5);
+    counter.reset();
+    REQUIRE(counter.load() == 0);
+}
@@ -4,6 +4,8 @@
 #include <random>
 #include <cmath>
 #include <numeric>
+#include <thread>
+#include <atomic>
 #include <google/protobuf/util/time_util.h>
 #include "uDataPacketService/expiredPacketDetector.hpp"
 #include "uDataPacketService/futurePacketDetector.hpp"
@@ -17,6 +19,7 @@
 #include "utilities.hpp"
 
 import Utilities;
+import MemoryBudget;
 
 using namespace UDataPacketService;
 
@@ -226,6 +229,9 @@ TEST_CASE("UDataPacketService::DuplicatePacketDetector", "[duplicateData]")
         DuplicatePacketDetectorOptions options;
         options.setCircularBufferSize(circularBufferSize);
 
+        auto &memoryBudget = UDataPacketService::MemoryBudget::getInstance();
+        auto initialBytes = memoryBudget.getBytes();
+        {
         DuplicatePacketDetector detector{options};
         int cumulativeSamples{0}; 
         int nExamples = 2*circularBufferSize;
@@ -245,6 +251,10 @@ TEST_CASE("UDataPacketService::DuplicatePacketDetector", "[duplicateData]")
                      packetStartTime.count());
             REQUIRE(detector.allow(packet));
         }
+        // The stream's header buffer is charged to the memory budget
+        REQUIRE(memoryBudget.getBytes() > initialBytes);
+        }
+        REQUIRE(memoryBudget.getBytes() == initialBytes);
     }   
 
     SECTION("Every other is a duplicate")
@@ -379,5 +389,56 @@ TEST_CASE("UDataPacketService::DuplicatePacketDetector", "[duplicateData]")
             CHECK(!detector.allow(thisPacket));
         }
     }   
+
+    // Two upstreams deliver the same packets - the first copy wins
+    SECTION("Racing upstreams")
+    {
+        const int circularBufferSize{100};
+        constexpr int nStreams{4};
+        constexpr int nExamples{50};
+
+        DuplicatePacketDetectorOptions options;
+        options.setCircularBufferSize(circularBufferSize);
+
+        DuplicatePacketDetector detector{options};
+
+        std::vector<UV1::Packet> packets;
+        for (int iStream = 0; iStream < nStreams; ++iStream)
+        {
+            identifier.set_station("S" + std::to_string(iStream));
+            *packet.mutable_stream_identifier() = identifier;
+            int cumulativeSamples{0};
+            for (int iPacket = 0; iPacket < nExamples; iPacket++)
+            {
+                auto packetStartTime = startTime
+                    + std::chrono::microseconds {static_cast<int64_t>
+                          (std::round(cumulativeSamples/samplingRate*1000000))};
+                std::vector<int> data(uniformDistribution(generator), 0);
+                cumulativeSamples
+                    = cumulativeSamples + static_cast<int> (data.size());
+                packet.set_number_of_samples(data.size());
+                packet.set_data_type(dataType);
+                packet.set_data(::pack(data));
+                *packet.mutable_start_time()
+                    = google::protobuf::util::TimeUtil::MicrosecondsToTimestamp(
+                         packetStartTime.count());
+                packets.push_back(packet);
+            }
+        }
+
+        std::atomic<int> nAllowed{0};
+        auto upstream = [&]()
+        {
+            for (const auto &p : packets)
+            {
+                if (detector.allow(p)){nAllowed.fetch_add(1);}
+            }
+        };
+        std::thread upstream1(upstream);
+        std::thread upstream2(upstream);
+        upstream1.join();
+        upstream2.join();
+        REQUIRE(nAllowed.load() == nStreams*nExamples);
+    }
 }
 
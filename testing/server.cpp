@@ -26,6 +26,7 @@
 #include "uDataPacketServiceAPI/v1/stream_identifier.pb.h"
 #include "uDataPacketService/grpcServerOptions.hpp"
 #include "uDataPacketServiceAPI/v1/broadcast.grpc.pb.h"
+#include "uDataPacketServiceAPI/v1/admin.grpc.pb.h"
 #include "utilities.hpp"
 #include "certs.hpp"
 
@@ -59,6 +60,13 @@ TEST_CASE("UDataPacketServer", "[ServerOptions]")
     REQUIRE(options.getMaximumNumberOfSubscribers() == maxSubscribers);
     REQUIRE(options.getGRPCOptions().getHost() == host);
     REQUIRE(options.getGRPCOptions().getPort() == port);
+    REQUIRE(options.getBackfillThreshold() == std::chrono::minutes {2});
+    options.setBackfillThreshold(std::chrono::seconds {30});
+    REQUIRE(options.getBackfillThreshold() == std::chrono::seconds {30});
+    REQUIRE_THROWS(options.setBackfillThreshold(std::chrono::seconds {0}));
+    REQUIRE_FALSE(options.isAdminServiceEnabled());
+    options.enableAdminService(true);
+    REQUIRE(options.isAdminServiceEnabled());
 }
 
 ///--------------------------------------------------------------------------///
@@ -234,6 +242,98 @@ void subscribeToSome(const bool useCerts = false,
     REQUIRE(::comparePackets(receivedPackets, subReferencePackets));
 }
 
+/// Calls every admin RPC and checks that each finishes with the status
+void checkAdminStatus(std::shared_ptr<grpc::Channel> channel,
+                      const grpc::StatusCode expectedCode)
+{
+    auto stub = UDataPacketServiceAPI::V1::Admin::NewStub(channel);
+    {
+    grpc::ClientContext context;
+    UDataPacketServiceAPI::V1::ListStreamsRequest request;
+    UDataPacketServiceAPI::V1::ListStreamsResponse response;
+    REQUIRE(stub->ListStreams(&context, request, &response).error_code()
+         == expectedCode);
+    }
+    {
+    grpc::ClientContext context;
+    UDataPacketServiceAPI::V1::ListSubscribersRequest request;
+    UDataPacketServiceAPI::V1::ListSubscribersResponse response;
+    REQUIRE(stub->ListSubscribers(&context, request, &response).error_code()
+         == expectedCode);
+    }
+    {
+    grpc::ClientContext context;
+    UDataPacketServiceAPI::V1::GetStreamStatsRequest request;
+    UDataPacketServiceAPI::V1::GetStreamStatsResponse response;
+    REQUIRE(stub->GetStreamStats(&context, request, &response).error_code()
+         == expectedCode);
+    }
+    {
+    grpc::ClientContext context;
+    UDataPacketServiceAPI::V1::GetSubscriberStatsRequest request;
+    UDataPacketServiceAPI::V1::GetSubscriberStatsResponse response;
+    REQUIRE(stub->GetSubscriberStats(&context, request, &response).error_code()
+         == expectedCode);
+    }
+}
+
+/// The admin RPCs answer a caller with the access token
+void checkAdmin(const int nStreams, const int nSubscribers)
+{
+    auto channel = createChannel(true, true);
+    auto stub = UDataPacketServiceAPI::V1::Admin::NewStub(channel);
+    {
+    grpc::ClientContext context;
+    UDataPacketServiceAPI::V1::ListStreamsRequest request;
+    UDataPacketServiceAPI::V1::ListStreamsResponse response;
+    REQUIRE(stub->ListStreams(&context, request, &response).ok());
+    REQUIRE(response.identifiers_size() == nStreams);
+    }
+    {
+    grpc::ClientContext context;
+    UDataPacketServiceAPI::V1::ListSubscribersRequest request;
+    UDataPacketServiceAPI::V1::ListSubscribersResponse response;
+    REQUIRE(stub->ListSubscribers(&context, request, &response).ok());
+    REQUIRE(response.subscribers_size() == nSubscribers);
+    }
+    {
+    grpc::ClientContext context;
+    UDataPacketServiceAPI::V1::GetStreamStatsRequest request;
+    *request.add_selections()
+        = toIdentifier(NETWORK, STATION, "HHZ", LOCATION_CODE);
+    UDataPacketServiceAPI::V1::GetStreamStatsResponse response;
+    REQUIRE(stub->GetStreamStats(&context, request, &response).ok());
+    REQUIRE(response.statistics_size() == 1);
+    REQUIRE(response.statistics(0).identifier() == "UU.RDMU.HHZ.01");
+    REQUIRE(response.statistics(0).packets_received() == 5);
+    }
+    {
+    grpc::ClientContext context;
+    UDataPacketServiceAPI::V1::GetSubscriberStatsRequest request;
+    UDataPacketServiceAPI::V1::GetSubscriberStatsResponse response;
+    REQUIRE(stub->GetSubscriberStats(&context, request, &response).ok());
+    REQUIRE(response.statistics_size() == nSubscribers);
+    }
+}
+
+/// The admin RPCs reject a caller without the access token
+void checkAdminUnauthorized()
+{
+    auto address = std::string {GRPC_CLIENT_HOST}
+                 + ":" + std::to_string(GRPC_PORT);
+    grpc::SslCredentialsOptions sslOptions;
+    sslOptions.pem_root_certs = serverCertificate;
+    auto channel
+        = grpc::CreateChannel(address, grpc::SslCredentials(sslOptions));
+    ::checkAdminStatus(channel, grpc::StatusCode::UNAUTHENTICATED);
+}
+
+/// The admin service is not started on an insecure connection
+void checkAdminDisabled()
+{
+    ::checkAdminStatus(createChannel(), grpc::StatusCode::UNIMPLEMENTED);
+}
+
 std::vector<UDataPacketServiceAPI::V1::Packet> generate3CPackets(
     const int nPacketsPerChannel = 5)
 {
@@ -282,6 +382,7 @@ TEST_CASE("UDataPacketServer", "[SubscribeToAllSecure]")
     ServerOptions serverOptions;
     serverOptions.setMaximumNumberOfSubscribers(16);
     serverOptions.setGRPCOptions(grpcServerOptions);
+    serverOptions.enableAdminService(true);
 
     referencePackets = ::generate3CPackets();
     for (const auto &p : referencePackets)
@@ -306,6 +407,8 @@ TEST_CASE("UDataPacketServer", "[SubscribeToAllSecure]")
     }
 
     std::this_thread::sleep_for(std::chrono::milliseconds {1000});
+    ::checkAdmin(3, 1);
+    ::checkAdminUnauthorized();
     server->stop();
     if (serverThread.joinable()){serverThread.join();}
     if (clientSubAllThread.joinable()){clientSubAllThread.join();}
@@ -388,6 +491,8 @@ TEST_CASE("UDataPacketServer", "[SubscribeToAllAndSome]")
     ServerOptions serverOptions;
     serverOptions.setMaximumNumberOfSubscribers(16);
     serverOptions.setGRPCOptions(grpcServerOptions);
+    // Without TLS and a token this is refused
+    serverOptions.enableAdminService(true);
 
     referencePackets = ::generate3CPackets();
     for (const auto &p : referencePackets)
@@ -414,6 +519,7 @@ TEST_CASE("UDataPacketServer", "[SubscribeToAllAndSome]")
     }
 
     std::this_thread::sleep_for(std::chrono::milliseconds {1000});
+    ::checkAdminDisabled();
     server->stop();
     if (serverThread.joinable()){serverThread.join();}
     if (clientSubAllThread.joinable()){clientSubAllThread.join();}
@@ -12,6 +12,7 @@
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 #include "uDataPacketService/stream.hpp"
 #include "uDataPacketService/streamOptions.hpp"
+#include "uDataPacketService/statistics.hpp"
 #include "uDataPacketServiceAPI/v1/packet.pb.h"
 #include "uDataPacketServiceAPI/v1/stream_identifier.pb.h"
 #include "utilities.hpp"
@@ -96,8 +97,17 @@ TEST_CASE("UDataPacketService", "[streamOptions]")
     constexpr int maxQueueSize{5};
     using namespace UDataPacketService;
     StreamOptions options;
+    REQUIRE(!options.getMaximumQueueDuration());
+    REQUIRE(!options.getMaximumQueueBytes());
     options.setMaximumQueueSize(maxQueueSize);
+    options.setMaximumQueueDuration(std::chrono::milliseconds {2500});
+    options.setMaximumQueueBytes(4096);
     REQUIRE(options.getMaximumQueueSize() == maxQueueSize);
+    REQUIRE(*options.getMaximumQueueDuration()
+         == std::chrono::milliseconds {2500});
+    REQUIRE(*options.getMaximumQueueBytes() == 4096);
+    REQUIRE_THROWS(options.setMaximumQueueDuration(std::chrono::milliseconds {0}));
+    REQUIRE_THROWS(options.setMaximumQueueBytes(0));
 }
 
 TEST_CASE("UDataPacketService", "[stream]")
@@ -109,7 +119,7 @@ TEST_CASE("UDataPacketService", "[stream]")
     const std::string channel{"HHZ"};
     const std::string locationCode{"01"};
 
-    SECTION("Unordered")
+    SECTION("Latest")
     {
         StreamOptions options;
         auto inputPackets
@@ -123,80 +133,104 @@ TEST_CASE("UDataPacketService", "[stream]")
 
         REQUIRE(inputPackets.size() == nPacketsToCreate);
 
-        std::vector<UDataPacketServiceAPI::V1::Packet> packetsBack1;
-        std::vector<UDataPacketServiceAPI::V1::Packet> packetsBack2;
-
         auto packet = inputPackets.at(0);
         UDataPacketService::Stream stream{std::move(packet), options};
         REQUIRE(stream.getIdentifier() == "UU.CTU.HHZ.01");
-
-        auto myThreadID = std::this_thread::get_id();
-        auto subscriberID1 = reinterpret_cast<uintptr_t> (&myThreadID);
-        auto subscriberID2 = subscriberID1 + 1; 
-        constexpr bool enqueuePacket{true};
-        REQUIRE(stream.subscribe(subscriberID1, enqueuePacket));
-
         {
-        auto packetBack = stream.getNextPacket(subscriberID1);
-        if (packetBack){packetsBack1.push_back(*packetBack);}
+        auto packetBack = stream.getMostRecentPacket();
+        REQUIRE(packetBack);
+        REQUIRE(::comparePacket(*packetBack, inputPackets.at(0)));
         }
 
-        REQUIRE(stream.subscribe(subscriberID2, enqueuePacket));
+        // The stream keeps whatever came last regardless of the order
+        for (int i = 1; i < nPacketsToCreate; ++i)
         {
-        auto packetBack = stream.getNextPacket(subscriberID2);
-        if (packetBack){packetsBack2.push_back(*packetBack);}
+            stream.setNextPacket(inputPackets.at(i));
+            auto packetBack = stream.getMostRecentPacket();
+            REQUIRE(packetBack);
+            REQUIRE(::comparePacket(*packetBack, inputPackets.at(i)));
         }
 
-        REQUIRE(stream.getNumberOfSubscribers() == 2);
-        REQUIRE(!stream.subscribe(subscriberID1, enqueuePacket));
+        // Packets from other streams are rejected
+        auto otherPacket
+            = ::generatePackets(1, network, station, "HHN", locationCode);
+        REQUIRE_THROWS(stream.setNextPacket(otherPacket.at(0)));
+        REQUIRE(::comparePacket(*stream.getMostRecentPacket(),
+                                inputPackets.back()));
+    }
 
-        // Get everything back on the first thread 
+    SECTION("Statistics")
+    {
+        constexpr int maxQueueSize{2};
+        StreamOptions options;
+        options.setMaximumQueueSize(maxQueueSize);
+        auto inputPackets
+            = ::generatePackets(nPacketsToCreate,
+                                network,
+                                station,
+                                channel,
+                                locationCode);
+        auto packet = inputPackets.at(0);
+        UDataPacketService::Stream stream{std::move(packet), options};
         for (int i = 1; i < nPacketsToCreate; ++i)
         {
             stream.setNextPacket(inputPackets.at(i));
-            auto packetBack = stream.getNextPacket(subscriberID1);
-            if (packetBack){packetsBack1.push_back(*packetBack);}
         }
+        REQUIRE(stream.getMaximumQueueSize() == maxQueueSize);
 
-        // And the other thread
+        auto statistics = stream.getStatistics();
+        REQUIRE(statistics.identifier == "UU.CTU.HHZ.01");
+        REQUIRE(statistics.packetsReceived == nPacketsToCreate);
+        REQUIRE(statistics.bytesReceived > 0);
+        REQUIRE(statistics.lastPacketTime.count() > 0);
+    }
+
+    SECTION("Shared")
+    {
+        StreamOptions options;
+        auto inputPackets
+            = ::generatePackets(nPacketsToCreate,
+                                network,
+                                station,
+                                channel,
+                                locationCode);
+        auto packet = inputPackets.at(0);
+        UDataPacketService::Stream stream{std::move(packet), options};
+        // This only swaps the latest packet so nothing is copied
         for (int i = 1; i < nPacketsToCreate; ++i)
         {
-            auto packetBack = stream.getNextPacket(subscriberID2);
-            if (packetBack){packetsBack2.push_back(*packetBack);}
+            auto sharedPacket
+                = std::make_shared<const UDataPacketServiceAPI::V1::Packet>
+                  (inputPackets.at(i));
+            stream.setNextPacket(sharedPacket);
+            REQUIRE(stream.getMostRecentPacket() == sharedPacket);
         }
+        REQUIRE(stream.getStatistics().packetsReceived == nPacketsToCreate);
+        REQUIRE_THROWS(stream.setNextPacket(
+            std::shared_ptr<const UDataPacketServiceAPI::V1::Packet> {nullptr}));
+        REQUIRE(::comparePacket(*stream.getMostRecentPacket(),
+                                inputPackets.back()));
+    }
 
-        auto subscribers = stream.getSubscribers();
-        REQUIRE(stream.isSubscribed(subscriberID1));
-        REQUIRE(stream.isSubscribed(subscriberID2));
-        REQUIRE(subscribers.size() == 2);
-        REQUIRE(subscribers.contains(subscriberID1));
-        REQUIRE(subscribers.contains(subscriberID2));
-
-        REQUIRE(stream.unsubscribe(subscriberID1) ==
-                Stream::UnsubscribeResponse::Unsubscribed);
-        REQUIRE(stream.getNumberOfSubscribers() == 1);
-        REQUIRE(stream.unsubscribe(subscriberID2) ==
-                Stream::UnsubscribeResponse::Unsubscribed);
-        REQUIRE(stream.getNumberOfSubscribers() == 0);
-
-        REQUIRE(inputPackets.size() == packetsBack1.size());
-        REQUIRE(inputPackets.size() == packetsBack2.size());
-        for (int i = 0; i < static_cast<int> (inputPackets.size()); ++i)
+    SECTION("QueueBounds")
+    {
+        constexpr int nPackets{10};
+        auto inputPackets
+            = ::generatePackets(nPackets, network, station,
+                                channel, locationCode);
+        // The packets are 2 to 3 s long so 6 s of data is 2 or 3 packets
+        StreamOptions durationOptions;
+        durationOptions.setMaximumQueueSize(1);
+        durationOptions.setMaximumQueueDuration(std::chrono::seconds {6});
+        auto packet = inputPackets.at(0);
+        UDataPacketService::Stream durationStream{std::move(packet),
+                                                  durationOptions};
+        for (int i = 0; i < nPackets; ++i)
         {
-            REQUIRE(inputPackets.at(i).data_type() ==
-                    packetsBack1.at(i).data_type());
-            REQUIRE(inputPackets.at(i).start_time() ==
-                    packetsBack1.at(i).start_time());
-            REQUIRE(inputPackets.at(i).number_of_samples() ==
-                    packetsBack1.at(i).number_of_samples());
-
-            REQUIRE(inputPackets.at(i).data_type() ==
-                    packetsBack2.at(i).data_type());
-            REQUIRE(inputPackets.at(i).start_time() ==
-                    packetsBack2.at(i).start_time());
-            REQUIRE(inputPackets.at(i).number_of_samples() ==
-                    packetsBack2.at(i).number_of_samples());
+            durationStream.setNextPacket(inputPackets.at(i));
         }
+        auto capacity = durationStream.getMaximumQueueSize();
+        REQUIRE(capacity >= 2);
+        REQUIRE(capacity <= 3);
     }
 }
-
@@ -1,5 +1,6 @@
 #include <cmath>
 #include <string>
+#include <map>
 #include <thread>
 #include <random>
 #include <chrono>
@@ -16,11 +17,14 @@
 #include "uDataPacketService/subscriptionManagerOptions.hpp"
 #include "uDataPacketService/stream.hpp"
 #include "uDataPacketService/streamOptions.hpp"
+#include "uDataPacketService/statistics.hpp"
 #include "uDataPacketServiceAPI/v1/packet.pb.h"
 #include "uDataPacketServiceAPI/v1/stream_identifier.pb.h"
 #include "uDataPacketService/grpcServerOptions.hpp"
 #include "utilities.hpp"
 
+import MemoryBudget;
+
 TEST_CASE("UDataPacketService", "[SubscriptionManagerOptions]")
 {
     using namespace UDataPacketService;
@@ -34,14 +38,23 @@ TEST_CASE("UDataPacketService", "[SubscriptionManagerOptions]")
         SubscriptionManagerOptions options;
         //options.setMaximumNumberOfSubscribers(maxSubscribers);
         options.setStreamOptions(streamOptions);
+        options.setBroadcastLogCapacity(512);
+        options.setIdleStreamTimeout(std::chrono::seconds {120});
+        options.setMaximumNumberOfStreams(1024);
         //REQUIRE(options.getMaximumNumberOfSubscribers() == maxSubscribers);
         REQUIRE(options.getStreamOptions().getMaximumQueueSize() == maxStreamQueueSize);
+        REQUIRE(options.getBroadcastLogCapacity() == 512);
+        REQUIRE(options.getIdleStreamTimeout() == std::chrono::seconds {120});
+        REQUIRE(options.getMaximumNumberOfStreams() == 1024);
     }
 
     SECTION("Defaults")
     {
         SubscriptionManagerOptions options;
         REQUIRE(options.getStreamOptions().getMaximumQueueSize() == 128);
+        REQUIRE(options.getBroadcastLogCapacity() == 8388608);
+        REQUIRE(options.getIdleStreamTimeout() == std::chrono::seconds {3600});
+        REQUIRE(options.getMaximumNumberOfStreams() == 65536);
     }
 }
 
@@ -71,9 +84,8 @@ TEST_CASE("UDataPacketServer", "[SubscriptionManager]")
         auto identifier2 = ::toIdentifier(network, station, channels.at(1), locationCode);
         auto identifier3 = ::toIdentifier(network, station, channels.at(2), locationCode);
 
-        auto myThreadID = std::this_thread::get_id();
-        auto subscriberID1 = reinterpret_cast<uintptr_t> (&myThreadID);
-        auto subscriberID2 = reinterpret_cast<uintptr_t> (&myThreadID) + 1;
+        auto subscriberID1 = subscriptionManager.createSubscriber();
+        auto subscriberID2 = subscriptionManager.createSubscriber();
  
         REQUIRE(subscriptionManager.getNumberOfSubscribers() == 0);
 
@@ -174,5 +186,562 @@ TEST_CASE("UDataPacketServer", "[SubscriptionManager]")
         REQUIRE(subscriptionManager.getNumberOfSubscribers() == 0);
     }
 
+    SECTION("PendingSubscriptions")
+    {
+        auto consoleSink
+            = std::make_shared<spdlog::sinks::stdout_color_sink_mt> (); 
+        auto logger
+            = std::make_shared<spdlog::logger>
+              (spdlog::logger ("SubscriptionManagerTestPending",
+               {consoleSink}));
+
+        SubscriptionManager subscriptionManager{defaultOptions, logger};
+
+        auto identifier1 = ::toIdentifier(network, station, channels.at(0), locationCode);
+        auto identifier2 = ::toIdentifier(network, station, channels.at(1), locationCode);
+
+        auto subscriberID1 = subscriptionManager.createSubscriber();
+        auto subscriberID2 = subscriptionManager.createSubscriber();
+
+        // Neither stream exists yet so both subscriptions are pending
+        subscriptionManager.subscribe(subscriberID1,
+                                      std::vector {identifier1, identifier2});
+        subscriptionManager.subscribe(subscriberID2,
+                                      std::vector {identifier1});
+        REQUIRE(subscriptionManager.getNumberOfSubscribers() == 2);
+        REQUIRE(subscriptionManager.getNumberOfSubscriptions(subscriberID1) == 0);
+
+        // Second subscriber leaves before its stream shows up
+        subscriptionManager.unsubscribeFromAll(subscriberID2);
+        REQUIRE(subscriptionManager.getNumberOfSubscribers() == 1);
+
+        // The freed slot is reused but the old handle is stale
+        auto subscriberID3 = subscriptionManager.createSubscriber();
+        REQUIRE(subscriberID3.getSlot() == subscriberID2.getSlot());
+        REQUIRE(subscriberID3 != subscriberID2);
+        REQUIRE_THROWS(subscriptionManager.subscribe(subscriberID2,
+                                                     std::vector {identifier1}));
+        subscriptionManager.unsubscribeFromAll(subscriberID2); // No-op
+        subscriptionManager.unsubscribeFromAll(subscriberID3);
+        REQUIRE(subscriptionManager.getNumberOfSubscribers() == 1);
+
+        auto p1 = ::generatePackets(1, network, station,
+                                    channels.at(0), locationCode);
+        auto p2 = ::generatePackets(1, network, station,
+                                    channels.at(1), locationCode);
+        subscriptionManager.enqueuePacket(p1.at(0));
+        REQUIRE(subscriptionManager.getNumberOfSubscriptions(subscriberID1) == 1);
+        REQUIRE(subscriptionManager.getNumberOfSubscriptions(subscriberID2) == 0);
+        REQUIRE(subscriptionManager.getPackets(subscriberID1).size() == 1);
+        REQUIRE(subscriptionManager.getPackets(subscriberID2).empty());
+
+        subscriptionManager.enqueuePacket(p2.at(0));
+        REQUIRE(subscriptionManager.getNumberOfSubscriptions(subscriberID1) == 2);
+        REQUIRE(subscriptionManager.getPackets(subscriberID1).size() == 1);
+        REQUIRE(subscriptionManager.getNumberOfSubscribers() == 1);
+
+        auto subscriberStatistics = subscriptionManager.getSubscriberStatistics();
+        REQUIRE(subscriberStatistics.size() == 1);
+        REQUIRE(subscriberStatistics.at(0).handle == subscriberID1);
+        REQUIRE(subscriberStatistics.at(0).numberOfSubscriptions == 2);
+        REQUIRE(subscriberStatistics.at(0).queueDepth == 0);
+        REQUIRE(!subscriberStatistics.at(0).subscribedToAll);
+        auto streamStatistics = subscriptionManager.getStreamStatistics();
+        REQUIRE(streamStatistics.size() == 2);
+        for (const auto &statistics : streamStatistics)
+        {
+            REQUIRE(statistics.numberOfSubscribers == 1);
+        }
+
+        subscriptionManager.unsubscribeFromAll(subscriberID1);
+        REQUIRE(subscriptionManager.getNumberOfSubscribers() == 0);
+        REQUIRE(subscriptionManager.getNumberOfSubscriptions(subscriberID1) == 0);
+    }
+
+    SECTION("SubscriptionGroups")
+    {
+        auto consoleSink
+            = std::make_shared<spdlog::sinks::stdout_color_sink_mt> (); 
+        auto logger
+            = std::make_shared<spdlog::logger>
+              (spdlog::logger ("SubscriptionManagerTestGroups",
+               {consoleSink}));
+
+        SubscriptionManager subscriptionManager{defaultOptions, logger};
 
+        auto identifier1 = ::toIdentifier(network, station, channels.at(0), locationCode);
+        auto identifier2 = ::toIdentifier(network, station, channels.at(1), locationCode);
+        auto identifier3 = ::toIdentifier(network, station, channels.at(2), locationCode);
+
+        // The first two have the same selection in a different order
+        auto subscriberID1 = subscriptionManager.createSubscriber();
+        auto subscriberID2 = subscriptionManager.createSubscriber();
+        auto subscriberID3 = subscriptionManager.createSubscriber();
+        subscriptionManager.subscribe(subscriberID1,
+                                      std::vector {identifier1, identifier2});
+        subscriptionManager.subscribe(subscriberID2,
+                                      std::vector {identifier2, identifier1});
+        subscriptionManager.subscribe(subscriberID3,
+                                      std::vector {identifier2});
+
+        auto p1 = ::generatePackets(2, network, station,
+                                    channels.at(0), locationCode);
+        auto p2 = ::generatePackets(2, network, station,
+                                    channels.at(1), locationCode);
+        auto p3 = ::generatePackets(2, network, station,
+                                    channels.at(2), locationCode);
+        for (int i = 0; i < 2; ++i)
+        {
+            subscriptionManager.enqueuePacket(p1.at(i));
+            subscriptionManager.enqueuePacket(p2.at(i));
+            subscriptionManager.enqueuePacket(p3.at(i));
+        }
+        std::vector<UDataPacketServiceAPI::V1::Packet> expectedPackets
+            {p1.at(0), p2.at(0), p1.at(1), p2.at(1)};
+        for (const auto &handle : std::vector {subscriberID1, subscriberID2})
+        {
+            REQUIRE(subscriptionManager.getNumberOfSubscriptions(handle) == 2);
+            auto nextPackets = subscriptionManager.getPackets(handle);
+            REQUIRE(nextPackets.size() == expectedPackets.size());
+            REQUIRE(::comparePackets(nextPackets, expectedPackets, false));
+        }
+        auto nextPackets = subscriptionManager.getPackets(subscriberID3);
+        REQUIRE(nextPackets.size() == 2);
+        REQUIRE(::comparePackets(nextPackets,
+                                 std::vector {p2.at(0), p2.at(1)}, false));
+        auto statistics
+            = subscriptionManager.getStreamStatistics("UU.CWU.HHN.01");
+        REQUIRE(statistics);
+        REQUIRE(statistics->numberOfSubscribers == 3);
+        statistics
+            = subscriptionManager.getStreamStatistics("UU.CWU.HHE.01");
+        REQUIRE(statistics);
+        REQUIRE(statistics->numberOfSubscribers == 0);
+
+        // Widening a selection moves the subscriber to another group
+        subscriptionManager.subscribe(subscriberID3,
+                                      std::vector {identifier3});
+        REQUIRE(subscriptionManager.getNumberOfSubscriptions(subscriberID3) == 2);
+        subscriptionManager.enqueuePacket(p3.at(0));
+        REQUIRE(subscriptionManager.getPackets(subscriberID3).size() == 1);
+        REQUIRE(subscriptionManager.getPackets(subscriberID1).empty());
+
+        subscriptionManager.unsubscribeFromAll(subscriberID1);
+        statistics
+            = subscriptionManager.getStreamStatistics("UU.CWU.HHZ.01");
+        REQUIRE(statistics->numberOfSubscribers == 1);
+        subscriptionManager.unsubscribeFromAll(subscriberID2);
+        subscriptionManager.unsubscribeFromAll(subscriberID3);
+        REQUIRE(subscriptionManager.getNumberOfSubscribers() == 0);
+        for (const auto &streamStatistics :
+             subscriptionManager.getStreamStatistics())
+        {
+            REQUIRE(streamStatistics.numberOfSubscribers == 0);
+        }
+    }
+
+    SECTION("BroadcastLog")
+    {
+        auto consoleSink
+            = std::make_shared<spdlog::sinks::stdout_color_sink_mt> (); 
+        auto logger
+            = std::make_shared<spdlog::logger>
+              (spdlog::logger ("SubscriptionManagerTestBroadcastLog",
+               {consoleSink}));
+
+        constexpr int capacity{6};
+        SubscriptionManagerOptions options;
+        options.setBroadcastLogCapacity(capacity);
+        SubscriptionManager subscriptionManager{options, logger};
+
+        constexpr int nPacketsPerChannel{4};
+        auto p1 = ::generatePackets(nPacketsPerChannel, network, station,
+                                    channels.at(0), locationCode);
+        auto p2 = ::generatePackets(nPacketsPerChannel, network, station,
+                                    channels.at(1), locationCode);
+        // Nobody is reading yet so this is not seen
+        subscriptionManager.enqueuePacket(p1.at(0));
+
+        auto subscriberID1 = subscriptionManager.createSubscriber();
+        auto subscriberID2 = subscriptionManager.createSubscriber();
+        subscriptionManager.subscribeToAll(subscriberID1);
+        subscriptionManager.subscribeToAll(subscriberID2);
+        subscriptionManager.subscribeToAll(subscriberID2); // No-op
+        REQUIRE(subscriptionManager.getNumberOfSubscribers() == 2);
+        REQUIRE(subscriptionManager.getNumberOfSubscriptions(subscriberID1) == 1);
+        REQUIRE(subscriptionManager.getPackets(subscriberID1).empty());
+
+        // Both subscribers see the packets in the order they arrived
+        std::vector<UDataPacketServiceAPI::V1::Packet> sentPackets;
+        for (int i = 1; i < nPacketsPerChannel; ++i)
+        {
+            subscriptionManager.enqueuePacket(p1.at(i));
+            subscriptionManager.enqueuePacket(p2.at(i));
+            sentPackets.push_back(p1.at(i));
+            sentPackets.push_back(p2.at(i));
+        }
+        REQUIRE(static_cast<int> (sentPackets.size()) == capacity);
+        auto subscriberStatistics = subscriptionManager.getSubscriberStatistics();
+        REQUIRE(subscriberStatistics.size() == 2);
+        for (const auto &statistics : subscriberStatistics)
+        {
+            REQUIRE(statistics.subscribedToAll);
+            REQUIRE(statistics.queueDepth == capacity);
+            REQUIRE(statistics.numberOfSubscriptions == 2);
+        }
+        auto nextPackets = subscriptionManager.getPackets(subscriberID1);
+        REQUIRE(nextPackets.size() == sentPackets.size());
+        REQUIRE(::comparePackets(nextPackets, sentPackets, false));
+        // Subscribers to all are not on the streams
+        for (const auto &statistics : subscriptionManager.getStreamStatistics())
+        {
+            REQUIRE(statistics.numberOfSubscribers == 0);
+        }
+
+        // The second subscriber is lapped and loses the oldest packets
+        subscriptionManager.enqueuePacket(p1.at(0));
+        subscriptionManager.enqueuePacket(p2.at(0));
+        sentPackets.erase(sentPackets.begin(), sentPackets.begin() + 2);
+        sentPackets.push_back(p1.at(0));
+        sentPackets.push_back(p2.at(0));
+        nextPackets = subscriptionManager.getPackets(subscriberID2);
+        REQUIRE(nextPackets.size() == sentPackets.size());
+        REQUIRE(::comparePackets(nextPackets, sentPackets, false));
+        nextPackets = subscriptionManager.getPackets(subscriberID1);
+        REQUIRE(nextPackets.size() == 2);
+        for (const auto &statistics : subscriptionManager.getSubscriberStatistics())
+        {
+            REQUIRE(statistics.queueDepth == 0);
+            if (statistics.handle == subscriberID1)
+            {
+                REQUIRE(statistics.packetsDropped == 0);
+            }
+            else
+            {
+                REQUIRE(statistics.packetsDropped == 2);
+            }
+        }
+
+        subscriptionManager.unsubscribeFromAll(subscriberID1);
+        REQUIRE(subscriptionManager.getPackets(subscriberID1).empty());
+        subscriptionManager.unsubscribeFromAll(subscriberID2);
+        REQUIRE(subscriptionManager.getNumberOfSubscribers() == 0);
+    }
+
+    SECTION("GroupRetention")
+    {
+        auto consoleSink
+            = std::make_shared<spdlog::sinks::stdout_color_sink_mt> (); 
+        auto logger
+            = std::make_shared<spdlog::logger>
+              (spdlog::logger ("SubscriptionManagerTestRetention",
+               {consoleSink}));
+        auto identifier
+            = ::toIdentifier(network, station, channels.at(0), locationCode);
+        constexpr int nPackets{10};
+        auto packets = ::generatePackets(nPackets, network, station,
+                                         channels.at(0), locationCode);
+
+        // The packets are 2 to 3 s long so 6 s of data is 2 or 3 packets.
+        // The group is created before the stream exists so it starts with
+        // the default of 1 packet and grows when the stream arrives.
+        StreamOptions durationOptions;
+        durationOptions.setMaximumQueueSize(1);
+        durationOptions.setMaximumQueueDuration(std::chrono::seconds {6});
+        SubscriptionManagerOptions durationManagerOptions;
+        durationManagerOptions.setStreamOptions(durationOptions);
+        SubscriptionManager durationManager{durationManagerOptions, logger};
+        auto subscriberID = durationManager.createSubscriber();
+        durationManager.subscribe(subscriberID, std::vector {identifier});
+        for (const auto &packet : packets)
+        {
+            durationManager.enqueuePacket(packet);
+        }
+        auto nextPackets = durationManager.getPackets(subscriberID);
+        REQUIRE(nextPackets.size() >= 2);
+        REQUIRE(nextPackets.size() <= 3);
+        REQUIRE(::comparePackets(std::vector {nextPackets.back()},
+                                 std::vector {packets.back()}));
+        auto statistics = durationManager.getSubscriberStatistics().at(0);
+        REQUIRE(statistics.packetsDropped
+              + static_cast<int64_t> (nextPackets.size()) == nPackets);
+        durationManager.unsubscribeFromAll(subscriberID);
+
+        // A byte bound smaller than a packet keeps only the latest packet
+        // in every group's log
+        StreamOptions byteOptions;
+        byteOptions.setMaximumQueueBytes(1);
+        SubscriptionManagerOptions byteManagerOptions;
+        byteManagerOptions.setStreamOptions(byteOptions);
+        SubscriptionManager byteManager{byteManagerOptions, logger};
+        auto selectiveSubscriberID = byteManager.createSubscriber();
+        auto allSubscriberID = byteManager.createSubscriber();
+        byteManager.subscribe(selectiveSubscriberID, std::vector {identifier});
+        byteManager.subscribeToAll(allSubscriberID);
+        for (const auto &packet : packets)
+        {
+            byteManager.enqueuePacket(packet);
+        }
+        for (const auto &id : {selectiveSubscriberID, allSubscriberID})
+        {
+            nextPackets = byteManager.getPackets(id);
+            REQUIRE(nextPackets.size() == 1);
+            REQUIRE(::comparePackets(nextPackets,
+                                     std::vector {packets.back()}));
+        }
+        for (const auto &subscriberStatistics :
+             byteManager.getSubscriberStatistics())
+        {
+            REQUIRE(subscriberStatistics.packetsDropped == nPackets - 1);
+        }
+        byteManager.unsubscribeFromAll(selectiveSubscriberID);
+        byteManager.unsubscribeFromAll(allSubscriberID);
+    }
+
+    SECTION("StreamEviction")
+    {
+        auto consoleSink
+            = std::make_shared<spdlog::sinks::stdout_color_sink_mt> (); 
+        auto logger
+            = std::make_shared<spdlog::logger>
+              (spdlog::logger ("SubscriptionManagerTestEviction",
+               {consoleSink}));
+
+        SubscriptionManagerOptions options;
+        options.setIdleStreamTimeout(std::chrono::seconds {1});
+        options.setMaximumNumberOfStreams(2);
+        SubscriptionManager subscriptionManager{options, logger};
+
+        auto p1 = ::generatePackets(2, network, station,
+                                    channels.at(0), locationCode);
+        auto p2 = ::generatePackets(2, network, station,
+                                    channels.at(1), locationCode);
+        auto p3 = ::generatePackets(2, network, station,
+                                    channels.at(2), locationCode);
+        auto subscriberID = subscriptionManager.createSubscriber();
+        subscriptionManager.subscribe(
+            subscriberID,
+            std::vector {::toIdentifier(network, station,
+                                        channels.at(0), locationCode)});
+
+        // A full registry makes room by evicting the stalest stream
+        subscriptionManager.enqueuePacket(p1.at(0));
+        std::this_thread::sleep_for(std::chrono::milliseconds {2});
+        subscriptionManager.enqueuePacket(p2.at(0));
+        std::this_thread::sleep_for(std::chrono::milliseconds {2});
+        subscriptionManager.enqueuePacket(p3.at(0));
+        REQUIRE(subscriptionManager.getNumberOfStreams() == 2);
+        REQUIRE(subscriptionManager.getNumberOfEvictedStreams() == 1);
+        REQUIRE(!subscriptionManager.getStreamStatistics("UU.CWU.HHZ.01"));
+        REQUIRE(subscriptionManager.getNumberOfSubscriptions(subscriberID) == 0);
+        REQUIRE(subscriptionManager.getPackets(subscriberID).size() == 1);
+
+        // The subscription resumes when the stream returns
+        subscriptionManager.enqueuePacket(p1.at(1));
+        REQUIRE(subscriptionManager.getNumberOfEvictedStreams() == 2);
+        REQUIRE(subscriptionManager.getNumberOfSubscriptions(subscriberID) == 1);
+        auto nextPackets = subscriptionManager.getPackets(subscriberID);
+        REQUIRE(nextPackets.size() == 1);
+        REQUIRE(::comparePackets(nextPackets, std::vector {p1.at(1)}, false));
+
+        // Publishing removes the idle streams
+        std::this_thread::sleep_for(std::chrono::milliseconds {1100});
+        subscriptionManager.enqueuePacket(p2.at(1));
+        REQUIRE(subscriptionManager.getNumberOfEvictedStreams() == 4);
+        REQUIRE(subscriptionManager.evictIdleStreams() == 0);
+        REQUIRE(subscriptionManager.getStreamIdentifiers()
+             == std::vector<std::string> {"UU.CWU.HHN.01"});
+        REQUIRE(subscriptionManager.getNumberOfSubscriptions(subscriberID) == 0);
+        subscriptionManager.unsubscribeFromAll(subscriberID);
+    }
+
+    SECTION("MemoryBudget")
+    {
+        auto consoleSink
+            = std::make_shared<spdlog::sinks::stdout_color_sink_mt> (); 
+        auto logger
+            = std::make_shared<spdlog::logger>
+              (spdlog::logger ("SubscriptionManagerTestMemoryBudget",
+               {consoleSink}));
+
+        SubscriptionManager subscriptionManager{defaultOptions, logger};
+        auto identifier
+            = ::toIdentifier(network, station, channels.at(0), locationCode);
+        auto fastSubscriberID = subscriptionManager.createSubscriber();
+        auto slowSubscriberID = subscriptionManager.createSubscriber();
+        subscriptionManager.subscribe(fastSubscriberID,
+                                      std::vector {identifier});
+        subscriptionManager.subscribe(slowSubscriberID,
+                                      std::vector {identifier});
+
+        constexpr int nPackets{5};
+        auto packets = ::generatePackets(nPackets, network, station,
+                                         channels.at(0), locationCode);
+        auto &memoryBudget = MemoryBudget::getInstance();
+        auto initialBytes = memoryBudget.getBytes();
+        for (int i = 0; i < nPackets - 1; ++i)
+        {
+            subscriptionManager.enqueuePacket(packets.at(i));
+        }
+        REQUIRE(memoryBudget.getBytes() > initialBytes);
+        REQUIRE(subscriptionManager.getPackets(fastSubscriberID).size()
+             == nPackets - 1);
+
+        // Exceeding the budget sheds the slow subscriber's backlog and
+        // releases what the fast subscriber has read.  The stream keeps its
+        // most recent packet.
+        auto limit = initialBytes
+                   + static_cast<int64_t> (packets.at(nPackets - 2).ByteSizeLong())
+                   + static_cast<int64_t> (packets.back().ByteSizeLong());
+        memoryBudget.setLimit(limit);
+        subscriptionManager.enqueuePacket(packets.back());
+        REQUIRE(!memoryBudget.isExceeded());
+        REQUIRE(subscriptionManager.getPackets(slowSubscriberID).empty());
+        auto nextPackets = subscriptionManager.getPackets(fastSubscriberID);
+        REQUIRE(nextPackets.size() == 1);
+        REQUIRE(::comparePackets(nextPackets,
+                                 std::vector {packets.back()}, false));
+        for (const auto &statistics :
+             subscriptionManager.getSubscriberStatistics())
+        {
+            if (statistics.handle == slowSubscriberID)
+            {
+                REQUIRE(statistics.packetsDropped == nPackets);
+            }
+            else
+            {
+                REQUIRE(statistics.packetsDropped == 0);
+            }
+        }
+        memoryBudget.clearLimit();
+        REQUIRE(!memoryBudget.getLimit());
+        subscriptionManager.unsubscribeFromAll(fastSubscriberID);
+        subscriptionManager.unsubscribeFromAll(slowSubscriberID);
+        // The retired group's ring and bookkeeping were released
+        auto idleBytes = memoryBudget.getBytes();
+        REQUIRE(idleBytes
+              < initialBytes
+              + static_cast<int64_t> (packets.back().ByteSizeLong()));
+
+        // The last subscriber out of a group releases the group's packets.
+        // The stream keeps its most recent packet.
+        auto allSubscriberID = subscriptionManager.createSubscriber();
+        subscriptionManager.subscribeToAll(allSubscriberID);
+        for (const auto &packet : packets)
+        {
+            subscriptionManager.enqueuePacket(packet);
+        }
+        REQUIRE(memoryBudget.getBytes() > idleBytes);
+        subscriptionManager.unsubscribeFromAll(allSubscriberID);
+        REQUIRE(memoryBudget.getBytes() == idleBytes);
+    }
+
+    SECTION("Subscribers to all keep a queue per stream")
+    {
+        auto consoleSink
+            = std::make_shared<spdlog::sinks::stdout_color_sink_mt> (); 
+        auto logger
+            = std::make_shared<spdlog::logger>
+              (spdlog::logger ("SubscriptionManagerTestManyStreams",
+               {consoleSink}));
+
+        SubscriptionManager subscriptionManager{defaultOptions, logger};
+        auto subscriberID = subscriptionManager.createSubscriber();
+        subscriptionManager.subscribeToAll(subscriberID);
+
+        // More streams than a fixed log of the old default would hold
+        constexpr int nStreams{100};
+        constexpr int nExtraPackets{10};
+        const auto queueSize
+            = defaultOptions.getStreamOptions().getMaximumQueueSize();
+        REQUIRE(nStreams*queueSize > 8192);
+        const auto nPackets = queueSize + nExtraPackets;
+        std::vector<std::vector<UDataPacketServiceAPI::V1::Packet>> packets;
+        for (int i = 0; i < nStreams; ++i)
+        {
+            packets.push_back(::generatePackets(nPackets, network,
+                                                "S" + std::to_string(i),
+                                                channels.at(0),
+                                                locationCode));
+        }
+        // The subscriber lags behind every stream
+        for (int k = 0; k < nPackets; ++k)
+        {
+            for (int i = 0; i < nStreams; ++i)
+            {
+                subscriptionManager.enqueuePacket(packets.at(i).at(k));
+            }
+        }
+        auto subscriberStatistics
+            = subscriptionManager.getSubscriberStatistics();
+        REQUIRE(subscriberStatistics.size() == 1);
+        REQUIRE(subscriberStatistics.at(0).queueDepth == nStreams*queueSize);
+
+        // Each stream still has as many packets as its queue would hold
+        std::map<std::string, int> depths;
+        while (true)
+        {
+            auto nextPackets = subscriptionManager.getPackets(subscriberID);
+            if (nextPackets.empty()){break;}
+            for (const auto &packet : nextPackets)
+            {
+                depths[packet->stream_identifier().station()]++;
+            }
+        }
+        REQUIRE(static_cast<int> (depths.size()) == nStreams);
+        for (const auto &depth : depths)
+        {
+            REQUIRE(depth.second == queueSize);
+        }
+        subscriberStatistics = subscriptionManager.getSubscriberStatistics();
+        REQUIRE(subscriberStatistics.at(0).packetsDropped
+             == nStreams*nExtraPackets);
+        subscriptionManager.unsubscribeFromAll(subscriberID);
+    }
+
+    SECTION("Groups are charged to the memory budget")
+    {
+        auto consoleSink
+            = std::make_shared<spdlog::sinks::stdout_color_sink_mt> (); 
+        auto logger
+            = std::make_shared<spdlog::logger>
+              (spdlog::logger ("SubscriptionManagerTestGroupBudget",
+               {consoleSink}));
+
+        SubscriptionManager subscriptionManager{defaultOptions, logger};
+        auto &memoryBudget = MemoryBudget::getInstance();
+        auto initialBytes = memoryBudget.getBytes();
+        // Each subscriber selects a distinct stream so each opens a group
+        constexpr int nGroups{50};
+        std::vector<SubscriberHandle> handles;
+        for (int i = 0; i < nGroups; ++i)
+        {
+            auto identifier
+                = ::toIdentifier(network, "S" + std::to_string(i),
+                                 channels.at(0), locationCode);
+            auto handle = subscriptionManager.createSubscriber();
+            subscriptionManager.subscribe(handle, std::vector {identifier});
+            handles.push_back(handle);
+            // Every group adds at least its ring's slots
+            REQUIRE(memoryBudget.getBytes() > initialBytes);
+        }
+        auto groupBytes = memoryBudget.getBytes() - initialBytes;
+        REQUIRE(groupBytes >= nGroups
+                             *static_cast<int64_t> (
+                                defaultOptions.getStreamOptions()
+                                              .getMaximumQueueSize()));
+        // Subscribing a second time to the same selection shares the group
+        auto sharedHandle = subscriptionManager.createSubscriber();
+        subscriptionManager.subscribe(sharedHandle,
+            std::vector {::toIdentifier(network, "S0",
+                                        channels.at(0), locationCode)});
+        REQUIRE(memoryBudget.getBytes() - initialBytes == groupBytes);
+        subscriptionManager.unsubscribeFromAll(sharedHandle);
+        // Retiring the groups returns what they charged
+        for (const auto &handle : handles)
+        {
+            subscriptionManager.unsubscribeFromAll(handle);
+        }
+        REQUIRE(memoryBudget.getBytes() == initialBytes);
+    }
 }
@@ -2,6 +2,7 @@
 #define TESTING_UTILITIES_HPP
 #include <bit>
 #include <vector>
+#include <memory>
 #include <chrono>
 #include <random>
 #include <algorithm>
@@ -218,6 +219,16 @@ bool comparePackets(const std::vector<UDataPacketServiceAPI::V1::Packet> &lhs,
     return true;
 }
 
+[[nodiscard]] [[maybe_unused]]
+bool comparePackets(const std::vector<std::shared_ptr<const UDataPacketServiceAPI::V1::Packet>> &lhs,
+                    const std::vector<UDataPacketServiceAPI::V1::Packet> &rhs,
+                    bool ordered = true)
+{
+    std::vector<UDataPacketServiceAPI::V1::Packet> lhsPackets;
+    lhsPackets.reserve(lhs.size());
+    for (const auto &packet : lhs){lhsPackets.push_back(*packet);}
+    return comparePackets(lhsPackets, rhs, ordered);
+}
 
 }
 #endif